@@ -2,7 +2,8 @@
  *
  * bst_comparisons.c
  *
- * Compare the performance of the different BST balancing algorithms (none/BST, AVL, RB).
+ * Compare the performance of the different BST balancing algorithms (none/BST, AVL, RB) and of
+ * the B-tree.
  *
  ************************************************************************************************/
 
@@ -10,6 +11,7 @@
 #include <time.h>
 
 #include "bst.h"
+#include "btree.h"
 #include "stats.h"
 #include "type_interface.h"
 #include "util.h"
@@ -76,6 +78,25 @@ void avl_ordered(void)
     bst_delete(T);
 }
 
+void btree_ordered(void)
+{
+    btree *T = btree_new(&int_type, NULL);
+    int v;
+    for (int i = 0; i < NMEMB; ++i) {
+        btree_insert(T, &i);
+    }
+
+    for (int i = 0; i < NGETS; ++i) {
+        v = rand() % MAXV;
+        btree_has(T, &v);
+    }
+
+    for (int i = 0; i < NMEMB; ++i) {
+        btree_remove(T, &i);
+    }
+    btree_delete(T);
+}
+
 void bst_random(void)
 {
     bst *T = bst_new(NONE, &int_type, NULL);
@@ -121,25 +142,44 @@ void avl_random(void)
     bst_delete(T);
 }
 
+void btree_random(void)
+{
+    btree *T = btree_new(&int_type, NULL);
+    int v;
+    for (int i = 0; i < NMEMB; ++i) {
+        v = rand() % MAXV;
+        btree_insert(T, &v);
+    }
+    for (int i = 0; i < NMEMB; ++i) {
+        v = rand() % MAXV;
+        btree_remove(T, &v);
+    }
+    btree_delete(T);
+}
+
 int main(void)
 {
-    stats s_bsto, s_bstr, s_rbo, s_rbr, s_avlo, s_avlr;
+    stats s_bsto, s_bstr, s_rbo, s_rbr, s_avlo, s_avlr, s_bto, s_btr;
 
     measure(bst_ordered, &s_bsto, NRUNS, 1.0);
     measure(rb_ordered,  &s_rbo,  NRUNS, 1.0);
     measure(avl_ordered, &s_avlo, NRUNS, 1.0);
+    measure(btree_ordered, &s_bto, NRUNS, 1.0);
     measure(bst_random,  &s_bstr, NRUNS, 1.0);
     measure(rb_random,   &s_rbr,  NRUNS, 1.0);
     measure(avl_random,  &s_avlr, NRUNS, 1.0);
+    measure(btree_random, &s_btr, NRUNS, 1.0);
 
     printf("%-15s  %10s  %10s  %10s\n", "test case", "avg", "min", "max");
     printf("---------------  ----------  ----------  ----------\n");
     printf("%-15s  %10f  %10f  %10f\n", "BST ordered",  s_bsto.avg, s_bsto.min, s_bsto.max);
     printf("%-15s  %10f  %10f  %10f\n", "RB  ordered",  s_rbo.avg,  s_rbo.min,  s_rbo.max);
     printf("%-15s  %10f  %10f  %10f\n", "AVL ordered",  s_avlo.avg, s_avlo.min, s_avlo.max);
+    printf("%-15s  %10f  %10f  %10f\n", "B-tree ordered", s_bto.avg, s_bto.min, s_bto.max);
     printf("%-15s  %10f  %10f  %10f\n", "BST random",   s_bstr.avg, s_bstr.min, s_bstr.max);
     printf("%-15s  %10f  %10f  %10f\n", "RB  random",   s_rbr.avg,  s_rbr.min,  s_rbr.max);
     printf("%-15s  %10f  %10f  %10f\n", "AVL random",   s_avlr.avg, s_avlr.min, s_avlr.max);
+    printf("%-15s  %10f  %10f  %10f\n", "B-tree random", s_btr.avg, s_btr.min, s_btr.max);
 
     return 0;
 }
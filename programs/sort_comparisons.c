@@ -14,6 +14,7 @@
 #include "check.h"
 #include "sort.h"
 #include "stats.h"
+#include "typed.h"
 
 #define NMEMB 10000
 #define MAXV 1000
@@ -23,8 +24,8 @@
     clock_t start, end; \
     double duration; \
     stats S; \
-    printf("%-12s  %10s  %10s  %10s\n", "algorithm", "avg", "min", "max"); \
-    printf("------------  ----------  ----------  ----------\n");
+    printf("%-14s  %10s  %10s  %10s\n", "algorithm", "avg", "min", "max"); \
+    printf("--------------  ----------  ----------  ----------\n");
 
 #define measure(nruns, f, A, ...) \
     stats_initialize(&S); \
@@ -41,7 +42,7 @@
         duration = (double)(end - start) / CLOCKS_PER_SEC; \
         stats_add(&S, duration); \
     } \
-    printf("%-12s  %10f  %10f  %10f\n", #f, S.avg, S.min, S.max);
+    printf("%-14s  %10f  %10f  %10f\n", #f, S.avg, S.min, S.max);
 
 
 static inline void make_random(int* A, size_t nmemb, unsigned maxv)
@@ -53,6 +54,8 @@ static inline void make_random(int* A, size_t nmemb, unsigned maxv)
 
 static inline int compint(const void *a, const void *b) { return *(int*)a - *(int*)b; }
 
+DSA_DEFINE_SORT(int_sort, int, DSA_LESS)
+
 int main()
 {
     init_comparisons();
@@ -62,8 +65,12 @@ int main()
 
     measure(NRUNS, qsort,     A, NMEMB, sizeof(*A), compint);
     measure(NRUNS, quicksort, A, NMEMB, sizeof(*A), compint);
+    measure(NRUNS, pdqsort,   A, NMEMB, sizeof(*A), compint);
     measure(NRUNS, mergesort, A, NMEMB, sizeof(*A), compint);
     measure(NRUNS, heapsort,  A, NMEMB, sizeof(*A), compint);
+    measure(NRUNS, int_sort,  A, NMEMB);
+    measure(NRUNS, quicksort_i32, A, NMEMB);
+    measure(NRUNS, radixsort_int, A, NMEMB);
 
     free(A);
     return 0;
@@ -0,0 +1,186 @@
+/*************************************************************************************************
+ *
+ * allocator.c
+ *
+ * Implementation of the malloc, arena and bump allocators declared in allocator.h.
+ *
+ ************************************************************************************************/
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "check.h"
+
+#define a_round_up(n) (((n) + ALLOCATOR_ALIGNMENT - 1) & ~(ALLOCATOR_ALIGNMENT - 1))
+
+/* The default allocator. */
+
+static void *malloc_allocate(allocator *A, size_t size)
+{
+    (void)A;
+    return malloc(size);
+}
+
+static void malloc_deallocate(allocator *A, void *p, size_t size)
+{
+    (void)A;
+    (void)size;
+    free(p);
+}
+
+allocator malloc_allocator = {
+    .allocate = malloc_allocate,
+    .deallocate = malloc_deallocate
+};
+
+void *a_allocate(allocator *A, size_t size)
+{
+    if (!A) A = &malloc_allocator;
+    void *p = A->allocate(A, size);
+    check(p != NULL || size == 0, "allocation of %lu bytes failed", size);
+    return p;
+error:
+    return NULL;
+}
+
+void *a_callocate(allocator *A, size_t size)
+{
+    void *p = a_allocate(A, size);
+    if (p) memset(p, 0, size);
+    return p;
+}
+
+void a_deallocate(allocator *A, void *p, size_t size)
+{
+    if (!A) A = &malloc_allocator;
+    if (p) A->deallocate(A, p, size);
+}
+
+/* The arena allocator. Chunks are taken from malloc. Requests that don't fit into a fresh chunk
+ * get a dedicated chunk of their own. */
+
+#define arena_chunk_header_size a_round_up(sizeof(arena_chunk))
+
+static void *arena_allocate(allocator *base, size_t size)
+{
+    arena *A = (arena *)base;
+    size = a_round_up(size);
+
+    if ((size_t)(A->end - A->next) < size) {
+        size_t chunk_size = size > A->chunk_size ? size : A->chunk_size;
+        arena_chunk *c = malloc(arena_chunk_header_size + chunk_size);
+        check_alloc(c);
+        c->next = A->chunks;
+        A->chunks = c;
+        A->next = (char*)c + arena_chunk_header_size;
+        A->end = A->next + chunk_size;
+    }
+
+    void *p = A->next;
+    A->next += size;
+    return p;
+error:
+    return NULL;
+}
+
+static void arena_deallocate(allocator *base, void *p, size_t size)
+{
+    (void)base;
+    (void)p;
+    (void)size;
+}
+
+/* int  arena_initialize(arena *A, size_t chunk_size)
+ * void arena_clear     (arena *A)
+ * void arena_destroy   (arena *A)
+ * arena_initialize sets up an empty arena that requests memory in chunks of chunk_size bytes (or
+ * ARENA_DEFAULT_CHUNK_SIZE if chunk_size is 0). arena_clear releases all memory handed out by A
+ * at once; A can be used again afterwards. arena_destroy does the same and resets A. */
+int arena_initialize(arena *A, size_t chunk_size)
+{
+    check_ptr(A);
+
+    A->base.allocate = arena_allocate;
+    A->base.deallocate = arena_deallocate;
+    A->chunks = NULL;
+    A->next = A->end = NULL;
+    A->chunk_size = chunk_size ? a_round_up(chunk_size) : ARENA_DEFAULT_CHUNK_SIZE;
+
+    return 0;
+error:
+    return -1;
+}
+
+void arena_clear(arena *A)
+{
+    if (A) {
+        arena_chunk *c = A->chunks;
+        arena_chunk *next;
+        while (c) {
+            next = c->next;
+            free(c);
+            c = next;
+        }
+        A->chunks = NULL;
+        A->next = A->end = NULL;
+    }
+}
+
+void arena_destroy(arena *A)
+{
+    if (A) {
+        arena_clear(A);
+        A->chunk_size = 0;
+    }
+}
+
+/* The bump allocator. */
+
+static void *bump_allocate(allocator *base, size_t size)
+{
+    bump *B = (bump *)base;
+    size = a_round_up(size);
+    if (B->size - B->used < size) return NULL;
+
+    void *p = B->buffer + B->used;
+    B->used += size;
+    return p;
+}
+
+static void bump_deallocate(allocator *base, void *p, size_t size)
+{
+    bump *B = (bump *)base;
+    size = a_round_up(size);
+    if ((char*)p + size == B->buffer + B->used) B->used -= size;
+}
+
+/* int  bump_initialize(bump *B, void *buffer, size_t size)
+ * void bump_reset     (bump *B)
+ * bump_initialize sets up a bump allocator on the given buffer of size bytes, which must stay
+ * valid as long as B is used. The start and the end of the usable part of the buffer are aligned
+ * to ALLOCATOR_ALIGNMENT if necessary. bump_reset releases everything handed out by B at once. */
+int bump_initialize(bump *B, void *buffer, size_t size)
+{
+    check_ptr(B);
+    check_ptr(buffer);
+
+    size_t skip = a_round_up((uintptr_t)buffer) - (uintptr_t)buffer;
+    check(size >= skip, "buffer too small");
+
+    B->base.allocate = bump_allocate;
+    B->base.deallocate = bump_deallocate;
+    B->buffer = (char*)buffer + skip;
+    B->size = (size - skip) & ~(ALLOCATOR_ALIGNMENT - 1);
+    B->used = 0;
+
+    return 0;
+error:
+    return -1;
+}
+
+void bump_reset(bump *B)
+{
+    if (B) B->used = 0;
+}
@@ -0,0 +1,73 @@
+/*************************************************************************************************
+ *
+ * allocator.h
+ *
+ * Pluggable memory allocators. An allocator is a struct with function pointers for allocation and
+ * deallocation; the containers in the library take an optional allocator at initialization
+ * (*_initialize_with) and get all their memory from it. Concrete allocators embed the allocator
+ * struct as their first member, so a pointer to one can be passed wherever an allocator is
+ * expected. Three allocators are provided:
+ *
+ *   malloc_allocator   the default, forwards to malloc/free
+ *   arena              carves allocations from large chunks, frees nothing until arena_clear
+ *   bump               carves allocations from a fixed caller-provided buffer
+ *
+ ************************************************************************************************/
+
+#ifndef _allocator_h
+#define _allocator_h
+
+#include <stdlib.h>
+
+#define ALLOCATOR_ALIGNMENT         16lu
+#define ARENA_DEFAULT_CHUNK_SIZE    65536lu
+
+struct allocator;
+typedef struct allocator {
+    void *  (*allocate)     (struct allocator *A, size_t size);
+    void    (*deallocate)   (struct allocator *A, void *p, size_t size);
+} allocator;
+
+extern allocator malloc_allocator;
+
+/* Allocate/release memory from A, or from malloc_allocator if A is NULL. a_callocate returns
+ * zeroed memory. The size passed to a_deallocate must be the size that was requested. */
+void *  a_allocate      (allocator *A, size_t size);
+void *  a_callocate     (allocator *A, size_t size);
+void    a_deallocate    (allocator *A, void *p, size_t size);
+
+/* Arena allocator: individual deallocations are no-ops, everything is released at once. */
+struct arena_chunk;
+typedef struct arena_chunk {
+    struct arena_chunk *    next;
+} arena_chunk;
+
+typedef struct arena {
+    allocator       base;
+    arena_chunk *   chunks;
+    char *          next;
+    char *          end;
+    size_t          chunk_size;
+} arena;
+
+#define arena_allocator(A) (&(A)->base)
+
+int     arena_initialize    (arena *A, size_t chunk_size);
+void    arena_clear         (arena *A);
+void    arena_destroy       (arena *A);
+
+/* Bump allocator on a fixed buffer: fails when the buffer is exhausted. Only the most recent
+ * allocation can be released individually, everything else is released by bump_reset. */
+typedef struct bump {
+    allocator       base;
+    char *          buffer;
+    size_t          size;
+    size_t          used;
+} bump;
+
+#define bump_allocator(B) (&(B)->base)
+
+int     bump_initialize     (bump *B, void *buffer, size_t size);
+void    bump_reset          (bump *B);
+
+#endif /* _allocator_h */
@@ -21,7 +21,8 @@
 /* void avl_n_rotate_right(bst_n **np, short *dhp)
  * void avl_n_rotate_left (bst_n **np, short *dhp)
  * Normal tree rotations with updates to AVL balance factors. A change of height is reported at
- * dhp. The pointer at np is updated to hold the new root of the rotated subtree. */
+ * dhp. The pointer at np is updated to hold the new root of the rotated subtree, which takes
+ * over the subtree size of the old root. */
 void avl_n_rotate_right(bst_n **np, short *dhp)
 {
     bst_n *n = *np;
@@ -34,6 +35,8 @@ void avl_n_rotate_right(bst_n **np, short *dhp)
 
     n->left = p->right;
     p->right = n;
+    p->count = n->count;
+    bst_n_update_count(n);
 
     n->flags.avl.balance = bp > 0 ? bn + 1 : bn - bp + 1;
     p->flags.avl.balance = n->flags.avl.balance > 0 ? bn + 2 : bp + 1;
@@ -54,6 +57,8 @@ void avl_n_rotate_left(bst_n **np, short *dhp)
 
     n->right = p->left;
     p->left = n;
+    p->count = n->count;
+    bst_n_update_count(n);
 
     n->flags.avl.balance = bp < 0 ? bn - 1 : bn - bp - 1;
     p->flags.avl.balance = n->flags.avl.balance < 0 ? bn - 2 : bp - 1;
@@ -136,6 +141,7 @@ int avl_n_insert(
             rc = 0;
         }
 
+        if (rc == 1) ++n->count;
         if (dhc) avl_n_repair(&n, &dhr);
     }
 
@@ -170,6 +176,7 @@ int avl_n_remove_min(bst *T, bst_n **np, short *dhp)
         int rc = avl_n_remove_min(T, &n->left, &dhc);
         if (avl_n_balance(n) < 0) dh += dhc;
         n->flags.avl.balance -= dhc;
+        --n->count;
 
         if (dhc) avl_n_repair(&n, &dhr);
         if (dhp) *dhp = dh + dhr;
@@ -200,11 +207,13 @@ int avl_n_remove(bst *T, bst_n **np, const void *k, short *dhp)
         rc = avl_n_remove(T, &n->left, k, &dhc);
         if (avl_n_balance(n) < 0) dh += dhc;
         n->flags.avl.balance -= dhc;
+        if (rc == 1) --n->count;
 
     } else if (cmp > 0) {
         rc = avl_n_remove(T, &n->right, k, &dhc);
         if (avl_n_balance(n) > 0) dh += dhc;
         n->flags.avl.balance += dhc;
+        if (rc == 1) --n->count;
 
     } else { /* cmp == 0 */
         if (n->left && n->right) {
@@ -216,6 +225,7 @@ int avl_n_remove(bst *T, bst_n **np, const void *k, short *dhp)
             rc = avl_n_remove_min(T, &n->right, &dhc);
             if (avl_n_balance(n) > 0) dh += dhc;
             n->flags.avl.balance += dhc;
+            --n->count;
 
         } else {
             /* use np to temporarily store the successor */
@@ -39,23 +39,23 @@
 #include "bst.h"
 #include "log.h"
 
-/* bst_n *bst_n_new(const bst *T, const void *k, const void *v)
- * Create a new node with the key k and the value v (if given) on the heap and return a pointer to
- * it, or NULL on error. Enough memory is requested to store the node header, one key, and zero or
- * one value objects according to the type interfaces stored in T.
- * Note that new RB nodes are always red and RED = 0, so as long as we're using `calloc` to
- * allocate the node, there's no need to explicitly set the color. */
-bst_n *bst_n_new(const bst *T, const void *k, const void *v)
+/* bst_n *bst_n_new(bst *T, const void *k, const void *v)
+ * Create a new node with the key k and the value v (if given) in the node pool of T and return a
+ * pointer to it, or NULL on error. The pool hands out slots large enough to store the node header,
+ * one key, and zero or one value objects according to the type interfaces stored in T.
+ * Note that new RB nodes are always red and RED = 0, so as long as pool_alloc returns zeroed
+ * memory, there's no need to explicitly set the color. The node is a subtree of size 1. */
+bst_n *bst_n_new(bst *T, const void *k, const void *v)
 {
     assert(T && T->key_type && k);
     assert(!v || T->value_type);
 
-    size_t size = bst_n_size(T);
-    bst_n *n = calloc(1, size);
-    check_alloc(n);
+    bst_n *n = pool_alloc(&T->node_pool);
+    check(n != NULL, "failed to allocate node");
 
     t_copy(T->key_type, bst_n_key(T, n), k);
     n->flags.plain.has_key = 1;
+    n->count = 1;
     if (v) {
         t_copy(T->value_type, bst_n_value(T, n), v);
         n->flags.plain.has_value = 1;
@@ -66,12 +66,15 @@ error:
     return NULL;
 }
 
-/* void bst_n_delete    (const bst *T, bst_n *n)
- * void bst_n_delete_rec(const bst *T, bst_n *n)
- * Delete n, destroying stored data and freeing associated memory. No links are altered in
+/* void bst_n_delete     (      bst *T, bst_n *n)
+ * void bst_n_delete_rec (      bst *T, bst_n *n)
+ * void bst_n_destroy_rec(const bst *T, bst_n *n)
+ * Delete n, destroying stored data and returning the node to the pool. No links are altered in
  * adjacent nodes, so don't call bst_n_delete on a node with children lest they become unreachable
- * in the void... use bst_n_delete_rec[ursively] to wipe out the whole subtree. */
-void bst_n_delete(const bst *T, bst_n *n)
+ * in the void... use bst_n_delete_rec[ursively] to wipe out the whole subtree.
+ * bst_n_destroy_rec only destroys the data stored in the subtree and leaves the nodes to be
+ * released in bulk with the pool. */
+void bst_n_delete(bst *T, bst_n *n)
 {
     log_call("T=%p, n=%p", T, n);
     assert(T && T->key_type && n);
@@ -83,10 +86,10 @@ void bst_n_delete(const bst *T, bst_n *n)
         assert(T->value_type);
         t_destroy(T->value_type, bst_n_value(T, n));
     }
-    free(n);
+    pool_free(&T->node_pool, n);
 }
 
-void bst_n_delete_rec(const bst *T, bst_n *n)
+void bst_n_delete_rec(bst *T, bst_n *n)
 {
     log_call("T=%p, n=%p", T, n);
     assert(T && n);
@@ -95,6 +98,15 @@ void bst_n_delete_rec(const bst *T, bst_n *n)
     bst_n_delete(T, n);
 }
 
+void bst_n_destroy_rec(const bst *T, bst_n *n)
+{
+    assert(T && n);
+    if (n->left) bst_n_destroy_rec(T, n->left);
+    if (n->right) bst_n_destroy_rec(T, n->right);
+    if (bst_n_has_key(n)) t_destroy(T->key_type, bst_n_key(T, n));
+    if (bst_n_has_value(n)) t_destroy(T->value_type, bst_n_value(T, n));
+}
+
 /* bst_n *bst_n_find(const bst *T, const bst_n *n, const void *k)
  * Return the descendant node of n with the key k if present or NULL. */
 bst_n *bst_n_find(const bst *T, bst_n *n, const void *k)
@@ -131,16 +143,19 @@ int bst_n_insert(bst *T, bst_n **np, const void *k, const void *v)
     }
 
     int cmp = t_compare(T->key_type, k, bst_n_key(T, n));
+    int rc;
 
     if (cmp < 0) {
-        return bst_n_insert(T, &n->left, k, v);
+        rc = bst_n_insert(T, &n->left, k, v);
     } else if (cmp > 0) {
-        return bst_n_insert(T, &n->right, k, v);
+        rc = bst_n_insert(T, &n->right, k, v);
     } else { /* cmp == 0 */
         if (v) bst_n_set_value(T, n, v);
         return 0;
     }
 
+    if (rc == 1) ++n->count;
+    return rc;
 error:
     return -1;
 }
@@ -162,6 +177,7 @@ int bst_n_remove_min(bst *T, bst_n **np)
         rc = 1;
     } else {
         rc = bst_n_remove_min(T, &n->left);
+        --n->count;
     }
 
     return rc;
@@ -205,9 +221,10 @@ int bst_n_remove(
     if (!n) return 0;
 
     int cmp = t_compare(T->key_type, k, bst_n_key(T, n));
+    int rc;
 
-    if      (cmp < 0) { return bst_n_remove(T, &n->left,  k); }
-    else if (cmp > 0) { return bst_n_remove(T, &n->right, k); }
+    if      (cmp < 0) { rc = bst_n_remove(T, &n->left,  k); }
+    else if (cmp > 0) { rc = bst_n_remove(T, &n->right, k); }
     else { /* cmp == 0 */
         if (n->left && n->right) {
             /* Find the node with the minimum key in the right subtree, which is guaranteed to not
@@ -215,7 +232,7 @@ int bst_n_remove(
             bst_n *s = n->right;
             while (s->left) s = s->left;
             bst_n_move_data(T, n, s);
-            return bst_n_remove_min(T, &n->right);
+            rc = bst_n_remove_min(T, &n->right);
 
         } else {
             if      (n->left)   *np = n->left;
@@ -226,6 +243,9 @@ int bst_n_remove(
             return 1;
         }
     }
+
+    if (rc == 1) --n->count;
+    return rc;
 }
 
 /* void bst_n_set_key  (const bst *T, bst_n *n, const void *k)
@@ -269,10 +289,10 @@ void bst_n_destroy_value(const bst *T, bst_n *n)
     n->flags.plain.has_value = 0;
 }
 
-/* bst_n *bst_n_copy_rec(const bst *T, const bst_n *n)
+/* bst_n *bst_n_copy_rec(bst *T, const bst_n *n)
  * Recursively copy the (sub)tree rooted at n, including all stored data. The new tree has the
  * exact same layout. */
-bst_n *bst_n_copy_rec(const bst *T, const bst_n *n)
+bst_n *bst_n_copy_rec(bst *T, const bst_n *n)
 {
     log_call("T=%p, n=%p", T, n);
     assert(T && T->key_type && n && (!bst_n_has_value(n) || T->value_type));
@@ -290,6 +310,7 @@ bst_n *bst_n_copy_rec(const bst *T, const bst_n *n)
 
     /* copy the complete flags byte */
     memcpy(&c->flags, &n->flags, sizeof(struct bst_n_flags));
+    c->count = n->count;
 
     return c;
 error:
@@ -297,19 +318,27 @@ error:
     return NULL;
 }
 
-/* int  bst_initialize(bst *T, uint8_t flavor, t_intf *kt, t_intf *vt)
- * bst *bst_new       (        uint8_t flavor, t_intf *kt, t_intf *vt)
+/* int  bst_initialize     (bst *T, uint8_t flavor, t_intf *kt, t_intf *vt)
+ * int  bst_initialize_with(bst *T, uint8_t flavor, t_intf *kt, t_intf *vt, allocator *A)
+ * bst *bst_new            (        uint8_t flavor, t_intf *kt, t_intf *vt)
  * bst_initialize initializes a bst at the address pointed to by T (assuming there's sufficient
  * space). bst_new allocates and initializes a new bst and returns a pointer to it. The type
  * interface for keys is required and must contain a at least a size and a comparison function.
- * The type interface for values can be NULL if the tree is going to store single elements. */
-int bst_initialize(
+ * The type interface for values can be NULL if the tree is going to store single elements.
+ * bst_initialize_with takes the nodes from the allocator A instead of malloc. */
+int bst_initialize(bst *T, uint8_t flavor, t_intf *kt, t_intf *vt)
+{
+    return bst_initialize_with(T, flavor, kt, vt, NULL);
+}
+
+int bst_initialize_with(
         bst *T,             /* address of the bst to initialize */
         uint8_t flavor,     /* balancing strategy, one of NONE, RB, and AVL */
         t_intf *kt,         /* type interface for keys */
-        t_intf *vt)         /* type interface for values, can be NULL */
+        t_intf *vt,         /* type interface for values, can be NULL */
+        allocator *A)       /* where nodes come from, NULL for malloc */
 {
-    log_call("T=%p, flavor=%u, kt=%p, vt=%p", T, flavor, kt, vt);
+    log_call("T=%p, flavor=%u, kt=%p, vt=%p, A=%p", T, flavor, kt, vt, A);
 
     check_ptr(T);
     check(flavor <= 2, "bad flavor %u", flavor);
@@ -324,6 +353,9 @@ int bst_initialize(
     T->key_type = kt;
     T->value_type = vt;
 
+    int rc = pool_initialize(&T->node_pool, bst_n_size(T), A);
+    check_rc(rc, "pool_initialize");
+
     assert(bst_invariant(T, NULL) == 0);
     return 0;
 error:
@@ -347,13 +379,17 @@ error:
 }
 
 /* void bst_clear(bst *T)
- * Delete all nodes, freeing associated memory, and reset T. */
+ * Delete all nodes, freeing associated memory, and reset T. Stored data is destroyed node by node
+ * only if the type interfaces have destructors; the nodes are released in bulk with the pool. */
 void bst_clear(bst *T)
 {
     log_call("T=%p", T);
     if (T) {
         assert(bst_invariant(T, NULL) == 0);
-        if (T->root) bst_n_delete_rec(T, T->root);
+        if (T->root && (T->key_type->destroy || (T->value_type && T->value_type->destroy))) {
+            bst_n_destroy_rec(T, T->root);
+        }
+        pool_clear(&T->node_pool);
         T->root = NULL;
         T->count = 0;
     }
@@ -366,8 +402,8 @@ void bst_destroy(bst *T)
 {
     log_call("T=%p", T);
     if (T) {
-        assert(bst_invariant(T, NULL) == 0);
-        if (T->root) bst_n_delete_rec(T, T->root);
+        bst_clear(T);
+        pool_destroy(&T->node_pool);
         memset(T, 0, sizeof(*T));
     }
 }
@@ -376,8 +412,8 @@ void bst_delete(bst *T)
 {
     log_call("T=%p", T);
     if (T) {
-        assert(bst_invariant(T, NULL) == 0);
-        if (T->root) bst_n_delete_rec(T, T->root);
+        bst_clear(T);
+        pool_destroy(&T->node_pool);
         free(T);
     }
 }
@@ -385,7 +421,8 @@ void bst_delete(bst *T)
 /* bst *bst_copy   (           const bst *src)
  * int  bst_copy_to(bst *dest, const bst *src)
  * Copy a BST, duplicating all content and preserving the exact same layout. bst_copy makes the
- * copy on the heap, bst_copy_to creates it where dest points to. */
+ * copy on the heap, bst_copy_to creates it where dest points to. The copy takes its nodes from
+ * the same allocator as src. */
 
 bst *bst_copy(const bst *src)
 {
@@ -394,15 +431,15 @@ bst *bst_copy(const bst *src)
     check_ptr(src);
     assert(bst_invariant(src, NULL) == 0);
 
-    dest = bst_new(src->flavor, src->key_type, src->value_type);
-    check(dest != NULL, "failed to create new tree");
+    dest = calloc(1, sizeof(*dest));
+    check_alloc(dest);
 
-    if (src->root) dest->root = bst_n_copy_rec(dest, src->root);
-    dest->count = src->count;
+    int rc = bst_copy_to(dest, src);
+    check_rc(rc, "bst_copy_to");
 
     return dest;
 error:
-    if (dest) bst_delete(dest);
+    if (dest) free(dest);
     return NULL;
 }
 
@@ -413,8 +450,9 @@ int bst_copy_to(bst *dest, const bst *src)
     check_ptr(src);
     assert(bst_invariant(src, NULL) == 0);
 
-    int rc = bst_initialize(dest, src->flavor, src->key_type, src->value_type);
-    check_rc(rc, "bst_initialize");
+    int rc = bst_initialize_with(dest, src->flavor, src->key_type, src->value_type,
+                                 src->node_pool.alloc);
+    check_rc(rc, "bst_initialize_with");
 
     if (src->root) dest->root = bst_n_copy_rec(dest, src->root);
     dest->count = src->count;
@@ -566,6 +604,77 @@ error: /* fallthrough */
     return NULL;
 }
 
+/* void *bst_select(const bst *T, size_t k)
+ * Return a pointer to the k-th smallest key in T, counting from 0, or NULL if k >= bst_count(T).
+ * Every node knows the size of its subtree, so this takes O(log n) time in a balanced tree. */
+void *bst_select(const bst *T, size_t k)
+{
+    check_ptr(T);
+
+    bst_n *n = T->root;
+    while (n) {
+        size_t l = bst_n_count(n->left);
+        if (k < l) {
+            n = n->left;
+        } else if (k > l) {
+            k -= l + 1;
+            n = n->right;
+        } else {
+            return bst_n_key(T, n);
+        }
+    }
+
+error: /* fallthrough */
+    return NULL;
+}
+
+/* The number of keys in T that are less than k. */
+static size_t bst_n_rank(const bst *T, const void *k)
+{
+    size_t rank = 0;
+    bst_n *n = T->root;
+    while (n) {
+        int cmp = t_compare(T->key_type, k, bst_n_key(T, n));
+        if (cmp < 0) {
+            n = n->left;
+        } else if (cmp > 0) {
+            rank += bst_n_count(n->left) + 1;
+            n = n->right;
+        } else {
+            return rank + bst_n_count(n->left);
+        }
+    }
+    return rank;
+}
+
+/* size_t bst_rank(const bst *T, const void *k)
+ * Return the number of keys in T that are less than k, which is the index of k in the sorted
+ * keys if it's present. O(log n) in a balanced tree. */
+size_t bst_rank(const bst *T, const void *k)
+{
+    check_ptr(T);
+    check_ptr(k);
+    return bst_n_rank(T, k);
+error:
+    return 0;
+}
+
+/* size_t bst_count_range(const bst *T, const void *lo, const void *hi)
+ * Return the number of keys k in T with lo <= k < hi, the same range that bst_traverse_range
+ * visits. If lo or hi is NULL, the range is unbounded on that side. O(log n) in a balanced
+ * tree. */
+size_t bst_count_range(const bst *T, const void *lo, const void *hi)
+{
+    check_ptr(T);
+
+    if (lo && hi && t_compare(T->key_type, lo, hi) >= 0) return 0;
+    size_t above = hi ? bst_n_rank(T, hi) : bst_count(T);
+    size_t below = lo ? bst_n_rank(T, lo) : 0;
+    return above - below;
+error:
+    return 0;
+}
+
 /* int bst_n_traverse             (        bst_n *n, int (*f)(bst_n *n, void *p), void *p)
  * int bst_n_traverse_r           (        bst_n *n, int (*f)(bst_n *n, void *p), void *p)
  * int bst_n_traverse_keys        (bst *T, bst_n *n, int (*f)(void *k, void *p), void *p)
@@ -763,6 +872,59 @@ error:
     return -1;
 }
 
+/* Walk through the keys (or values) in the subtree with the root n that lie in [lo, hi[ in
+ * ascending order. Subtrees that are entirely out of range aren't entered. */
+static int bst_n_traverse_range(bst *T, bst_n *n, const void *lo, const void *hi, int values,
+                                int (*f)(void *e, void *p), void *p)
+{
+    int rc;
+    while (n) {
+        int above_lo = !lo || t_compare(T->key_type, bst_n_key(T, n), lo) >= 0;
+        int below_hi = !hi || t_compare(T->key_type, bst_n_key(T, n), hi) < 0;
+
+        if (above_lo) {
+            rc = bst_n_traverse_range(T, n->left, lo, hi, values, f, p);
+            if (rc != 0) return rc;
+            if (below_hi) {
+                rc = f(values ? bst_n_value(T, n) : bst_n_key(T, n), p);
+                if (rc != 0) return rc;
+            }
+        }
+        if (!below_hi) break;
+        n = n->right;
+    }
+    return 0;
+}
+
+/* int bst_traverse_range       (bst *T, const void *lo, const void *hi,
+ *                               int (*f)(void *k, void *p), void *p)
+ * int bst_traverse_range_values(bst *T, const void *lo, const void *hi,
+ *                               int (*f)(void *v, void *p), void *p)
+ * Walk through the keys k with lo <= k < hi in ascending order and call f on every key or its
+ * value with the additional parameter p. If lo or hi is NULL, the range is unbounded on that
+ * side. If f returns a non-zero integer, abort and return it. This visits O(log n + m) nodes of
+ * a balanced tree, where m is the number of keys in the range. */
+int bst_traverse_range(bst *T, const void *lo, const void *hi,
+                       int (*f)(void *k, void *p), void *p)
+{
+    check_ptr(T);
+    check_ptr(f);
+    return bst_n_traverse_range(T, T->root, lo, hi, 0, f, p);
+error:
+    return -1;
+}
+
+int bst_traverse_range_values(bst *T, const void *lo, const void *hi,
+                              int (*f)(void *v, void *p), void *p)
+{
+    check_ptr(T);
+    check_ptr(f);
+    check(T->value_type, "the tree doesn't store values");
+    return bst_n_traverse_range(T, T->root, lo, hi, 1, f, p);
+error:
+    return -1;
+}
+
 /* size_t bst_n_height(const bst_n *n)
  * Get the height of the subtree with the root n, O(n)! */
 size_t bst_n_height(const bst_n *n)
@@ -805,6 +967,205 @@ int bst_n_invariant(const bst *T, const bst_n *n, int depth, struct bst_stats *s
     return 0;
 }
 
+/* Find the node with the smallest key greater than k (or the greatest key less than k if greater
+ * is 0), or with the key k if inclusive is set. */
+static bst_n *bst_n_bound(const bst *T, const void *k, int greater, int inclusive)
+{
+    bst_n *n = T->root, *best = NULL;
+    while (n) {
+        int cmp = t_compare(T->key_type, k, bst_n_key(T, n));
+        if (cmp == 0 && inclusive) return n;
+        if (greater ? cmp < 0 : cmp > 0) {
+            best = n;
+            n = greater ? n->left : n->right;
+        } else {
+            n = greater ? n->right : n->left;
+        }
+    }
+    return best;
+}
+
+/* void *bst_lower_bound(const bst *T, const void *k)
+ * void *bst_upper_bound(const bst *T, const void *k)
+ * void *bst_floor      (const bst *T, const void *k)
+ * void *bst_ceiling    (const bst *T, const void *k)
+ * Return a pointer to the smallest key that is not less than k (lower_bound), the smallest key
+ * that is greater than k (upper_bound), the greatest key that is not greater than k (floor), or
+ * the smallest key that is not less than k (ceiling, the same as lower_bound). Return NULL if
+ * there is no such key. All of them take O(log n) time in a balanced tree. */
+void *bst_lower_bound(const bst *T, const void *k)
+{
+    check_ptr(T);
+    check_ptr(k);
+    bst_n *n = bst_n_bound(T, k, 1, 1);
+    return n ? bst_n_key(T, n) : NULL;
+error:
+    return NULL;
+}
+
+void *bst_upper_bound(const bst *T, const void *k)
+{
+    check_ptr(T);
+    check_ptr(k);
+    bst_n *n = bst_n_bound(T, k, 1, 0);
+    return n ? bst_n_key(T, n) : NULL;
+error:
+    return NULL;
+}
+
+void *bst_floor(const bst *T, const void *k)
+{
+    check_ptr(T);
+    check_ptr(k);
+    bst_n *n = bst_n_bound(T, k, 0, 1);
+    return n ? bst_n_key(T, n) : NULL;
+error:
+    return NULL;
+}
+
+void *bst_ceiling(const bst *T, const void *k)
+{
+    return bst_lower_bound(T, k);
+}
+
+/* Append n to the path of it and continue to the leftmost (rightmost) node of its subtree. */
+static void bst_iter_descend(bst_iter *it, bst_n *n, int left)
+{
+    while (n) {
+        if (it->depth == BST_ITER_MAX_DEPTH) it->deep = 1;
+        if (!it->deep) it->path[it->depth++] = n;
+        it->node = n;
+        n = left ? n->left : n->right;
+    }
+}
+
+static void bst_iter_reset(bst_iter *it, const bst *T)
+{
+    it->T = T;
+    it->node = NULL;
+    it->depth = 0;
+    it->deep = 0;
+}
+
+/* void *bst_iter_first(bst_iter *it, const bst *T)
+ * void *bst_iter_last (bst_iter *it, const bst *T)
+ * void *bst_iter_seek (bst_iter *it, const bst *T, const void *k)
+ * Position it on the smallest key in T, the greatest key, or the smallest key that
+ * is not less than k (see bst_lower_bound). Return a pointer to the key, or NULL if there is no
+ * such key. bst_iter_value gives the value of the current key. */
+void *bst_iter_first(bst_iter *it, const bst *T)
+{
+    check_ptr(it);
+    check_ptr(T);
+    bst_iter_reset(it, T);
+    bst_iter_descend(it, T->root, 1);
+    return bst_iter_key(it);
+error:
+    return NULL;
+}
+
+void *bst_iter_last(bst_iter *it, const bst *T)
+{
+    check_ptr(it);
+    check_ptr(T);
+    bst_iter_reset(it, T);
+    bst_iter_descend(it, T->root, 0);
+    return bst_iter_key(it);
+error:
+    return NULL;
+}
+
+void *bst_iter_seek(bst_iter *it, const bst *T, const void *k)
+{
+    check_ptr(it);
+    check_ptr(T);
+    check_ptr(k);
+    bst_iter_reset(it, T);
+
+    /* Walk down like bst_lower_bound and remember the path to the best candidate. */
+    size_t depth = 0, best_depth = 0;
+    bst_n *n = T->root;
+    while (n) {
+        if (depth < BST_ITER_MAX_DEPTH) it->path[depth] = n;
+        ++depth;
+        int cmp = t_compare(T->key_type, k, bst_n_key(T, n));
+        if (cmp <= 0) {
+            it->node = n;
+            best_depth = depth;
+            if (cmp == 0) break;
+            n = n->left;
+        } else {
+            n = n->right;
+        }
+    }
+
+    if (best_depth > BST_ITER_MAX_DEPTH) it->deep = 1;
+    else it->depth = best_depth;
+    return bst_iter_key(it);
+error:
+    return NULL;
+}
+
+/* Move it to the next node in ascending order (or descending order if forward is 0). */
+static void bst_iter_step(bst_iter *it, int forward)
+{
+    bst_n *n = it->node;
+
+    if (it->deep) {
+        it->node = bst_n_bound(it->T, bst_n_key(it->T, n), forward, 0);
+        return;
+    }
+
+    bst_n *next = forward ? n->right : n->left;
+    if (next) {
+        bst_iter_descend(it, next, forward);
+        return;
+    }
+
+    /* Go up until we leave a left (right) subtree; its root comes next. */
+    bst_n *c = it->path[--it->depth];
+    while (it->depth > 0 && (forward ? it->path[it->depth - 1]->right
+                                     : it->path[it->depth - 1]->left) == c) {
+        c = it->path[--it->depth];
+    }
+    it->node = it->depth > 0 ? it->path[it->depth - 1] : NULL;
+}
+
+/* void *bst_iter_next(bst_iter *it)
+ * void *bst_iter_prev(bst_iter *it)
+ * Advance the iterator to the next greater (smaller) key and return a pointer to it, or NULL if
+ * there is none, after which the iterator stays at the end. This takes O(1) amortized time and
+ * allocates nothing. */
+void *bst_iter_next(bst_iter *it)
+{
+    check_ptr(it);
+    if (it->node) bst_iter_step(it, 1);
+    return bst_iter_key(it);
+error:
+    return NULL;
+}
+
+void *bst_iter_prev(bst_iter *it)
+{
+    check_ptr(it);
+    if (it->node) bst_iter_step(it, 0);
+    return bst_iter_key(it);
+error:
+    return NULL;
+}
+
+/* Check the subtree sizes stored in the subtree with the root n. */
+static int bst_n_count_invariant(const bst_n *n)
+{
+    if (!n) return 0;
+    if (bst_n_count_invariant(n->left) != 0 || bst_n_count_invariant(n->right) != 0) return -1;
+    if (n->count != 1 + bst_n_count(n->left) + bst_n_count(n->right)) {
+        log_error("BST invariant violated: wrong subtree size %u", n->count);
+        return -1;
+    }
+    return 0;
+}
+
 /* int bst_invariant(const bst *T, struct bst_stats *s_out)
  * Check if all pertinent invariants hold for the tree. If s_out is not NULL, save stats of the
  * tree there for further inspection. */
@@ -829,6 +1190,7 @@ int bst_invariant(const bst *T, struct bst_stats *s_out)
 
     check((int)T->count == s.total_nodes,
             "count (%u) and actual number of nodes (%d) differ", T->count, s.total_nodes);
+    if (rc == 0) rc = bst_n_count_invariant(T->root);
 
     if (s_out) memcpy(s_out, &s, sizeof(s));
     return rc;
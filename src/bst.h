@@ -16,6 +16,7 @@
 #define _bst_h
 
 #include <stdint.h>
+#include "pool.h"
 #include "type_interface.h"
 
 enum bst_flavors { NONE = 0, RB = 1, AVL = 2 };
@@ -46,6 +47,7 @@ typedef struct bst_n {
         struct rb_n_flags    rb;
         struct avl_n_flags   avl;
     } flags;
+    uint32_t    count;      /* the number of nodes in the subtree, fits into the padding */
 } bst_n;
 
 typedef struct bst {
@@ -54,8 +56,23 @@ typedef struct bst {
     uint8_t     flavor;
     t_intf *    key_type;
     t_intf *    value_type;
+    pool        node_pool;
 } bst;
 
+/* An iterator over the nodes of a tree in order. It stores the path from the root to the current
+ * node, which is enough for any balanced tree with 2^32 nodes. In deeper (unbalanced) trees it
+ * falls back to searching for the neighbors of the current key from the root. Any insertion or
+ * removal invalidates the iterators on a tree. */
+#define BST_ITER_MAX_DEPTH 64
+
+typedef struct bst_iter {
+    const bst * T;
+    bst_n *     node;       /* the current node, NULL once the iterator has run off an end */
+    unsigned    depth;      /* the length of the path to node */
+    unsigned    deep;       /* set if the path didn't fit */
+    bst_n *     path[BST_ITER_MAX_DEPTH];
+} bst_iter;
+
 struct bst_stats {
     int height;
     int shortest_path;
@@ -68,6 +85,7 @@ struct bst_stats {
 /* public interface */
 
 int     bst_initialize          (bst *T, uint8_t flavor, t_intf *kt, t_intf *vt);
+int     bst_initialize_with     (bst *T, uint8_t flavor, t_intf *kt, t_intf *vt, allocator *A);
 bst *   bst_new                 (        uint8_t flavor, t_intf *kt, t_intf *vt);
 void    bst_destroy             (bst *T);
 void    bst_delete              (bst *T);
@@ -86,9 +104,31 @@ int     bst_traverse_keys       (bst *T, int (*f)(void *k, void *p), void *p);
 int     bst_traverse_keys_r     (bst *T, int (*f)(void *k, void *p), void *p);
 int     bst_traverse_values     (bst *T, int (*f)(void *v, void *p), void *p);
 int     bst_traverse_values_r   (bst *T, int (*f)(void *v, void *p), void *p);
+int     bst_traverse_range      (bst *T, const void *lo, const void *hi,
+                                 int (*f)(void *k, void *p), void *p);
+int     bst_traverse_range_values(bst *T, const void *lo, const void *hi,
+                                 int (*f)(void *v, void *p), void *p);
 int     bst_traverse_nodes      (bst *T, int (*f)(bst_n *n, void *p), void *p);
 int     bst_traverse_nodes_r    (bst *T, int (*f)(bst_n *n, void *p), void *p);
 
+void *  bst_select              (const bst *T, size_t k);
+size_t  bst_rank                (const bst *T, const void *k);
+size_t  bst_count_range         (const bst *T, const void *lo, const void *hi);
+
+void *  bst_lower_bound         (const bst *T, const void *k);
+void *  bst_upper_bound         (const bst *T, const void *k);
+void *  bst_floor               (const bst *T, const void *k);
+void *  bst_ceiling             (const bst *T, const void *k);
+
+void *  bst_iter_first          (bst_iter *it, const bst *T);
+void *  bst_iter_last           (bst_iter *it, const bst *T);
+void *  bst_iter_seek           (bst_iter *it, const bst *T, const void *k);
+void *  bst_iter_next           (bst_iter *it);
+void *  bst_iter_prev           (bst_iter *it);
+
+#define bst_iter_key(it)   ((it)->node ? bst_n_key((it)->T, (it)->node) : NULL)
+#define bst_iter_value(it) ((it)->node ? bst_n_value((it)->T, (it)->node) : NULL)
+
 int     bst_invariant           (const bst *T, struct bst_stats *s_out);
 
 #define bst_count(T) (T)->count
@@ -102,11 +142,12 @@ int     bst_invariant           (const bst *T, struct bst_stats *s_out);
 
 /* subroutines on normal BST nodes */
 
-bst_n *  bst_n_new                (const bst *T, const void *k, const void *v);
-void    bst_n_delete             (const bst *T, bst_n *n);
-void    bst_n_delete_rec         (const bst *T, bst_n *n);
+bst_n *  bst_n_new                (bst *T, const void *k, const void *v);
+void    bst_n_delete             (bst *T, bst_n *n);
+void    bst_n_delete_rec         (bst *T, bst_n *n);
+void    bst_n_destroy_rec        (const bst *T, bst_n *n);
 
-bst_n *  bst_n_copy_rec           (const bst *T, const bst_n *n);
+bst_n *  bst_n_copy_rec           (bst *T, const bst_n *n);
 
 bst_n *  bst_n_find               (const bst *T, bst_n *n, const void *k);
 
@@ -133,6 +174,10 @@ size_t  bst_n_height             (const bst_n *n);
     (t_size((T)->key_type) + ((T)->value_type ? t_size((T)->value_type) : 0))
 #define bst_n_size(T) (sizeof(bst_n) + bst_n_data_size(T))
 
+#define bst_n_count(n)          ((n) ? (n)->count : 0)
+#define bst_n_update_count(n) \
+    ((n)->count = 1 + bst_n_count((n)->left) + bst_n_count((n)->right))
+
 #define bst_n_has_key(n)   ((n)->flags.plain.has_key)
 #define bst_n_has_value(n) ((n)->flags.plain.has_value)
 
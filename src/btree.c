@@ -0,0 +1,743 @@
+/*************************************************************************************************
+ *
+ * btree.c
+ *
+ * Implementation of a B-tree with keys and values of arbitrary types, see btree.h. Sources:
+ * Cormen et al., Introduction to Algorithms, ch. 18, and Wikipedia.
+ *
+ * A binary search tree spends most of its time following pointers to nodes that are scattered
+ * all over memory, with one comparison per node. Here every node stores up to 2t - 1 keys in a
+ * sorted array, followed by the array of values and, in inner nodes, the array of t to 2t child
+ * pointers. Leaves don't need the child pointers, so they come from a pool with smaller slots.
+ * The minimum degree t is chosen from the sizes of keys and values such that the arrays take
+ * roughly BTREE_NODE_BYTES.
+ *
+ * Both insertion and removal work in a single pass down from the root: a full child is split
+ * before we descend into it, and a child with the minimum number of keys gets one more from a
+ * sibling or is merged with it. So there is never a need to walk back up again. Keys and values
+ * are moved between slots with t_relocate, which is a plain memmove for most types.
+ *
+ ************************************************************************************************/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btree.h"
+#include "check.h"
+#include "log.h"
+
+#define _round_up(x) (((x) + POOL_ALIGNMENT - 1) & ~(POOL_ALIGNMENT - 1))
+
+static btree_n *_n_new(btree *T, int leaf)
+{
+    btree_n *n = pool_alloc(leaf ? &T->leaf_pool : &T->inner_pool);
+    if (n) {
+        n->count = 0;
+        n->leaf = leaf;
+    }
+    return n;
+}
+
+static void _n_free(btree *T, btree_n *n)
+{
+    pool_free(n->leaf ? &T->leaf_pool : &T->inner_pool, n);
+}
+
+/* Destroy the data stored in the subtree with the root n. The nodes are left to be released in
+ * bulk with the pools. Partial copies can have NULL children. */
+static void _n_destroy_rec(const btree *T, btree_n *n)
+{
+    for (size_t i = 0; i < n->count; ++i) {
+        t_destroy(T->key_type, btree_n_key(T, n, i));
+        if (T->value_type) t_destroy(T->value_type, btree_n_value(T, n, i));
+    }
+    if (!n->leaf) {
+        for (size_t i = 0; i <= n->count; ++i) {
+            btree_n *c = btree_n_children(T, n)[i];
+            if (c) _n_destroy_rec(T, c);
+        }
+    }
+}
+
+/* Return the index of the first key in n that is not less than k, and set *found if it's
+ * equal to k. */
+static size_t _search(const btree *T, const btree_n *n, const void *k, int *found)
+{
+    size_t lo = 0, hi = n->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = t_compare(T->key_type, k, btree_n_key(T, n, mid));
+        if (cmp > 0) {
+            lo = mid + 1;
+        } else if (cmp < 0) {
+            hi = mid;
+        } else {
+            *found = 1;
+            return mid;
+        }
+    }
+    *found = 0;
+    return lo;
+}
+
+/* Move n keys and values from position si in src to position di in dest. The ranges may
+ * overlap. */
+static void _move_entries(const btree *T, btree_n *dest, size_t di, btree_n *src, size_t si,
+                          size_t n)
+{
+    t_relocate(T->key_type, btree_n_key(T, dest, di), btree_n_key(T, src, si), n);
+    if (T->value_type) {
+        t_relocate(T->value_type, btree_n_value(T, dest, di), btree_n_value(T, src, si), n);
+    }
+}
+
+static void _move_children(const btree *T, btree_n *dest, size_t di, btree_n *src, size_t si,
+                           size_t n)
+{
+    memmove(btree_n_children(T, dest) + di, btree_n_children(T, src) + si, n * sizeof(btree_n*));
+}
+
+static void _destroy_entry(const btree *T, btree_n *n, size_t i)
+{
+    t_destroy(T->key_type, btree_n_key(T, n, i));
+    if (T->value_type) t_destroy(T->value_type, btree_n_value(T, n, i));
+}
+
+static void _set_value(const btree *T, btree_n *n, size_t i, const void *v)
+{
+    t_destroy(T->value_type, btree_n_value(T, n, i));
+    t_copy(T->value_type, btree_n_value(T, n, i), v);
+}
+
+/* Split the full i-th child of p into two nodes with t - 1 keys each, and move the median key
+ * up into p, which must not be full. Return 0 on success or -1 on error. */
+static int _split_child(btree *T, btree_n *p, size_t i)
+{
+    btree_n *y = btree_n_children(T, p)[i];
+    assert(y->count == btree_max_keys(T) && p->count < btree_max_keys(T));
+
+    btree_n *z = _n_new(T, y->leaf);
+    check(z, "failed to allocate node");
+
+    size_t t = T->min_degree;
+    _move_entries(T, z, 0, y, t, t - 1);
+    if (!y->leaf) _move_children(T, z, 0, y, t, t);
+    z->count = t - 1;
+
+    _move_entries(T, p, i + 1, p, i, p->count - i);
+    _move_children(T, p, i + 2, p, i + 1, p->count - i);
+    _move_entries(T, p, i, y, t - 1, 1);
+    btree_n_children(T, p)[i + 1] = z;
+    y->count = t - 1;
+    ++p->count;
+
+    return 0;
+error:
+    return -1;
+}
+
+/* Insert k with the value v (or all zero bytes if v is NULL) into T, or set the value of k to v
+ * if it's already there. */
+static int _insert(btree *T, const void *k, const void *v)
+{
+    if (!T->root) {
+        T->root = _n_new(T, 1);
+        check(T->root, "failed to allocate node");
+    }
+
+    if (T->root->count == btree_max_keys(T)) {
+        btree_n *s = _n_new(T, 0);
+        check(s, "failed to allocate node");
+        btree_n_children(T, s)[0] = T->root;
+        if (_split_child(T, s, 0) < 0) {
+            _n_free(T, s);
+            goto error;
+        }
+        T->root = s;
+    }
+
+    btree_n *n = T->root;
+    size_t i;
+    int found;
+    for (;;) {
+        i = _search(T, n, k, &found);
+        if (found) {
+            if (v) _set_value(T, n, i, v);
+            return 0;
+        }
+        if (n->leaf) break;
+
+        if (btree_n_children(T, n)[i]->count == btree_max_keys(T)) {
+            int rc = _split_child(T, n, i);
+            check_rc(rc, "_split_child");
+            int cmp = t_compare(T->key_type, k, btree_n_key(T, n, i));
+            if (cmp == 0) {
+                if (v) _set_value(T, n, i, v);
+                return 0;
+            }
+            if (cmp > 0) ++i;
+        }
+        n = btree_n_children(T, n)[i];
+    }
+
+    _move_entries(T, n, i + 1, n, i, n->count - i);
+    t_copy(T->key_type, btree_n_key(T, n, i), k);
+    void *vp = btree_n_value(T, n, i);
+    if (vp) {
+        if (v) t_copy(T->value_type, vp, v);
+        else memset(vp, 0, t_size(T->value_type));
+    }
+    ++n->count;
+    ++T->count;
+    return 1;
+error:
+    return -1;
+}
+
+/* Move the last key of the i-th child of p up into p, and the i-th key of p down to the front
+ * of the next child. */
+static void _rotate_right(btree *T, btree_n *p, size_t i)
+{
+    btree_n *l = btree_n_children(T, p)[i], *c = btree_n_children(T, p)[i + 1];
+
+    _move_entries(T, c, 1, c, 0, c->count);
+    if (!c->leaf) _move_children(T, c, 1, c, 0, c->count + 1);
+    _move_entries(T, c, 0, p, i, 1);
+    _move_entries(T, p, i, l, l->count - 1, 1);
+    if (!c->leaf) btree_n_children(T, c)[0] = btree_n_children(T, l)[l->count];
+
+    --l->count;
+    ++c->count;
+}
+
+/* Move the first key of the (i+1)-th child of p up into p, and the i-th key of p down to the end
+ * of the previous child. */
+static void _rotate_left(btree *T, btree_n *p, size_t i)
+{
+    btree_n *c = btree_n_children(T, p)[i], *r = btree_n_children(T, p)[i + 1];
+
+    _move_entries(T, c, c->count, p, i, 1);
+    _move_entries(T, p, i, r, 0, 1);
+    if (!c->leaf) btree_n_children(T, c)[c->count + 1] = btree_n_children(T, r)[0];
+    _move_entries(T, r, 0, r, 1, r->count - 1);
+    if (!r->leaf) _move_children(T, r, 0, r, 1, r->count);
+
+    ++c->count;
+    --r->count;
+}
+
+/* Merge the (i+1)-th child of p and the i-th key of p into the i-th child. */
+static void _merge(btree *T, btree_n *p, size_t i)
+{
+    btree_n *y = btree_n_children(T, p)[i], *z = btree_n_children(T, p)[i + 1];
+    assert(y->count + z->count < btree_max_keys(T));
+
+    _move_entries(T, y, y->count, p, i, 1);
+    _move_entries(T, y, y->count + 1, z, 0, z->count);
+    if (!y->leaf) _move_children(T, y, y->count + 1, z, 0, z->count + 1);
+    y->count += z->count + 1;
+
+    _move_entries(T, p, i, p, i + 1, p->count - i - 1);
+    _move_children(T, p, i + 1, p, i + 2, p->count - i - 1);
+    --p->count;
+
+    _n_free(T, z);
+}
+
+/* Make sure that the i-th child of p has more than the minimum number of keys before we descend
+ * into it, by borrowing a key from a sibling or merging it with one. Return the index of the
+ * child that now holds the keys of the original one. */
+static size_t _fix_child(btree *T, btree_n *p, size_t i)
+{
+    btree_n **children = btree_n_children(T, p);
+    size_t min = btree_min_keys(T);
+
+    if (children[i]->count > min) return i;
+
+    if (i > 0 && children[i - 1]->count > min) {
+        _rotate_right(T, p, i - 1);
+    } else if (i < p->count && children[i + 1]->count > min) {
+        _rotate_left(T, p, i);
+    } else if (i < p->count) {
+        _merge(T, p, i);
+    } else {
+        _merge(T, p, --i);
+    }
+    return i;
+}
+
+/* Remove the greatest (smallest) entry from the subtree with the root n, which must have more
+ * than the minimum number of keys, and relocate it to kdest and vdest. */
+static void _take_max(btree *T, btree_n *n, void *kdest, void *vdest)
+{
+    while (!n->leaf) {
+        n = btree_n_children(T, n)[_fix_child(T, n, n->count)];
+    }
+    --n->count;
+    t_relocate(T->key_type, kdest, btree_n_key(T, n, n->count), 1);
+    if (T->value_type) t_relocate(T->value_type, vdest, btree_n_value(T, n, n->count), 1);
+}
+
+static void _take_min(btree *T, btree_n *n, void *kdest, void *vdest)
+{
+    while (!n->leaf) {
+        n = btree_n_children(T, n)[_fix_child(T, n, 0)];
+    }
+    t_relocate(T->key_type, kdest, btree_n_key(T, n, 0), 1);
+    if (T->value_type) t_relocate(T->value_type, vdest, btree_n_value(T, n, 0), 1);
+    _move_entries(T, n, 0, n, 1, n->count - 1);
+    --n->count;
+}
+
+static int _remove(btree *T, const void *k)
+{
+    btree_n *n = T->root;
+    size_t min = btree_min_keys(T);
+    int found, rc = 0;
+
+    if (!n) return 0;
+
+    for (;;) {
+        size_t i = _search(T, n, k, &found);
+        if (n->leaf) {
+            if (found) {
+                _destroy_entry(T, n, i);
+                _move_entries(T, n, i, n, i + 1, n->count - i - 1);
+                --n->count;
+                rc = 1;
+            }
+            break;
+        }
+
+        if (found) {
+            /* Replace k by its predecessor or successor if one of the adjacent children can
+             * spare a key, otherwise merge them and remove k from the merged node. */
+            btree_n *y = btree_n_children(T, n)[i], *z = btree_n_children(T, n)[i + 1];
+            if (y->count > min) {
+                _destroy_entry(T, n, i);
+                _take_max(T, y, btree_n_key(T, n, i), btree_n_value(T, n, i));
+                rc = 1;
+                break;
+            }
+            if (z->count > min) {
+                _destroy_entry(T, n, i);
+                _take_min(T, z, btree_n_key(T, n, i), btree_n_value(T, n, i));
+                rc = 1;
+                break;
+            }
+            _merge(T, n, i);
+            n = y;
+            continue;
+        }
+
+        n = btree_n_children(T, n)[_fix_child(T, n, i)];
+    }
+
+    /* The root loses its last key if its only two children were merged. */
+    if (T->root->count == 0) {
+        btree_n *r = T->root;
+        T->root = r->leaf ? NULL : btree_n_children(T, r)[0];
+        _n_free(T, r);
+    }
+
+    if (rc == 1) --T->count;
+    return rc;
+}
+
+/* Copy the subtree with the root n into T and store its root at out. On error, the partial copy
+ * is left in a state that _n_destroy_rec can handle. */
+static int _n_copy_rec(btree *T, const btree_n *n, btree_n **out)
+{
+    btree_n *c = _n_new(T, n->leaf);
+    check(c, "failed to allocate node");
+
+    for (size_t i = 0; i < n->count; ++i) {
+        t_copy(T->key_type, btree_n_key(T, c, i), btree_n_key(T, n, i));
+        if (T->value_type) {
+            t_copy(T->value_type, btree_n_value(T, c, i), btree_n_value(T, n, i));
+        }
+    }
+    c->count = n->count;
+    *out = c;
+
+    if (!n->leaf) {
+        memset(btree_n_children(T, c), 0, (n->count + 1) * sizeof(btree_n*));
+        for (size_t i = 0; i <= n->count; ++i) {
+            int rc = _n_copy_rec(T, btree_n_children(T, n)[i], btree_n_children(T, c) + i);
+            check_rc(rc, "_n_copy_rec");
+        }
+    }
+
+    return 0;
+error:
+    return -1;
+}
+
+/* int    btree_initialize     (btree *T, t_intf *kt, t_intf *vt)
+ * int    btree_initialize_with(btree *T, t_intf *kt, t_intf *vt, allocator *A)
+ * btree *btree_new            (          t_intf *kt, t_intf *vt)
+ * Initialize a B-tree at T, or allocate and initialize a new one on the heap. The type interface
+ * for keys is required and must contain at least a size and a comparison function. The type
+ * interface for values can be NULL if the tree is going to store keys only. Keys that are
+ * inserted without a value get one with all bytes zero, which must be safe to destroy.
+ * btree_initialize_with takes the nodes from the allocator A instead of malloc. */
+int btree_initialize(btree *T, t_intf *kt, t_intf *vt)
+{
+    return btree_initialize_with(T, kt, vt, NULL);
+}
+
+int btree_initialize_with(btree *T, t_intf *kt, t_intf *vt, allocator *A)
+{
+    log_call("T=%p, kt=%p, vt=%p, A=%p", T, kt, vt, A);
+
+    check_ptr(T);
+    check(kt != NULL, "no key type given");
+    check(kt->compare != NULL, "key type but no comparison function");
+    check(kt->size > 0, "size of 0 for keys?");
+    check(!vt || vt->size > 0, "size of 0 for values?");
+
+    size_t entry_size = t_size(kt) + (vt ? t_size(vt) : 0);
+    size_t t = BTREE_NODE_BYTES / (2 * entry_size);
+    if (t < BTREE_MIN_DEGREE) t = BTREE_MIN_DEGREE;
+    if (t > BTREE_MAX_DEGREE) t = BTREE_MAX_DEGREE;
+
+    T->root = NULL;
+    T->count = 0;
+    T->key_type = kt;
+    T->value_type = vt;
+    T->min_degree = t;
+    T->values_offset = _round_up(BTREE_KEYS_OFFSET + btree_max_keys(T) * t_size(kt));
+    T->children_offset = _round_up(T->values_offset + (vt ? btree_max_keys(T) * t_size(vt) : 0));
+
+    int rc = pool_initialize(&T->leaf_pool, T->children_offset, A);
+    check_rc(rc, "pool_initialize");
+    rc = pool_initialize(&T->inner_pool,
+                         T->children_offset + (btree_max_keys(T) + 1) * sizeof(btree_n*), A);
+    if (rc < 0) {
+        pool_destroy(&T->leaf_pool);
+        log_error("pool_initialize failed");
+        goto error;
+    }
+
+    return 0;
+error:
+    return -1;
+}
+
+btree *btree_new(t_intf *kt, t_intf *vt)
+{
+    log_call("kt=%p, vt=%p", kt, vt);
+
+    btree *T = calloc(1, sizeof(*T));
+    check_alloc(T);
+
+    int rc = btree_initialize(T, kt, vt);
+    check_rc(rc, "btree_initialize");
+
+    return T;
+error:
+    if (T) free(T);
+    return NULL;
+}
+
+/* void btree_clear(btree *T)
+ * Remove all entries and reset T. Stored data is destroyed entry by entry only if the type
+ * interfaces have destructors; the nodes are released in bulk with the pools. */
+void btree_clear(btree *T)
+{
+    log_call("T=%p", T);
+    if (T) {
+        if (T->root && (T->key_type->destroy || (T->value_type && T->value_type->destroy))) {
+            _n_destroy_rec(T, T->root);
+        }
+        pool_clear(&T->leaf_pool);
+        pool_clear(&T->inner_pool);
+        T->root = NULL;
+        T->count = 0;
+    }
+}
+
+/* void btree_destroy(btree *T)
+ * void btree_delete (btree *T)
+ * Destroy T, freeing any associated memory. btree_delete also calls free on T. */
+void btree_destroy(btree *T)
+{
+    log_call("T=%p", T);
+    if (T) {
+        btree_clear(T);
+        pool_destroy(&T->leaf_pool);
+        pool_destroy(&T->inner_pool);
+        memset(T, 0, sizeof(*T));
+    }
+}
+
+void btree_delete(btree *T)
+{
+    log_call("T=%p", T);
+    if (T) {
+        btree_destroy(T);
+        free(T);
+    }
+}
+
+/* btree *btree_copy   (             const btree *src)
+ * int    btree_copy_to(btree *dest, const btree *src)
+ * Copy a B-tree, duplicating all content and preserving the exact same layout. btree_copy makes
+ * the copy on the heap, btree_copy_to creates it where dest points to. The copy takes its nodes
+ * from the same allocator as src. */
+btree *btree_copy(const btree *src)
+{
+    log_call("src=%p", src);
+    btree *dest = NULL;
+    check_ptr(src);
+
+    dest = calloc(1, sizeof(*dest));
+    check_alloc(dest);
+
+    int rc = btree_copy_to(dest, src);
+    check_rc(rc, "btree_copy_to");
+
+    return dest;
+error:
+    if (dest) free(dest);
+    return NULL;
+}
+
+int btree_copy_to(btree *dest, const btree *src)
+{
+    log_call("dest=%p, src=%p", dest, src);
+    check_ptr(dest);
+    check_ptr(src);
+
+    int rc = btree_initialize_with(dest, src->key_type, src->value_type, src->leaf_pool.alloc);
+    check_rc(rc, "btree_initialize_with");
+
+    if (src->root) {
+        rc = _n_copy_rec(dest, src->root, &dest->root);
+        if (rc < 0) {
+            btree_destroy(dest);
+            log_error("failed to copy nodes");
+            goto error;
+        }
+    }
+    dest->count = src->count;
+
+    return 0;
+error:
+    return -1;
+}
+
+/* int btree_has(const btree *T, const void *k)
+ * Check if k is in T. */
+int btree_has(const btree *T, const void *k)
+{
+    check_ptr(T);
+    check_ptr(k);
+
+    btree_n *n = T->root;
+    while (n) {
+        int found;
+        size_t i = _search(T, n, k, &found);
+        if (found) return 1;
+        n = n->leaf ? NULL : btree_n_children(T, n)[i];
+    }
+    return 0;
+error:
+    return -1;
+}
+
+/* int btree_insert(btree *T, const void *k)
+ * Insert k into the tree. If T stores values, the value of a new key has all bytes zero. Return 1
+ * if k was added, 0 if it was already there, or -1 on error. */
+int btree_insert(btree *T, const void *k)
+{
+    log_call("T=%p, k=%p", T, k);
+    check_ptr(T);
+    check_ptr(k);
+
+    return _insert(T, k, NULL);
+error:
+    return -1;
+}
+
+/* int btree_remove(btree *T, const void *k)
+ * Remove k and its value from the tree. Return 1 if k was removed, 0 if it was not there, or -1
+ * on error. */
+int btree_remove(btree *T, const void *k)
+{
+    log_call("T=%p, k=%p", T, k);
+    check_ptr(T);
+    check_ptr(k);
+
+    return _remove(T, k);
+error:
+    return -1;
+}
+
+/* int btree_set(btree *T, const void *k, const void *v)
+ * Set the value of the key k to v, or insert k with the value v if k doesn't exist. Return 1 if
+ * k was added, 0 if it was already there, or -1 on error. */
+int btree_set(btree *T, const void *k, const void *v)
+{
+    log_call("T=%p, k=%p, v=%p", T, k, v);
+    check_ptr(T);
+    check_ptr(k);
+    check_ptr(v);
+    check(T->value_type, "no value type defined");
+
+    return _insert(T, k, v);
+error:
+    return -1;
+}
+
+/* void *btree_get(btree *T, const void *k)
+ * Return a pointer to the value mapped to k in T or NULL if k doesn't exist. The pointer is
+ * valid until the next insertion or removal. */
+void *btree_get(btree *T, const void *k)
+{
+    check_ptr(T);
+    check_ptr(k);
+    check(T->value_type, "no value type defined");
+
+    btree_n *n = T->root;
+    while (n) {
+        int found;
+        size_t i = _search(T, n, k, &found);
+        if (found) return btree_n_value(T, n, i);
+        n = n->leaf ? NULL : btree_n_children(T, n)[i];
+    }
+
+error: /* fallthrough */
+    return NULL;
+}
+
+/* Walk through the subtree with the root n in ascending or descending order and call f on every
+ * key or value. */
+static int _n_traverse(btree *T, btree_n *n, int values, int reverse,
+                       int (*f)(void *e, void *p), void *p)
+{
+    int rc;
+    size_t count = n->count;
+
+    for (size_t j = 0; j <= count; ++j) {
+        size_t i = reverse ? count - j : j;
+        if (!n->leaf) {
+            rc = _n_traverse(T, btree_n_children(T, n)[i], values, reverse, f, p);
+            if (rc != 0) return rc;
+        }
+        if (j == count) break;
+
+        if (reverse) --i;
+        rc = f(values ? btree_n_value(T, n, i) : btree_n_key(T, n, i), p);
+        if (rc != 0) return rc;
+    }
+    return 0;
+}
+
+/* int btree_traverse_keys    (btree *T, int (*f)(void *k, void *p), void *p)
+ * int btree_traverse_keys_r  (btree *T, int (*f)(void *k, void *p), void *p)
+ * int btree_traverse_values  (btree *T, int (*f)(void *v, void *p), void *p)
+ * int btree_traverse_values_r(btree *T, int (*f)(void *v, void *p), void *p)
+ * Walk through the tree in ascending/descending order of the keys. Call f on every key or value
+ * with the additional parameter p. If f returns a non-zero integer, abort and return it. */
+int btree_traverse_keys(btree *T, int (*f)(void *k, void *p), void *p)
+{
+    if (T && T->root) return _n_traverse(T, T->root, 0, 0, f, p);
+    return 0;
+}
+
+int btree_traverse_keys_r(btree *T, int (*f)(void *k, void *p), void *p)
+{
+    if (T && T->root) return _n_traverse(T, T->root, 0, 1, f, p);
+    return 0;
+}
+
+int btree_traverse_values(btree *T, int (*f)(void *v, void *p), void *p)
+{
+    check_ptr(T);
+    check(T->value_type, "the tree doesn't store values");
+    if (T->root) return _n_traverse(T, T->root, 1, 0, f, p);
+    return 0;
+error:
+    return -1;
+}
+
+int btree_traverse_values_r(btree *T, int (*f)(void *v, void *p), void *p)
+{
+    check_ptr(T);
+    check(T->value_type, "the tree doesn't store values");
+    if (T->root) return _n_traverse(T, T->root, 1, 1, f, p);
+    return 0;
+error:
+    return -1;
+}
+
+/* Check the subtree with the root n at the given depth, whose keys must lie between lo and hi
+ * (if given). Collect the depth of the leaves and the number of keys. */
+static int _n_invariant(const btree *T, const btree_n *n, const void *lo, const void *hi,
+                        size_t depth, size_t *leaf_depth, size_t *total)
+{
+    if (n->count > btree_max_keys(T) || n->count == 0 ||
+            (n != T->root && n->count < btree_min_keys(T))) {
+        log_error("B-tree invariant violated: node with %u keys", n->count);
+        return -1;
+    }
+
+    for (size_t i = 0; i < n->count; ++i) {
+        const void *k = btree_n_key(T, n, i);
+        if ((i == 0 && lo && t_compare(T->key_type, lo, k) >= 0) ||
+                (i > 0 && t_compare(T->key_type, btree_n_key(T, n, i - 1), k) >= 0)) {
+            log_error("B-tree invariant violated: keys out of order");
+            return -1;
+        }
+    }
+    if (hi && t_compare(T->key_type, btree_n_key(T, n, n->count - 1), hi) >= 0) {
+        log_error("B-tree invariant violated: keys out of order");
+        return -1;
+    }
+
+    *total += n->count;
+
+    if (n->leaf) {
+        if (*leaf_depth == 0) *leaf_depth = depth;
+        if (*leaf_depth != depth) {
+            log_error("B-tree invariant violated: leaves at depths %zu and %zu",
+                      *leaf_depth, depth);
+            return -1;
+        }
+        return 0;
+    }
+
+    for (size_t i = 0; i <= n->count; ++i) {
+        const void *clo = i > 0 ? btree_n_key(T, n, i - 1) : lo;
+        const void *chi = i < n->count ? btree_n_key(T, n, i) : hi;
+        if (_n_invariant(T, btree_n_children(T, n)[i], clo, chi, depth + 1, leaf_depth,
+                         total) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* int btree_invariant(const btree *T, size_t *height_out)
+ * Check if the keys are ordered, all leaves are at the same depth, every node has a legal number
+ * of keys, and the count is right. If height_out is not NULL, save the height of the tree there.
+ * Return 0 if everything is fine, or -1 otherwise. */
+int btree_invariant(const btree *T, size_t *height_out)
+{
+    check_ptr(T);
+    check(T->key_type, "malformed B-tree: no key type");
+
+    size_t height = 0, total = 0;
+    int rc = 0;
+    if (T->root) rc = _n_invariant(T, T->root, NULL, NULL, 1, &height, &total);
+
+    check(T->count == total, "count (%zu) and actual number of keys (%zu) differ",
+          T->count, total);
+
+    if (height_out) *height_out = height;
+    return rc;
+error:
+    return -1;
+}
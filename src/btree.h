@@ -0,0 +1,94 @@
+/*************************************************************************************************
+ *
+ * btree.h
+ *
+ * Interface for a B-tree that stores keys or key-value pairs of arbitrary types by way of type
+ * interface structs, like the binary search tree in bst.h. Every node holds up to a few dozen
+ * keys (and values) inline in a single pool slot, so a search visits about log_32(n) nodes
+ * instead of log_2(n), and within a node it does a binary search over contiguous memory. This is
+ * the basis for the bmap and bset variants of map and set (see map.h, set.h).
+ *
+ * Keys and values are moved around within and between nodes, so pointers to them (as returned
+ * by btree_get) are only valid until the next insertion or removal.
+ *
+ ************************************************************************************************/
+
+#ifndef _btree_h
+#define _btree_h
+
+#include <stdint.h>
+#include "pool.h"
+#include "type_interface.h"
+
+/* The approximate size of the key and value arrays of a node in bytes. The minimum degree of a
+ * tree (see below) is chosen so that they fit, but within [BTREE_MIN_DEGREE, BTREE_MAX_DEGREE]. */
+#define BTREE_NODE_BYTES    1024lu
+#define BTREE_MIN_DEGREE    8lu
+#define BTREE_MAX_DEGREE    32lu
+
+/* A node is followed by the arrays of its keys and values and, for inner nodes, its children.
+ * Every node but the root holds between min_degree - 1 and 2 * min_degree - 1 keys. */
+typedef struct btree_n {
+    uint16_t    count;
+    uint16_t    leaf;
+} btree_n;
+
+typedef struct btree {
+    btree_n *   root;
+    size_t      count;
+    t_intf *    key_type;
+    t_intf *    value_type;
+    size_t      min_degree;
+    size_t      values_offset;      /* offsets of the arrays in a node */
+    size_t      children_offset;
+    pool        leaf_pool;
+    pool        inner_pool;
+} btree;
+
+/* public interface */
+
+int     btree_initialize        (btree *T, t_intf *kt, t_intf *vt);
+int     btree_initialize_with   (btree *T, t_intf *kt, t_intf *vt, allocator *A);
+btree * btree_new               (          t_intf *kt, t_intf *vt);
+void    btree_destroy           (btree *T);
+void    btree_delete            (btree *T);
+
+void    btree_clear             (btree *T);
+btree * btree_copy              (             const btree *src);
+int     btree_copy_to           (btree *dest, const btree *src);
+
+int     btree_insert            (      btree *T, const void *k);
+int     btree_remove            (      btree *T, const void *k);
+int     btree_set               (      btree *T, const void *k, const void *v);
+void *  btree_get               (      btree *T, const void *k);
+int     btree_has               (const btree *T, const void *k);
+
+int     btree_traverse_keys     (btree *T, int (*f)(void *k, void *p), void *p);
+int     btree_traverse_keys_r   (btree *T, int (*f)(void *k, void *p), void *p);
+int     btree_traverse_values   (btree *T, int (*f)(void *v, void *p), void *p);
+int     btree_traverse_values_r (btree *T, int (*f)(void *v, void *p), void *p);
+
+int     btree_invariant         (const btree *T, size_t *height_out);
+
+#define btree_count(T) (T)->count
+
+/*************************************************************************************************
+ *
+ * Everything below this point is considered a private implementation detail and should not be
+ * used by other code.
+ *
+ ************************************************************************************************/
+
+#define BTREE_KEYS_OFFSET   POOL_ALIGNMENT
+
+#define btree_max_keys(T)   (2 * (T)->min_degree - 1)
+#define btree_min_keys(T)   ((T)->min_degree - 1)
+
+#define btree_n_key(T, n, i) \
+    ((void*)((char*)(n) + BTREE_KEYS_OFFSET + (i) * t_size((T)->key_type)))
+#define btree_n_value(T, n, i) \
+    ((T)->value_type ? \
+     (void*)((char*)(n) + (T)->values_offset + (i) * t_size((T)->value_type)) : NULL)
+#define btree_n_children(T, n) ((btree_n**)((char*)(n) + (T)->children_offset))
+
+#endif /* _btree_h */
@@ -0,0 +1,381 @@
+/*************************************************************************************************
+ *
+ * external_sort.c
+ * External merge sort for files of fixed-size records that don't fit into memory. Sources:
+ * Knuth, TAOCP Vol. 3, 5.4, and Wikipedia.
+ *
+ * The input is read in chunks that fill the memory budget. Each chunk is sorted with pdqsort and
+ * appended to a temporary file as a sorted run. The runs are then merged with a heap of cursors,
+ * one per run, each with its own share of the budget as a read buffer. If there are too many
+ * runs to give each of them a reasonably large buffer, groups of runs are merged into longer
+ * runs in another temporary file first. Input that fits into a single chunk never touches the
+ * disk. Temporary files go to $TMPDIR, since the default of tmpfile(3) is often a small tmpfs.
+ *
+ ************************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "heap.h"
+#include "sort.h"
+#include "sort_tools.h"
+
+/* The smallest read buffer we want for a run during a merge. Determines how many runs are merged
+ * at once. */
+#define EXTERNAL_SORT_BLOCK (64lu * 1024)
+
+typedef int (*record_f)(const void *record, void *data);
+
+struct run {
+    off_t       offset;     /* where the next unbuffered record is in the file */
+    size_t      remaining;  /* the number of unbuffered records */
+    char *      buffer;
+    char *      record;     /* the next record in the buffer */
+    char *      end;
+};
+
+struct writer {
+    int         fd;
+    off_t       offset;     /* where to write to the file, or -1 for its current position */
+    size_t      size;
+    char *      buffer;
+    size_t      capacity;
+    size_t      count;
+};
+
+/* Read up to n records of the given size from fd into buffer. Fail if the input ends in the
+ * middle of a record. */
+static int _read_records(int fd, char *buffer, size_t n, size_t size, size_t *n_read)
+{
+    size_t len = n * size, done = 0;
+    while (done < len) {
+        ssize_t rc = read(fd, buffer + done, len - done);
+        if (rc < 0 && errno == EINTR) continue;
+        check(rc >= 0, "failed to read input: %s", strerror(errno));
+        if (rc == 0) break;
+        done += (size_t)rc;
+    }
+    check(done % size == 0, "input ends with a partial record");
+    *n_read = done / size;
+    return 0;
+error:
+    return -1;
+}
+
+/* Write len bytes to fd at the given offset, or at the current position if offset is -1. */
+static int _write_all(int fd, const char *buffer, size_t len, off_t offset)
+{
+    while (len > 0) {
+        ssize_t rc = offset < 0 ? write(fd, buffer, len) : pwrite(fd, buffer, len, offset);
+        if (rc < 0 && errno == EINTR) continue;
+        check(rc > 0, "failed to write: %s", strerror(errno));
+        buffer += rc;
+        len -= (size_t)rc;
+        if (offset >= 0) offset += rc;
+    }
+    return 0;
+error:
+    return -1;
+}
+
+static int _read_all(int fd, char *buffer, size_t len, off_t offset)
+{
+    while (len > 0) {
+        ssize_t rc = pread(fd, buffer, len, offset);
+        if (rc < 0 && errno == EINTR) continue;
+        check(rc > 0, "failed to read temporary file: %s", rc < 0 ? strerror(errno) : "EOF");
+        buffer += rc;
+        len -= (size_t)rc;
+        offset += rc;
+    }
+    return 0;
+error:
+    return -1;
+}
+
+static int _writer_flush(struct writer *W)
+{
+    int rc = _write_all(W->fd, W->buffer, W->count * W->size, W->offset);
+    check_rc(rc, "_write_all");
+    if (W->offset >= 0) W->offset += (off_t)(W->count * W->size);
+    W->count = 0;
+    return 0;
+error:
+    return -1;
+}
+
+static int _writer_emit(const void *record, void *data)
+{
+    struct writer *W = data;
+    memcpy(W->buffer + W->count++ * W->size, record, W->size);
+    return W->count == W->capacity ? _writer_flush(W) : 0;
+}
+
+/* Read the next records of the run into its buffer of block records. Return 1 if there were
+ * any, 0 if the run is exhausted, or -1 on error. */
+static int _run_fill(int fd, struct run *r, size_t block, size_t size)
+{
+    size_t n = r->remaining < block ? r->remaining : block;
+    if (n == 0) return 0;
+
+    int rc = _read_all(fd, r->buffer, n * size, r->offset);
+    check_rc(rc, "_read_all");
+
+    r->offset += (off_t)(n * size);
+    r->remaining -= n;
+    r->record = r->buffer;
+    r->end = r->buffer + n * size;
+    return 1;
+error:
+    return -1;
+}
+
+/* The heap functions take an ordinary comparison function, so the user's comparison function
+ * for the records is passed in a thread-local variable. */
+static _Thread_local compare_f _record_compare_f;
+
+/* Order run cursors by their next records, smallest first since heap.c builds max-heaps. Equal
+ * records are taken from the earlier run first. */
+static int _run_compare(const void *a, const void *b)
+{
+    const struct run *r = *(const struct run**)a, *s = *(const struct run**)b;
+    int c = _record_compare_f(r->record, s->record);
+    if (c != 0) return -c;
+    return r < s ? 1 : -1;
+}
+
+/* Merge the k runs stored in fd, using block records of memory as the buffer of each, and pass
+ * the records to emit in order. */
+static int _merge_runs(int fd, struct run *runs, size_t k, size_t size,
+                  char *memory, size_t block,
+                  record_f emit, void *data)
+{
+    struct run **heap = NULL;
+    char temp[sizeof(struct run*)];
+    size_t n = 0;
+    int rc;
+
+    heap = malloc(k * sizeof(*heap));
+    check_alloc(heap);
+
+    for (size_t i = 0; i < k; ++i) {
+        runs[i].buffer = memory + i * block * size;
+        rc = _run_fill(fd, runs + i, block, size);
+        check_rc(rc, "_run_fill");
+        if (rc > 0) heap[n++] = runs + i;
+    }
+    make_heap((char*)heap, n, sizeof(*heap), _run_compare, temp);
+
+    while (n > 0) {
+        struct run *r = heap[0];
+        rc = emit(r->record, data);
+        check(rc == 0, "failed to output record");
+
+        r->record += size;
+        if (r->record == r->end) {
+            rc = _run_fill(fd, r, block, size);
+            check_rc(rc, "_run_fill");
+            if (rc == 0) heap[0] = heap[--n];
+        }
+        if (n > 1) heap_sift_down((char*)heap, n, sizeof(*heap), 0, _run_compare, temp);
+    }
+
+    free(heap);
+    return 0;
+error:
+    if (heap) free(heap);
+    return -1;
+}
+
+/* Create an anonymous temporary file in $TMPDIR, or P_tmpdir if that isn't set, and return its
+ * file descriptor, or -1 on error. The file is unlinked right away, so it goes away with the
+ * descriptor. */
+static int _temp_file(void)
+{
+    const char *dir = getenv("TMPDIR");
+    if (!dir || !*dir) dir = P_tmpdir;
+
+    size_t len = strlen(dir) + sizeof("/external_sort.XXXXXX");
+    char *path = malloc(len);
+    check_alloc(path);
+    snprintf(path, len, "%s/external_sort.XXXXXX", dir);
+
+    int fd = mkstemp(path);
+    check(fd >= 0, "failed to create temporary file in %s", dir);
+    unlink(path);
+    free(path);
+    return fd;
+error:
+    if (path) free(path);
+    return -1;
+}
+
+/* Sort the records from in_fd and write them to out_fd, or pass them to emit if out_fd is -1. */
+static int _external_sort(int in_fd, size_t size, compare_f compare, size_t memory,
+                          int out_fd, record_f emit, void *data)
+{
+    char *buffer = NULL;
+    struct run *runs = NULL;
+    int file = -1, next_file = -1;
+    size_t n_runs = 0, runs_capacity = 0;
+    off_t end = 0;
+    int rc;
+
+    check(size > 0, "record size must not be 0");
+    check_ptr(compare);
+
+    size_t capacity = memory / size;
+    check(capacity >= 3, "memory budget of %zu bytes too small for records of %zu bytes",
+          memory, size);
+    buffer = malloc(capacity * size);
+    check_alloc(buffer);
+    _record_compare_f = compare;
+
+    /* Split the input into sorted runs. */
+    for (;;) {
+        size_t n;
+        rc = _read_records(in_fd, buffer, capacity, size, &n);
+        check_rc(rc, "_read_records");
+        if (n == 0) break;
+
+        pdqsort(buffer, n, size, compare);
+
+        if (n_runs == 0 && n < capacity) {
+            /* Everything fits into memory. */
+            if (out_fd >= 0) {
+                rc = _write_all(out_fd, buffer, n * size, -1);
+                check_rc(rc, "_write_all");
+            } else {
+                for (size_t i = 0; i < n; ++i) {
+                    rc = emit(buffer + i * size, data);
+                    check(rc == 0, "failed to output record");
+                }
+            }
+            free(buffer);
+            return 0;
+        }
+
+        if (file < 0) {
+            file = _temp_file();
+            check_rc(file, "_temp_file");
+        }
+        if (n_runs == runs_capacity) {
+            runs_capacity = runs_capacity ? 2 * runs_capacity : 16;
+            struct run *new_runs = realloc(runs, runs_capacity * sizeof(*runs));
+            check_alloc(new_runs);
+            runs = new_runs;
+        }
+
+        rc = _write_all(file, buffer, n * size, end);
+        check_rc(rc, "_write_all");
+        runs[n_runs++] = (struct run){ .offset = end, .remaining = n };
+        end += (off_t)(n * size);
+
+        if (n < capacity) break;
+    }
+
+    /* Merge as many runs at a time as leaves each at least EXTERNAL_SORT_BLOCK bytes of memory
+     * (and the output one more share), but at least two. */
+    size_t fan_in = memory / EXTERNAL_SORT_BLOCK;
+    fan_in = fan_in > 3 ? fan_in - 1 : 2;
+    if (fan_in > capacity - 1) fan_in = capacity - 1;
+
+    while (n_runs > fan_in) {
+        next_file = _temp_file();
+        check_rc(next_file, "_temp_file");
+
+        size_t n_merged = 0;
+        end = 0;
+        for (size_t i = 0; i < n_runs; i += fan_in) {
+            size_t k = n_runs - i < fan_in ? n_runs - i : fan_in;
+            size_t block = capacity / (k + 1);
+            size_t total = 0;
+            for (size_t j = i; j < i + k; ++j) total += runs[j].remaining;
+
+            struct writer W = {
+                .fd = next_file,
+                .offset = end,
+                .size = size,
+                .buffer = buffer + k * block * size,
+                .capacity = capacity - k * block,
+                .count = 0
+            };
+            rc = _merge_runs(file, runs + i, k, size, buffer, block, _writer_emit, &W);
+            check_rc(rc, "_merge_runs");
+            rc = _writer_flush(&W);
+            check_rc(rc, "_writer_flush");
+
+            /* The merged runs are no longer needed, so the new run can take the place of one
+             * of them. */
+            runs[n_merged++] = (struct run){ .offset = end, .remaining = total };
+            end += (off_t)(total * size);
+        }
+
+        close(file);
+        file = next_file;
+        next_file = -1;
+        n_runs = n_merged;
+    }
+
+    if (n_runs > 0) {
+        if (out_fd >= 0) {
+            size_t block = capacity / (n_runs + 1);
+            struct writer W = {
+                .fd = out_fd,
+                .offset = -1,
+                .size = size,
+                .buffer = buffer + n_runs * block * size,
+                .capacity = capacity - n_runs * block,
+                .count = 0
+            };
+            rc = _merge_runs(file, runs, n_runs, size, buffer, block, _writer_emit, &W);
+            check_rc(rc, "_merge_runs");
+            rc = _writer_flush(&W);
+            check_rc(rc, "_writer_flush");
+        } else {
+            rc = _merge_runs(file, runs, n_runs, size,
+                             buffer, capacity / n_runs, emit, data);
+            check_rc(rc, "_merge_runs");
+        }
+    }
+
+    if (file >= 0) close(file);
+    free(runs);
+    free(buffer);
+    return 0;
+error:
+    if (next_file >= 0) close(next_file);
+    if (file >= 0) close(file);
+    if (runs) free(runs);
+    if (buffer) free(buffer);
+    return -1;
+}
+
+/* int external_sort   (int in_fd, int out_fd, size_t size, compare_f compare, size_t memory)
+ * int external_sort_to(int in_fd, size_t size, compare_f compare, size_t memory,
+ *                      int (*emit)(const void *record, void *data), void *data)
+ * Read records of the given size from in_fd until the end of the input, and write them to out_fd
+ * in ascending order, or pass them to emit one by one together with data. The record buffers
+ * take at most memory bytes, which must be enough for at least three records; input that doesn't
+ * fit is sorted in runs that are stored in temporary files in $TMPDIR (or P_tmpdir). The sort
+ * isn't stable. If emit returns anything but 0 the sort stops. Return 0 on success, or -1 on
+ * error or if emit stopped the sort. */
+int external_sort(int in_fd, int out_fd, size_t size, compare_f compare, size_t memory)
+{
+    check(out_fd >= 0, "invalid output file descriptor");
+    return _external_sort(in_fd, size, compare, memory, out_fd, NULL, NULL);
+error:
+    return -1;
+}
+
+int external_sort_to(int in_fd, size_t size, compare_f compare, size_t memory,
+                     int (*emit)(const void *record, void *data), void *data)
+{
+    check_ptr(emit);
+    return _external_sort(in_fd, size, compare, memory, -1, emit, data);
+error:
+    return -1;
+}
@@ -0,0 +1,398 @@
+/*************************************************************************************************
+ *
+ * fhashmap.c
+ *
+ * Implementation of the unordered associative array abstraction in terms of a flat hash table
+ * with open addressing. Instead of chaining nodes in buckets, keys and values are stored inline
+ * in two slot arrays. A third array holds one control byte per slot that is either EMPTY,
+ * DELETED, or the lower 7 bits of the hash of the key stored in that slot. Slots are probed in
+ * aligned groups of FHASHMAP_GROUP_WIDTH: the control bytes of a group are compared with the hash
+ * tag all at once (with SSE2 if available), and only slots whose tag matches are compared with the
+ * key using the type interface. Lookups usually touch a single group and a single key.
+ *
+ ************************************************************************************************/
+
+#include <assert.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "check.h"
+#include "fhashmap.h"
+
+#define CTRL_EMPTY      ((int8_t)-128)
+#define CTRL_DELETED    ((int8_t)-2)
+
+#define fhashmap_h1(h)      ((size_t)((h) >> 7))
+#define fhashmap_h2(h)      ((int8_t)((h) & 0x7f))
+
+#define fhashmap_key(M, i)      ((void*)((M)->keys   + (i) * t_size((M)->key_type)))
+#define fhashmap_value(M, i)    ((void*)((M)->values + (i) * t_size((M)->value_type)))
+#define fhashmap_is_full(c)     ((c) >= 0)
+
+#define fhashmap_max_load(c)    ((c) / FHASHMAP_MAX_LOAD_DEN * FHASHMAP_MAX_LOAD_NUM)
+
+
+/* static inline uint32_t fhashmap_group_match(const int8_t *g, int8_t tag)
+ * static inline uint32_t fhashmap_group_match_empty(const int8_t *g)
+ * static inline uint32_t fhashmap_group_match_free(const int8_t *g)
+ * Compare the FHASHMAP_GROUP_WIDTH control bytes starting at g with tag, CTRL_EMPTY, or either of
+ * CTRL_EMPTY and CTRL_DELETED respectively. Return a bit mask where bit j is set if the control
+ * byte g[j] matches. */
+#ifdef __SSE2__
+
+static inline uint32_t fhashmap_group_match(const int8_t *g, int8_t tag)
+{
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)g);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(tag)));
+}
+
+static inline uint32_t fhashmap_group_match_empty(const int8_t *g)
+{
+    return fhashmap_group_match(g, CTRL_EMPTY);
+}
+
+static inline uint32_t fhashmap_group_match_free(const int8_t *g)
+{
+    /* EMPTY and DELETED are the only negative control bytes, so the sign bits are all we need. */
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)g);
+    return (uint32_t)_mm_movemask_epi8(ctrl);
+}
+
+#else /* portable fallback */
+
+static inline uint32_t fhashmap_group_match(const int8_t *g, int8_t tag)
+{
+    uint32_t bits = 0;
+    for (unsigned j = 0; j < FHASHMAP_GROUP_WIDTH; ++j) {
+        if (g[j] == tag) bits |= 1u << j;
+    }
+    return bits;
+}
+
+static inline uint32_t fhashmap_group_match_empty(const int8_t *g)
+{
+    return fhashmap_group_match(g, CTRL_EMPTY);
+}
+
+static inline uint32_t fhashmap_group_match_free(const int8_t *g)
+{
+    uint32_t bits = 0;
+    for (unsigned j = 0; j < FHASHMAP_GROUP_WIDTH; ++j) {
+        if (g[j] < 0) bits |= 1u << j;
+    }
+    return bits;
+}
+
+#endif /* __SSE2__ */
+
+/* static inline size_t fhashmap_find_slot(const fhashmap *M, const void *k, uint32_t h)
+ * Return the index of the slot holding the key k with the hash h, or SIZE_MAX if k isn't there.
+ * Groups are visited in triangular order, which covers all groups because their number is a
+ * power of two. The search ends at the first group that contains an empty slot. */
+static inline size_t fhashmap_find_slot(const fhashmap *M, const void *k, uint32_t h)
+{
+    assert(M && M->ctrl && k);
+
+    size_t n_groups = M->capacity / FHASHMAP_GROUP_WIDTH;
+    size_t g = fhashmap_h1(h) & (n_groups - 1);
+    int8_t tag = fhashmap_h2(h);
+
+    for (size_t step = 1; step <= n_groups; ++step) {
+        const int8_t *ctrl = M->ctrl + g * FHASHMAP_GROUP_WIDTH;
+        uint32_t bits = fhashmap_group_match(ctrl, tag);
+        while (bits) {
+            size_t i = g * FHASHMAP_GROUP_WIDTH + __builtin_ctz(bits);
+            if (t_compare(M->key_type, k, fhashmap_key(M, i)) == 0) return i;
+            bits &= bits - 1;
+        }
+        if (fhashmap_group_match_empty(ctrl)) break;
+        g = (g + step) & (n_groups - 1);
+    }
+
+    return SIZE_MAX;
+}
+
+/* static inline size_t fhashmap_find_free_slot(int8_t *ctrl, size_t capacity, uint32_t h)
+ * Return the index of the first empty or deleted slot in the probe sequence for h. There is
+ * always one because the load factor is kept below 1. */
+static inline size_t fhashmap_find_free_slot(const int8_t *ctrl, size_t capacity, uint32_t h)
+{
+    size_t n_groups = capacity / FHASHMAP_GROUP_WIDTH;
+    size_t g = fhashmap_h1(h) & (n_groups - 1);
+    uint32_t bits;
+
+    for (size_t step = 1; ; ++step) {
+        bits = fhashmap_group_match_free(ctrl + g * FHASHMAP_GROUP_WIDTH);
+        if (bits) return g * FHASHMAP_GROUP_WIDTH + __builtin_ctz(bits);
+        g = (g + step) & (n_groups - 1);
+    }
+}
+
+/* static void fhashmap_free_slots(fhashmap *M)
+ * Release the control bytes and slot arrays of M without touching the entries. */
+static void fhashmap_free_slots(fhashmap *M)
+{
+    a_deallocate(M->alloc, M->ctrl, M->capacity);
+    a_deallocate(M->alloc, M->keys, M->capacity * t_size(M->key_type));
+    a_deallocate(M->alloc, M->values, M->capacity * t_size(M->value_type));
+}
+
+/* static int fhashmap_rehash(fhashmap *M, size_t capacity)
+ * Allocate new slot arrays with the given capacity and move all entries there. This also purges
+ * all DELETED markers. Return 0 on success or -1 on error, in which case M is left unchanged. */
+static int fhashmap_rehash(fhashmap *M, size_t capacity)
+{
+    assert(M && capacity >= FHASHMAP_MIN_CAPACITY && capacity > M->count);
+
+    int8_t *ctrl = NULL;
+    char *keys = NULL;
+    char *values = NULL;
+
+    size_t ks = t_size(M->key_type);
+    size_t vs = t_size(M->value_type);
+
+    ctrl = a_allocate(M->alloc, capacity);
+    check(ctrl != NULL, "failed to allocate control bytes");
+    keys = a_allocate(M->alloc, capacity * ks);
+    check(keys != NULL, "failed to allocate key slots");
+    values = a_allocate(M->alloc, capacity * vs);
+    check(values != NULL || vs == 0, "failed to allocate value slots");
+
+    memset(ctrl, CTRL_EMPTY, capacity);
+
+    for (size_t i = 0; i < M->capacity; ++i) {
+        if (!fhashmap_is_full(M->ctrl[i])) continue;
+        uint32_t h = t_hash(M->key_type, fhashmap_key(M, i));
+        size_t j = fhashmap_find_free_slot(ctrl, capacity, h);
+        ctrl[j] = fhashmap_h2(h);
+        t_move(M->key_type,   keys   + j * ks, fhashmap_key(M, i));
+        t_move(M->value_type, values + j * vs, fhashmap_value(M, i));
+    }
+
+    fhashmap_free_slots(M);
+
+    M->ctrl = ctrl;
+    M->keys = keys;
+    M->values = values;
+    M->capacity = capacity;
+    M->n_deleted = 0;
+
+    return 0;
+error:
+    a_deallocate(M->alloc, ctrl, capacity);
+    a_deallocate(M->alloc, keys, capacity * ks);
+    a_deallocate(M->alloc, values, capacity * vs);
+    return -1;
+}
+
+/* int       fhashmap_initialize     (fhashmap *M, t_intf *kt, t_intf *vt)
+ * int       fhashmap_initialize_with(fhashmap *M, t_intf *kt, t_intf *vt, allocator *A)
+ * fhashmap *fhashmap_new            (             t_intf *kt, t_intf *vt)
+ * fhashmap_initialize initializes a hashmap at the address pointed to by M (assuming there's
+ * sufficient space). fhashmap_new allocates and initializes a new hashmap and returns a pointer
+ * to it. Both type interfaces must be given, and the type interface for keys must have a
+ * comparison function and a size. fhashmap_initialize_with takes the slot arrays from the
+ * allocator A instead of malloc. */
+int fhashmap_initialize(fhashmap *M, t_intf *kt, t_intf *vt)
+{
+    return fhashmap_initialize_with(M, kt, vt, NULL);
+}
+
+int fhashmap_initialize_with(fhashmap *M, t_intf *kt, t_intf *vt, allocator *A)
+{
+    check_ptr(M);
+    check_ptr(kt);
+    check_ptr(vt);
+    check(kt->compare, "no comparison function");
+    check(kt->size, "no key size");
+
+    M->key_type = kt;
+    M->value_type = vt;
+    M->count = 0;
+    M->n_deleted = 0;
+    M->capacity = 0;
+    M->ctrl = NULL;
+    M->keys = NULL;
+    M->values = NULL;
+    M->alloc = A ? A : &malloc_allocator;
+
+    int rc = fhashmap_rehash(M, FHASHMAP_MIN_CAPACITY);
+    check_rc(rc, "fhashmap_rehash");
+
+    return 0;
+error:
+    return -1;
+}
+
+fhashmap *fhashmap_new(t_intf *kt, t_intf *vt)
+{
+    fhashmap *M = calloc(1, sizeof(*M));
+    check_alloc(M);
+
+    int rc = fhashmap_initialize(M, kt, vt);
+    check(rc == 0, "failed to initialize hashmap");
+
+    return M;
+error:
+    if (M) free(M);
+    return NULL;
+}
+
+/* void fhashmap_clear(fhashmap *M)
+ * Destroy all entries and reset M. The capacity is retained. */
+void fhashmap_clear(fhashmap *M)
+{
+    if (M && M->ctrl) {
+        if (M->key_type->destroy || M->value_type->destroy) {
+            for (size_t i = 0; i < M->capacity; ++i) {
+                if (!fhashmap_is_full(M->ctrl[i])) continue;
+                t_destroy(M->key_type,   fhashmap_key(M, i));
+                t_destroy(M->value_type, fhashmap_value(M, i));
+            }
+        }
+        memset(M->ctrl, CTRL_EMPTY, M->capacity);
+        M->count = 0;
+        M->n_deleted = 0;
+    }
+}
+
+/* void fhashmap_destroy(fhashmap *M)
+ * void fhashmap_delete (fhashmap *M)
+ * Destroy M, freeing any associated memory. fhashmap_delete also calls free on M. */
+void fhashmap_destroy(fhashmap *M)
+{
+    if (M && M->ctrl) {
+        fhashmap_clear(M);
+        fhashmap_free_slots(M);
+        M->ctrl = NULL;
+        M->keys = M->values = NULL;
+        M->key_type = M->value_type = NULL;
+        M->capacity = 0;
+    }
+}
+
+void fhashmap_delete(fhashmap *M)
+{
+    if (M) {
+        fhashmap_destroy(M);
+        free(M);
+    }
+}
+
+/* int fhashmap_reserve(fhashmap *M, size_t n)
+ * Make sure that M can hold at least n entries without growing. Return 0 on success, or -1 on
+ * error. */
+int fhashmap_reserve(fhashmap *M, size_t n)
+{
+    check_ptr(M);
+
+    size_t c = FHASHMAP_MIN_CAPACITY;
+    while (fhashmap_max_load(c) < n) c <<= 1;
+
+    if (c > M->capacity) {
+        int rc = fhashmap_rehash(M, c);
+        check_rc(rc, "fhashmap_rehash");
+    }
+
+    return 0;
+error:
+    return -1;
+}
+
+/* int fhashmap_set(fhashmap *M, const void *k, const void *v)
+ * Set the value of the entry with the key k to v, or insert an entry with k and v if k doesn't
+ * exist. Return 1 if an entry was added, 0 if k was already there, or -1 on error. */
+int fhashmap_set(fhashmap *M, const void *k, const void *v)
+{
+    check_ptr(M);
+    check_ptr(k);
+    check_ptr(v);
+
+    uint32_t h = t_hash(M->key_type, k);
+    size_t i = fhashmap_find_slot(M, k, h);
+
+    if (i != SIZE_MAX) {
+        t_destroy(M->value_type, fhashmap_value(M, i));
+        t_copy(M->value_type, fhashmap_value(M, i), v);
+        return 0;
+    }
+
+    /* Make room if the new entry would push us over the maximum load. If at least half of the
+     * used slots are tombstones, rehashing in place is enough to get rid of them. */
+    if (M->count + M->n_deleted + 1 > fhashmap_max_load(M->capacity)) {
+        size_t c = M->capacity;
+        if (M->count + 1 > fhashmap_max_load(c) / 2) c <<= 1;
+        int rc = fhashmap_rehash(M, c);
+        check_rc(rc, "fhashmap_rehash");
+    }
+
+    i = fhashmap_find_free_slot(M->ctrl, M->capacity, h);
+    if (M->ctrl[i] == CTRL_DELETED) --M->n_deleted;
+    M->ctrl[i] = fhashmap_h2(h);
+    t_copy(M->key_type,   fhashmap_key(M, i),   k);
+    t_copy(M->value_type, fhashmap_value(M, i), v);
+    ++M->count;
+
+    return 1;
+error:
+    return -1;
+}
+
+/* int fhashmap_has(const fhashmap *M, const void *k)
+ * Check if an entry with the key k exists. */
+int fhashmap_has(const fhashmap *M, const void *k)
+{
+    check_ptr(M);
+    check_ptr(k);
+
+    return fhashmap_find_slot(M, k, t_hash(M->key_type, k)) != SIZE_MAX;
+error:
+    return -1;
+}
+
+/* void *fhashmap_get(fhashmap *M, const void *k)
+ * Return a pointer to the value mapped to k in M or NULL if k doesn't exist. The pointer is
+ * invalidated by the next insertion. */
+void *fhashmap_get(fhashmap *M, const void *k)
+{
+    check_ptr(M);
+    check_ptr(k);
+
+    size_t i = fhashmap_find_slot(M, k, t_hash(M->key_type, k));
+    if (i != SIZE_MAX) return fhashmap_value(M, i);
+
+error: /* fallthrough */
+    return NULL;
+}
+
+/* int fhashmap_remove(fhashmap *M, const void *k)
+ * Remove k from the map. Return 1 if an entry was deleted, 0 if k was not there, or -1 on error.
+ * The slot can be marked as EMPTY again if its group still has an empty slot: no probe sequence
+ * can then have passed through the group. Otherwise it becomes a DELETED tombstone. */
+int fhashmap_remove(fhashmap *M, const void *k)
+{
+    check_ptr(M);
+    check_ptr(k);
+
+    size_t i = fhashmap_find_slot(M, k, t_hash(M->key_type, k));
+    if (i == SIZE_MAX) return 0;
+
+    t_destroy(M->key_type,   fhashmap_key(M, i));
+    t_destroy(M->value_type, fhashmap_value(M, i));
+
+    const int8_t *group = M->ctrl + (i & ~(FHASHMAP_GROUP_WIDTH - 1));
+    if (fhashmap_group_match_empty(group)) {
+        M->ctrl[i] = CTRL_EMPTY;
+    } else {
+        M->ctrl[i] = CTRL_DELETED;
+        ++M->n_deleted;
+    }
+    --M->count;
+
+    return 1;
+error:
+    return -1;
+}
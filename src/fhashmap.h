@@ -0,0 +1,57 @@
+/*************************************************************************************************
+ *
+ * fhashmap.h
+ *
+ * Interface for a flat, open-addressing hashmap that supports arbitrary key/value types by way of
+ * type interfaces. Keys and values are stored inline in two slot arrays, and a parallel array of
+ * control bytes (one per slot) is probed in groups of FHASHMAP_GROUP_WIDTH, using SSE2 where
+ * available.
+ *
+ ************************************************************************************************/
+
+#ifndef _fhashmap_h
+#define _fhashmap_h
+
+#include <stdint.h>
+#include "allocator.h"
+#include "hash.h"
+#include "type_interface.h"
+
+#define FHASHMAP_GROUP_WIDTH    16lu
+#define FHASHMAP_MIN_CAPACITY   FHASHMAP_GROUP_WIDTH
+
+/* The table grows when more than FHASHMAP_MAX_LOAD_NUM / FHASHMAP_MAX_LOAD_DEN of its slots are
+ * either occupied or marked as deleted. */
+#define FHASHMAP_MAX_LOAD_NUM   7lu
+#define FHASHMAP_MAX_LOAD_DEN   8lu
+
+typedef struct fhashmap {
+    int8_t *        ctrl;       /* one control byte per slot */
+    char *          keys;       /* capacity * t_size(key_type) bytes */
+    char *          values;     /* capacity * t_size(value_type) bytes */
+    size_t          capacity;   /* power of two, multiple of FHASHMAP_GROUP_WIDTH */
+    size_t          count;
+    size_t          n_deleted;
+    t_intf *        key_type;
+    t_intf *        value_type;
+    allocator *     alloc;
+} fhashmap;
+
+#define fhashmap_count(M)       ((M)->count)
+#define fhashmap_capacity(M)    ((M)->capacity)
+
+int         fhashmap_initialize (fhashmap *M, t_intf *kt, t_intf *vt);
+int         fhashmap_initialize_with(fhashmap *M, t_intf *kt, t_intf *vt, allocator *A);
+fhashmap *  fhashmap_new        (             t_intf *kt, t_intf *vt);
+void        fhashmap_destroy    (fhashmap *M);
+void        fhashmap_delete     (fhashmap *M);
+
+void        fhashmap_clear      (fhashmap *M);
+int         fhashmap_reserve    (fhashmap *M, size_t n);
+
+int         fhashmap_set        (      fhashmap *M, const void *k, const void *v);
+int         fhashmap_remove     (      fhashmap *M, const void *k);
+int         fhashmap_has        (const fhashmap *M, const void *k);
+void *      fhashmap_get        (      fhashmap *M, const void *k);
+
+#endif // _fhashmap_h
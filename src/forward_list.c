@@ -28,16 +28,15 @@ error:
 
 #define flist_n_size(L) (sizeof(flist_n) + t_size((L)->data_type))
 
-/* static inline flist_n *flist_n_new(const flist *L, const void *v)
+/* static inline flist_n *flist_n_new(flist *L, const void *v)
  * Create a new node with the value v. Return a pointer to it or NULL on error. */
-static inline flist_n *flist_n_new(const flist *L, const void *v)
+static inline flist_n *flist_n_new(flist *L, const void *v)
 {
     assert(L && L->data_type && v);
-    size_t size = flist_n_size(L);
-    assert(size > sizeof(flist_n));
+    assert(flist_n_size(L) > sizeof(flist_n));
 
-    flist_n *n = calloc(1, size);
-    check_alloc(n);
+    flist_n *n = pool_alloc(&L->node_pool);
+    check(n != NULL, "failed to allocate node");
 
     t_copy(L->data_type, flist_n_data(n), v);
     n->has_data = 1;
@@ -48,13 +47,13 @@ error:
     return NULL;
 }
 
-/* static inline void flist_n_delete(const flist *L, flist_n *n)
+/* static inline void flist_n_delete(flist *L, flist_n *n)
  * Delete n, freeing any associated memory. */
-static inline void flist_n_delete(const flist *L, flist_n *n)
+static inline void flist_n_delete(flist *L, flist_n *n)
 {
     assert(L && L->data_type && n);
     if (n->has_data) t_destroy(L->data_type, flist_n_data(n));
-    free(n);
+    pool_free(&L->node_pool, n);
 }
 
 /* static void flist_n_set(const flist *L, flist_n *n, const void *v)
@@ -68,12 +67,19 @@ static void flist_n_set(const flist *L, flist_n *n, const void *v)
     n->has_data = 1;
 }
 
-/* int      flist_initialize(flist *L, t_intf *t)
- * flist *  flist_new       (          t_intf *t)
+/* int      flist_initialize     (flist *L, t_intf *t)
+ * int      flist_initialize_with(flist *L, t_intf *t, allocator *A)
+ * flist *  flist_new            (          t_intf *t)
  * flist_initialize initializes an flist at the address pointed to by L (assuming there's enough
  * space), and returns 0 on success or -1 on error. flist_new allocates and initializes a new
- * flist and returns a pointer to it or NULL on error. */
+ * flist and returns a pointer to it or NULL on error.
+ * flist_initialize_with takes its nodes from the allocator A instead of malloc. */
 int flist_initialize(flist *L, t_intf *dt)
+{
+    return flist_initialize_with(L, dt, NULL);
+}
+
+int flist_initialize_with(flist *L, t_intf *dt, allocator *A)
 {
     check_ptr(dt);
 
@@ -81,6 +87,9 @@ int flist_initialize(flist *L, t_intf *dt)
     L->count = 0;
     L->data_type = dt;
 
+    int rc = pool_initialize(&L->node_pool, flist_n_size(L), A);
+    check_rc(rc, "pool_initialize");
+
     assert(flist_invariant(L) == 0);
     return 0;
 error:
@@ -108,13 +117,14 @@ void flist_clear(flist *L)
     if (L) {
         assert(flist_invariant(L) == 0);
 
-        flist_n *cur;
-        flist_n *next;
-
-        for (cur = L->front; cur != NULL; cur = next) {
-            next = cur->next;
-            flist_n_delete(L, cur);
+        /* Payloads that need destruction are destroyed one by one, but the nodes themselves are
+         * released in bulk with their pool. */
+        if (L->data_type->destroy) {
+            for (flist_n *cur = L->front; cur != NULL; cur = cur->next) {
+                if (cur->has_data) t_destroy(L->data_type, flist_n_data(cur));
+            }
         }
+        pool_clear(&L->node_pool);
         L->front = NULL;
         L->count = 0;
     }
@@ -126,7 +136,8 @@ void flist_clear(flist *L)
 void flist_destroy(flist *L)
 {
     if (L) {
-        if (flist_count(L)) flist_clear(L);
+        flist_clear(L);
+        pool_destroy(&L->node_pool);
         L->data_type = NULL;
     }
 }
@@ -134,7 +145,8 @@ void flist_destroy(flist *L)
 void flist_delete(flist *L)
 {
     if (L) {
-        if (flist_count(L)) flist_clear(L);
+        flist_clear(L);
+        pool_destroy(&L->node_pool);
         free(L);
     }
 }
@@ -14,6 +14,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include "pool.h"
 #include "type_interface.h"
 
 struct flist_n;
@@ -26,6 +27,7 @@ typedef struct flist {
     flist_n *front;
     size_t count;
     t_intf *data_type;
+    pool node_pool;
 } flist;
 
 #define flist_n_data(n)   (void*)((char*)n + sizeof(flist_n))
@@ -35,6 +37,7 @@ typedef struct flist {
 #define flist_empty(L)   ((L)->count == 0)
 
 int     flist_initialize     (flist *L, t_intf *t);
+int     flist_initialize_with(flist *L, t_intf *t, allocator *A);
 flist * flist_new            (t_intf *data_type);
 void    flist_destroy        (flist *L);
 void    flist_delete         (flist *L);
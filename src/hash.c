@@ -1,12 +1,17 @@
 /*************************************************************************************************
  *
  * hash.c
- * Implementation of the Jenkins hashing algorithm.
+ * Implementation of the Jenkins hashing algorithm and of wyhash (Wang Yi, public domain). Jenkins
+ * processes one byte per iteration with a serial dependency chain. wyhash consumes 8 to 48 bytes
+ * per iteration, mixing them with 64x64->128 bit multiplications.
  *
  ************************************************************************************************/
 
+#include <string.h>
 #include "hash.h"
 
+uint64_t hash_seed = HASH_DEFAULT_SEED;
+
 uint32_t jenkins_hash(const void *obj, const size_t size)
 {
     uint32_t hash = 0;
@@ -23,3 +28,118 @@ uint32_t jenkins_hash(const void *obj, const size_t size)
 
     return hash;
 }
+
+static const uint64_t wy_p[4] = {
+    0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+};
+
+/* static inline void wy_mum(uint64_t *a, uint64_t *b)
+ * Multiply a and b to a 128 bit product, store the lower half in a and the upper half in b. */
+static inline void wy_mum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = *a;
+    r *= *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    *a = lo;
+    *b = hi;
+#endif
+}
+
+static inline uint64_t wy_mix(uint64_t a, uint64_t b)
+{
+    wy_mum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t wy_r8(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint64_t wy_r4(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint64_t wy_r3(const uint8_t *p, size_t k)
+{
+    return (((uint64_t)p[0]) << 16) | (((uint64_t)p[k >> 1]) << 8) | p[k - 1];
+}
+
+/* uint64_t wyhash(const void *obj, const size_t size, uint64_t seed)
+ * Hash size bytes at obj. Keys of up to 16 bytes are read with at most four overlapping loads and
+ * no loop; longer keys are consumed 48 bytes per iteration in three independent lanes. */
+uint64_t wyhash(const void *obj, const size_t size, uint64_t seed)
+{
+    const uint8_t *p = obj;
+    uint64_t a, b;
+
+    seed ^= wy_mix(seed ^ wy_p[0], wy_p[1]);
+
+    if (size <= 16) {
+        if (size >= 4) {
+            a = (wy_r4(p) << 32) | wy_r4(p + ((size >> 3) << 2));
+            b = (wy_r4(p + size - 4) << 32) | wy_r4(p + size - 4 - ((size >> 3) << 2));
+        } else if (size > 0) {
+            a = wy_r3(p, size);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = size;
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = wy_mix(wy_r8(p)      ^ wy_p[1], wy_r8(p + 8)  ^ seed);
+                see1 = wy_mix(wy_r8(p + 16) ^ wy_p[2], wy_r8(p + 24) ^ see1);
+                see2 = wy_mix(wy_r8(p + 32) ^ wy_p[3], wy_r8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = wy_mix(wy_r8(p) ^ wy_p[1], wy_r8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wy_r8(p + i - 16);
+        b = wy_r8(p + i - 8);
+    }
+
+    a ^= wy_p[1];
+    b ^= seed;
+    wy_mum(&a, &b);
+    return wy_mix(a ^ wy_p[0] ^ size, b ^ wy_p[1]);
+}
+
+/* uint64_t wyhash_u32(uint32_t k, uint64_t seed)
+ * uint64_t wyhash_u64(uint64_t k, uint64_t seed)
+ * Fast paths for fixed-size keys: a single 128 bit multiplication plus a final mix. */
+uint64_t wyhash_u32(uint32_t k, uint64_t seed)
+{
+    return wyhash_u64(k, seed);
+}
+
+uint64_t wyhash_u64(uint64_t k, uint64_t seed)
+{
+    uint64_t a = k ^ wy_p[0];
+    uint64_t b = seed ^ wy_p[1];
+    wy_mum(&a, &b);
+    return wy_mix(a ^ wy_p[0], b ^ wy_p[1]);
+}
@@ -1,7 +1,8 @@
 /*************************************************************************************************
  *
  * hash.h
- * Jenkins hashing algorithm.
+ * Hash functions: the Jenkins one-at-a-time algorithm, and the word-at-a-time wyhash family with
+ * a seed and dedicated fast paths for fixed 4- and 8-byte keys.
  *
  ************************************************************************************************/
 
@@ -11,6 +12,20 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#define HASH_DEFAULT_SEED 0x9e3779b97f4a7c15ull
+
+/* The seed used by the predefined hash functions in the library. Setting it to a random value at
+ * startup protects maps with untrusted keys against hash flooding. It must not be changed while
+ * any hashmap exists. */
+extern uint64_t hash_seed;
+
+/* Fold a 64-bit hash into 32 bits without losing the entropy of the upper half. */
+#define hash_fold(h) ((uint32_t)((h) ^ ((h) >> 32)))
+
 uint32_t jenkins_hash(const void *obj, const size_t size);
 
+uint64_t wyhash      (const void *obj, const size_t size, uint64_t seed);
+uint64_t wyhash_u32  (uint32_t k, uint64_t seed);
+uint64_t wyhash_u64  (uint64_t k, uint64_t seed);
+
 #endif /* _hash_h */
@@ -4,7 +4,13 @@
  *
  * Implementation of the unordered associative array abstraction, using hashing to distribute keys
  * over linked lists of key-value pairs. Arbitrary key/value types are supported by way of type
- * interface structs.
+ * interface structs. The number of buckets is always a power of two, so the bucket index is the
+ * hash masked with n_buckets - 1. The bucket array doubles when the average chain length exceeds
+ * the maximum load factor and halves when it drops below a quarter of it, though never below the
+ * size asked for with hashmap_reserve. Maps initialized with HASHMAP_INCREMENTAL keep the previous
+ * bucket array around after a resize and migrate HASHMAP_REHASH_STEP of its buckets (more if the
+ * maximum load is small) with each set/get/remove, so no single operation has to relink the whole
+ * table. Lookups consult the unmigrated part of the old array first.
  *
  * Author: Florian Kretlow, 2020
  * Licensed under the MIT License.
@@ -22,17 +28,24 @@
 #define hashmap_n_key(M, n)      ((void*)(((char *)(n)) + sizeof(hashmap_n)))
 #define hashmap_n_value(M, n)    ((void*)((char *)(n)) + sizeof(hashmap_n) + t_size((M)->key_type))
 
+#define hashmap_index(M, h)      ((size_t)(h) & ((M)->n_buckets - 1))
 
-/* static inline hashmap_n *hashmap_n_new(const hashmap *M, const void *k, const void *v)
- * Create a new node on the heap, copy k and v into it, and return a pointer to it or NULL on
+/* Bucket arrays come from the same allocator as the nodes. */
+#define hashmap_alloc_buckets(M, n) \
+    ((hashmap_n **)a_callocate((M)->node_pool.alloc, (n) * sizeof(hashmap_n *)))
+#define hashmap_free_buckets(M, b, n) \
+    a_deallocate((M)->node_pool.alloc, (b), (n) * sizeof(hashmap_n *))
+
+
+/* static inline hashmap_n *hashmap_n_new(hashmap *M, const void *k, const void *v)
+ * Create a new node in the node pool of M, copy k and v into it, and return a pointer to it or NULL on
  * error. Both k and v must be given, because a hashmap entry without either doesn't make sense.
  * */
-static inline hashmap_n *hashmap_n_new(const hashmap *M, const void *k, const void *v)
+static inline hashmap_n *hashmap_n_new(hashmap *M, const void *k, const void *v)
 {
     assert(M && M->key_type && k && M->value_type && v);
-    size_t size = hashmap_n_size(M);
-    hashmap_n *n = calloc(1, size);
-    check_alloc(n);
+    hashmap_n *n = pool_alloc(&M->node_pool);
+    check(n != NULL, "failed to allocate node");
 
     t_copy(M->key_type,   hashmap_n_key(M, n),   k);
     t_copy(M->value_type, hashmap_n_value(M, n), v);
@@ -42,14 +55,14 @@ error:
     return NULL;
 }
 
-/* static inline void hashmap_n_delete(const hashmap *M, hashmap_n *n)
- * Delete n, destroying stored data and freeing all associated memory. */
-static inline void hashmap_n_delete(const hashmap *M, hashmap_n *n)
+/* static inline void hashmap_n_delete(hashmap *M, hashmap_n *n)
+ * Delete n, destroying stored data and returning the node to the pool. */
+static inline void hashmap_n_delete(hashmap *M, hashmap_n *n)
 {
     if (n) {
         t_destroy(M->key_type,   hashmap_n_key(M, n));
         t_destroy(M->value_type, hashmap_n_value(M, n));
-        free(n);
+        pool_free(&M->node_pool, n);
     }
 }
 
@@ -63,14 +76,186 @@ static inline void hashmap_n_set_value(const hashmap *M, hashmap_n *n, const voi
     t_copy(M->value_type, hashmap_n_value(M, n), v);
 }
 
-/* int      hashmap_initialize(hashmap *M, t_intf *kt, t_intf *vt)
- * hashmap *hashmap_new       (            t_intf *kt, t_intf *vt)
+/* static size_t hashmap_n_buckets_for(const hashmap *M, size_t n)
+ * Return the smallest power of two that is at least HASHMAP_MIN_BUCKETS and large enough to hold
+ * n entries without exceeding the maximum load factor of M. */
+static size_t hashmap_n_buckets_for(const hashmap *M, size_t n)
+{
+    size_t c = HASHMAP_MIN_BUCKETS;
+    while ((float)n > (float)c * M->max_load && c < (SIZE_MAX >> 1)) c <<= 1;
+    return c;
+}
+
+/* static inline void hashmap_relink_chain(hashmap_n *n, hashmap_n **buckets, size_t n_buckets)
+ * Move the chain of nodes starting at n into the bucket array buckets of size n_buckets. No
+ * nodes are allocated or copied, and keys are not hashed again: the cached hashes are used. */
+static inline void hashmap_relink_chain(hashmap_n *n, hashmap_n **buckets, size_t n_buckets)
+{
+    hashmap_n *next;
+    size_t j;
+    while (n) {
+        next = n->next;
+        j = n->hash & (n_buckets - 1);
+        n->next = buckets[j];
+        buckets[j] = n;
+        n = next;
+    }
+}
+
+/* static void hashmap_rehash_step(hashmap *M, size_t n)
+ * Migrate up to n buckets from the old bucket array to the current one. Release the old array
+ * once it has been emptied. */
+static void hashmap_rehash_step(hashmap *M, size_t n)
+{
+    assert(M && M->old_buckets);
+
+    for ( ; n > 0 && M->rehash_pos < M->n_old_buckets; --n, ++M->rehash_pos) {
+        hashmap_relink_chain(M->old_buckets[M->rehash_pos], M->buckets, M->n_buckets);
+        M->old_buckets[M->rehash_pos] = NULL;
+    }
+
+    if (M->rehash_pos == M->n_old_buckets) {
+        hashmap_free_buckets(M, M->old_buckets, M->n_old_buckets);
+        M->old_buckets = NULL;
+        M->n_old_buckets = 0;
+        M->rehash_pos = 0;
+    }
+}
+
+/* static size_t hashmap_rehash_quota(const hashmap *M)
+ * Return the number of old buckets to migrate in the next operation: HASHMAP_REHASH_STEP, or more
+ * if that wouldn't finish the migration before the insertion or removal that resizes M again.
+ * With a small maximum load the next resize comes sooner. */
+static size_t hashmap_rehash_quota(const hashmap *M)
+{
+    size_t remaining = M->n_old_buckets - M->rehash_pos;
+    float limit = (float)M->n_buckets * M->max_load;
+
+    /* The number of insertions and removals that don't resize. */
+    float headroom = limit - (float)M->count;
+    if (M->n_buckets > M->min_buckets && (float)M->count - limit / 4 < headroom) {
+        headroom = (float)M->count - limit / 4;
+    }
+    if (headroom < 1.0f) return remaining;
+
+    size_t ops = (size_t)headroom;
+    size_t quota = (remaining + ops - 1) / ops;
+    return quota > HASHMAP_REHASH_STEP ? quota : HASHMAP_REHASH_STEP;
+}
+
+/* static int hashmap_rehash(hashmap *M, size_t n_buckets)
+ * Allocate a new bucket array with n_buckets buckets (a power of two) and relink all nodes into
+ * it at once, including those still waiting in the old array of an incremental rehash. Return 0
+ * on success or -1 on error, in which case M is left unchanged. */
+static int hashmap_rehash(hashmap *M, size_t n_buckets)
+{
+    assert(M && n_buckets >= HASHMAP_MIN_BUCKETS && !(n_buckets & (n_buckets - 1)));
+
+    hashmap_n **buckets = hashmap_alloc_buckets(M, n_buckets);
+    check(buckets != NULL, "failed to allocate bucket array");
+
+    if (M->old_buckets) {
+        for (size_t i = M->rehash_pos; i < M->n_old_buckets; ++i) {
+            hashmap_relink_chain(M->old_buckets[i], buckets, n_buckets);
+        }
+        hashmap_free_buckets(M, M->old_buckets, M->n_old_buckets);
+        M->old_buckets = NULL;
+        M->n_old_buckets = 0;
+        M->rehash_pos = 0;
+    }
+
+    for (size_t i = 0; i < M->n_buckets; ++i) {
+        hashmap_relink_chain(M->buckets[i], buckets, n_buckets);
+    }
+
+    hashmap_free_buckets(M, M->buckets, M->n_buckets);
+    M->buckets = buckets;
+    M->n_buckets = n_buckets;
+
+    return 0;
+error:
+    return -1;
+}
+
+/* static int hashmap_resize(hashmap *M, size_t n_buckets)
+ * Change the number of buckets to n_buckets. Without HASHMAP_INCREMENTAL this is a plain rehash.
+ * Otherwise the current bucket array becomes the old one and its nodes are migrated a few buckets
+ * at a time by subsequent operations. A migration that is still in progress is completed first;
+ * hashmap_rehash_quota paces migrations so that this only happens after hashmap_reserve or
+ * hashmap_set_max_load.
+ * Return 0 on success or -1 on error, in which case M is left unchanged. */
+static int hashmap_resize(hashmap *M, size_t n_buckets)
+{
+    if (!(M->flags & HASHMAP_INCREMENTAL)) return hashmap_rehash(M, n_buckets);
+
+    hashmap_n **buckets = hashmap_alloc_buckets(M, n_buckets);
+    check(buckets != NULL, "failed to allocate bucket array");
+
+    if (M->old_buckets) hashmap_rehash_step(M, SIZE_MAX);
+
+    M->old_buckets = M->buckets;
+    M->n_old_buckets = M->n_buckets;
+    M->rehash_pos = 0;
+    M->buckets = buckets;
+    M->n_buckets = n_buckets;
+
+    return 0;
+error:
+    return -1;
+}
+
+/* static void hashmap_destroy_chains(hashmap *M, hashmap_n **buckets, size_t n_buckets)
+ * Destroy the data of all nodes in the given bucket array if the type interfaces have destructors,
+ * and empty all buckets. The nodes themselves are left to be released in bulk with the pool. */
+static void hashmap_destroy_chains(hashmap *M, hashmap_n **buckets, size_t n_buckets)
+{
+    if (M->key_type->destroy || M->value_type->destroy) {
+        for (size_t i = 0; i < n_buckets; ++i) {
+            for (hashmap_n *n = buckets[i]; n != NULL; n = n->next) {
+                t_destroy(M->key_type,   hashmap_n_key(M, n));
+                t_destroy(M->value_type, hashmap_n_value(M, n));
+            }
+        }
+    }
+    memset(buckets, 0, n_buckets * sizeof(*buckets));
+}
+
+/* static void hashmap_delete_nodes(hashmap *M)
+ * Delete all nodes in M, leaving all buckets empty and abandoning any incremental rehash. */
+static void hashmap_delete_nodes(hashmap *M)
+{
+    hashmap_destroy_chains(M, M->buckets, M->n_buckets);
+    if (M->old_buckets) {
+        hashmap_destroy_chains(M, M->old_buckets, M->n_old_buckets);
+        hashmap_free_buckets(M, M->old_buckets, M->n_old_buckets);
+        M->old_buckets = NULL;
+        M->n_old_buckets = 0;
+        M->rehash_pos = 0;
+    }
+    pool_clear(&M->node_pool);
+    M->count = 0;
+}
+
+/* int      hashmap_initialize     (hashmap *M, t_intf *kt, t_intf *vt, uint8_t flags)
+ * int      hashmap_initialize_with(hashmap *M, t_intf *kt, t_intf *vt, uint8_t flags,
+ *                                  allocator *A)
+ * hashmap *hashmap_new            (            t_intf *kt, t_intf *vt, uint8_t flags)
  * hashmap_initialize initializes a hashmap at the address pointed to by M (assuming there's
  * sufficient space). hashmap_new allocates and initializes a new hashmap and returns a pointer to
  * it. Both type interfaces must be given, and the type interface for keys must have a comparison
- * function and a hash function. */
-int hashmap_initialize(hashmap *M, t_intf *kt, t_intf *vt)
+ * function and a hash function. With HASHMAP_INCREMENTAL in flags, growing and shrinking the
+ * bucket array is spread over subsequent set/get/remove operations instead of being done at
+ * once. hashmap_initialize_with takes nodes and bucket arrays from the allocator A instead of
+ * malloc. */
+int hashmap_initialize(hashmap *M, t_intf *kt, t_intf *vt, uint8_t flags)
 {
+    return hashmap_initialize_with(M, kt, vt, flags, NULL);
+}
+
+int hashmap_initialize_with(hashmap *M, t_intf *kt, t_intf *vt, uint8_t flags, allocator *A)
+{
+    check_ptr(M);
+    M->buckets = NULL;
     check_ptr(kt);
     check_ptr(vt);
     check(kt->compare, "no comparison function");
@@ -79,23 +264,30 @@ int hashmap_initialize(hashmap *M, t_intf *kt, t_intf *vt)
     M->key_type = kt;
     M->value_type = vt;
     M->count = 0;
+    M->max_load = HASHMAP_DEFAULT_MAX_LOAD;
+    M->flags = flags;
+    M->old_buckets = NULL;
+    M->n_old_buckets = 0;
+    M->rehash_pos = 0;
+
+    int rc = pool_initialize(&M->node_pool, hashmap_n_size(M), A);
+    check_rc(rc, "pool_initialize");
 
-    M->n_buckets = MAP_N_BUCKETS;
-    M->buckets = calloc(M->n_buckets, sizeof(*M->buckets));
-    check_alloc(M->buckets);
+    M->n_buckets = M->min_buckets = HASHMAP_MIN_BUCKETS;
+    M->buckets = hashmap_alloc_buckets(M, M->n_buckets);
+    check(M->buckets != NULL, "failed to allocate bucket array");
 
     return 0;
 error:
-    if (M->buckets) free(M->buckets);
     return -1;
 }
 
-hashmap *hashmap_new(t_intf *kt, t_intf *vt)
+hashmap *hashmap_new(t_intf *kt, t_intf *vt, uint8_t flags)
 {
     hashmap *M = calloc(1, sizeof(*M));
     check_alloc(M);
 
-    int rc = hashmap_initialize(M, kt, vt);
+    int rc = hashmap_initialize(M, kt, vt, flags);
     check(rc == 0, "failed to initialize hashmap");
 
     return M;
@@ -105,22 +297,17 @@ error:
 }
 
 /* void hashmap_clear(hashmap *M)
- * Delete all entries, releasing associated memory, and reset M. */
+ * Delete all entries, releasing associated memory, and contract M to the initial number of
+ * buckets. This also drops any reservation made with hashmap_reserve. */
 void hashmap_clear(hashmap *M)
 {
     if (M && M->buckets) {
-        hashmap_n *cur;
-        hashmap_n *next;
-        for (unsigned short i = 0; i < M->n_buckets; ++i) {
-            cur = M->buckets[i];
-            while (cur != NULL) {
-                next = cur->next;
-                hashmap_n_delete(M, cur);
-                cur = next;
-            }
-            M->buckets[i] = NULL;
+        hashmap_delete_nodes(M);
+        M->min_buckets = HASHMAP_MIN_BUCKETS;
+        if (M->n_buckets > HASHMAP_MIN_BUCKETS) {
+            int rc = hashmap_rehash(M, HASHMAP_MIN_BUCKETS);
+            if (rc < 0) log_warn("failed to contract bucket array");
         }
-        M->count = 0;
     }
 }
 
@@ -130,8 +317,10 @@ void hashmap_clear(hashmap *M)
 void hashmap_destroy(hashmap *M)
 {
     if (M && M->buckets) {
-        hashmap_clear(M);
-        free(M->buckets);
+        hashmap_delete_nodes(M);
+        hashmap_free_buckets(M, M->buckets, M->n_buckets);
+        pool_destroy(&M->node_pool);
+        M->buckets = NULL;
         M->key_type = M->value_type = NULL;
         M->n_buckets = 0;
     }
@@ -140,26 +329,89 @@ void hashmap_destroy(hashmap *M)
 void hashmap_delete(hashmap *M)
 {
     if (M) {
-        if (M->buckets) {
-            hashmap_clear(M);
-            free(M->buckets);
-        }
+        hashmap_destroy(M);
         free(M);
     }
 }
 
-/* static inline hashmap_n *hashmap_find_node(const hashmap *M, const void *k, unsigned short i)
- * Find the node with the key k in the bucket at index i. Return NULL if it's not there. */
-static inline hashmap_n *hashmap_find_node(const hashmap *M, const void *k, unsigned short i)
+/* static int hashmap_grow_for(hashmap *M, size_t n)
+ * Grow the bucket array so that M can hold at least n entries without exceeding its maximum load
+ * factor. Return 0 on success, or -1 on error. */
+static int hashmap_grow_for(hashmap *M, size_t n)
+{
+    size_t c = hashmap_n_buckets_for(M, n);
+    if (c > M->n_buckets) {
+        int rc = hashmap_resize(M, c);
+        check_rc(rc, "hashmap_resize");
+    }
+    return 0;
+error:
+    return -1;
+}
+
+/* int hashmap_reserve(hashmap *M, size_t n)
+ * Grow the bucket array so that M can hold at least n entries without exceeding its maximum load
+ * factor. Never shrinks, and removals won't shrink M below that size either until the next
+ * hashmap_clear. Return 0 on success, or -1 on error. */
+int hashmap_reserve(hashmap *M, size_t n)
 {
-    assert(M && M->key_type && k && i < M->n_buckets);
+    check_ptr(M);
 
-    hashmap_n *n = M->buckets[i];
-    while (n) {
-        if (t_compare(M->key_type, k, hashmap_n_key(M, n)) == 0) return n;
-        n = n->next;
+    int rc = hashmap_grow_for(M, n);
+    check_rc(rc, "hashmap_grow_for");
+
+    size_t c = hashmap_n_buckets_for(M, n);
+    if (c > M->min_buckets) M->min_buckets = c;
+
+    return 0;
+error:
+    return -1;
+}
+
+/* int hashmap_set_max_load(hashmap *M, float max_load)
+ * Set the maximum average number of entries per bucket. M grows when an insertion pushes the load
+ * above max_load, and shrinks when a removal drops it below a quarter of max_load. Grows M
+ * immediately if the current load exceeds the new limit. Return 0 on success, or -1 on error. */
+int hashmap_set_max_load(hashmap *M, float max_load)
+{
+    check_ptr(M);
+    check(max_load > 0.0f, "invalid maximum load factor: %f", max_load);
+
+    M->max_load = max_load;
+    return hashmap_grow_for(M, M->count);
+error:
+    return -1;
+}
+
+/* static inline hashmap_n **hashmap_find_link(const hashmap *M, const void *k, uint32_t h)
+ * Find the node with the key k and the hash h. Return a pointer to the link that points to it
+ * (either a bucket or the next field of its predecessor), so that the caller can unlink it. If k
+ * isn't there, the returned link points to NULL. While an incremental rehash is in progress, the
+ * key may still be in its bucket in the old array if that bucket hasn't been migrated yet. Keys
+ * are only compared if the cached hash of a node matches h. */
+static inline hashmap_n **hashmap_find_link(const hashmap *M, const void *k, uint32_t h)
+{
+    assert(M && M->key_type && k);
+
+    hashmap_n **np;
+
+    if (M->old_buckets) {
+        size_t i = h & (M->n_old_buckets - 1);
+        if (i >= M->rehash_pos) {
+            np = &M->old_buckets[i];
+            while (*np && ((*np)->hash != h
+                           || t_compare(M->key_type, k, hashmap_n_key(M, *np)) != 0)) {
+                np = &(*np)->next;
+            }
+            if (*np) return np;
+        }
     }
-    return NULL;
+
+    np = &M->buckets[hashmap_index(M, h)];
+    while (*np && ((*np)->hash != h || t_compare(M->key_type, k, hashmap_n_key(M, *np)) != 0)) {
+        np = &(*np)->next;
+    }
+    return np;
 }
 
 /* int hashmap_set(hashmap *M, const void *k, const void *v)
@@ -168,19 +420,32 @@ static inline hashmap_n *hashmap_find_node(const hashmap *M, const void *k, unsi
 int hashmap_set(hashmap *M, const void *k, const void *v)
 {
     check_ptr(M);
+    check_ptr(k);
 
-    unsigned short i = t_hash(M->key_type, k) % MAP_N_BUCKETS;
-    hashmap_n *n = hashmap_find_node(M, k, i);
+    if (M->old_buckets) hashmap_rehash_step(M, hashmap_rehash_quota(M));
 
-    if (n) {
-        hashmap_n_set_value(M, n, v);
+    uint32_t h = t_hash(M->key_type, k);
+    hashmap_n **np = hashmap_find_link(M, k, h);
+
+    if (*np) {
+        hashmap_n_set_value(M, *np, v);
         return 0;
     } else {
-        n = hashmap_n_new(M, k, v);
+        /* New nodes always go into the current bucket array. */
+        size_t i = hashmap_index(M, h);
+        hashmap_n *n = hashmap_n_new(M, k, v);
         check(n != NULL, "failed to create new node");
+        n->hash = h;
         n->next = M->buckets[i];
         M->buckets[i] = n;
         ++M->count;
+
+        /* Grow if we exceed the maximum load. The entry is in place either way, so failure to
+         * grow is not an error. */
+        if ((float)M->count > (float)M->n_buckets * M->max_load) {
+            int rc = hashmap_resize(M, M->n_buckets << 1);
+            if (rc < 0) log_warn("failed to expand bucket array");
+        }
         return 1;
     }
 
@@ -195,9 +460,8 @@ int hashmap_has(const hashmap *M, const void *k)
     check_ptr(M);
     check_ptr(k);
 
-    unsigned short i = t_hash(M->key_type, k) % MAP_N_BUCKETS;
-    hashmap_n *n = hashmap_find_node(M, k, i);
-    return n ? 1 : 0;
+    hashmap_n **np = hashmap_find_link(M, k, t_hash(M->key_type, k));
+    return *np ? 1 : 0;
 
 error:
     return -1;
@@ -210,9 +474,10 @@ void *hashmap_get(hashmap *M, const void *k)
     check_ptr(M);
     check_ptr(k);
 
-    unsigned short i = t_hash(M->key_type, k) % MAP_N_BUCKETS;
-    hashmap_n *n = hashmap_find_node(M, k, i);
-    if (n)  return hashmap_n_value(M, n);
+    if (M->old_buckets) hashmap_rehash_step(M, hashmap_rehash_quota(M));
+
+    hashmap_n **np = hashmap_find_link(M, k, t_hash(M->key_type, k));
+    if (*np) return hashmap_n_value(M, *np);
 
 error: /* fallthrough */
     return NULL;
@@ -225,20 +490,23 @@ int hashmap_remove(hashmap *M, const void *k)
     check_ptr(M);
     check_ptr(k);
 
-    unsigned short i = t_hash(M->key_type, k) % MAP_N_BUCKETS;
-    hashmap_n *node = M->buckets[i];
-    hashmap_n *prev = NULL;
+    if (M->old_buckets) hashmap_rehash_step(M, hashmap_rehash_quota(M));
 
-    while (node && t_compare(M->key_type, k, hashmap_n_key(M, node)) != 0) {
-        prev = node;
-        node = node->next;
-    }
+    hashmap_n **np = hashmap_find_link(M, k, t_hash(M->key_type, k));
+    hashmap_n *node = *np;
 
     if (node) {
-        if (prev)   prev->next    = node->next;
-        else        M->buckets[i] = node->next;
+        *np = node->next;
         hashmap_n_delete(M, node);
         --M->count;
+
+        /* Contract if we drop below a quarter of the maximum load, but not below the size
+         * reserved with hashmap_reserve. */
+        if (M->n_buckets > M->min_buckets
+                && (float)M->count < (float)M->n_buckets * M->max_load / 4) {
+            int rc = hashmap_resize(M, M->n_buckets >> 1);
+            if (rc < 0) log_warn("failed to contract bucket array");
+        }
         return 1;
     } else {
         return 0;
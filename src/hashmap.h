@@ -12,32 +12,53 @@
 #ifndef _hashmap_h
 #define _hashmap_h
 
+#include <stdint.h>
 #include "hash.h"
+#include "pool.h"
 #include "type_interface.h"
 
-#define MAP_N_BUCKETS 512
+#define HASHMAP_MIN_BUCKETS         16lu
+#define HASHMAP_DEFAULT_MAX_LOAD    1.0f
+#define HASHMAP_REHASH_STEP         8lu     /* min. buckets migrated per operation */
+
+enum hashmap_flags { HASHMAP_INCREMENTAL = 1 };
 
 struct hashmap_n;
 typedef struct hashmap_n {
     struct hashmap_n *   next;
+    uint32_t             hash;      /* full hash of the key, cached */
 } hashmap_n;
 
 typedef struct hashmap {
     hashmap_n **    buckets;
-    unsigned short  n_buckets;
+    size_t          n_buckets;      /* always a power of two */
+    size_t          min_buckets;    /* removals don't shrink below this, see hashmap_reserve */
     size_t          count;
+    float           max_load;       /* maximum average number of entries per bucket */
+    uint8_t         flags;
+    hashmap_n **    old_buckets;    /* non-NULL while an incremental rehash is in progress */
+    size_t          n_old_buckets;
+    size_t          rehash_pos;     /* old buckets below this index have been migrated */
     t_intf *        key_type;
     t_intf *        value_type;
+    pool            node_pool;
 } hashmap;
 
-#define hashmap_count(M) ((M)->count)
+#define hashmap_count(M)        ((M)->count)
+#define hashmap_n_buckets(M)    ((M)->n_buckets)
+#define hashmap_load(M)         ((float)(M)->count / (M)->n_buckets)
+#define hashmap_rehashing(M)    ((M)->old_buckets != NULL)
 
-int         hashmap_initialize (hashmap *M, t_intf *kt, t_intf *vt);
-hashmap *   hashmap_new        (            t_intf *kt, t_intf *vt);
+int         hashmap_initialize (hashmap *M, t_intf *kt, t_intf *vt, uint8_t flags);
+int         hashmap_initialize_with(hashmap *M, t_intf *kt, t_intf *vt, uint8_t flags,
+                                    allocator *A);
+hashmap *   hashmap_new        (            t_intf *kt, t_intf *vt, uint8_t flags);
 void        hashmap_destroy    (hashmap *M);
 void        hashmap_delete     (hashmap *M);
 
 void        hashmap_clear      (hashmap *M);
+int         hashmap_reserve    (hashmap *M, size_t n);
+int         hashmap_set_max_load(hashmap *M, float max_load);
 
 int         hashmap_set        (      hashmap *M, const void *k, const void *v);
 int         hashmap_remove     (      hashmap *M, const void *k);
@@ -41,39 +41,45 @@ void make_heap(char *base, const size_t n, const size_t size,
 }
 
 /* Make the element at index i move up the heap until it sits where it belongs. Used to repair the
- * heap after inserting an element at the end of the array. */
+ * heap after inserting an element at the end of the array. Instead of swapping the element with
+ * its parent at every step, it's kept in temp while the parents move down into the hole, and
+ * written only once at its final position. */
 void heap_bubble_up(char *base, const size_t size,
                     size_t i,
                     compare_f compare,
                     char *temp)
 {
-    size_t p = _parent(i);
-    while (i > 0 && compare(base + i * size, base + p * size) > 0) {
-        _swap(base + i * size, base + p * size, size, temp);
+    if (i == 0 || compare(base + i * size, base + _parent(i) * size) <= 0) return;
+
+    _copy(temp, base + i * size, size);
+    do {
+        size_t p = _parent(i);
+        _copy(base + i * size, base + p * size, size);
         i = p;
-        p = _parent(p);
-    }
+    } while (i > 0 && compare(temp, base + _parent(i) * size) > 0);
+    _copy(base + i * size, temp, size);
 }
 
 /* Make the element at index i move down the heap until it sits where it belongs. Used by
- * make_heap. */
+ * make_heap. Like heap_bubble_up, this moves the greater children up into the hole instead of
+ * swapping. */
 void heap_sift_down(char *base, const size_t n, const size_t size,
                     size_t i,
                     compare_f compare,
                     char *temp)
 {
-    if (n == 1) return;
-    size_t max;
-    while (i <= _parent(n - 1)) {
-        max = i;
-        if (compare(base + i * size, base + _lchild(i) * size) < 0) {
-            max = _lchild(i);
-        }
-        if (_rchild(i) < n && compare(base + max * size, base + _rchild(i) * size) < 0) {
-            max = _rchild(i);
-        }
-        if (max == i) return;
-        _swap(base + i * size, base + max * size, size, temp);
-        i = max;
+    if (n < 2) return;
+
+    size_t c = _lchild(i);
+    if (c >= n) return;
+
+    _copy(temp, base + i * size, size);
+    while (c < n) {
+        if (c + 1 < n && compare(base + c * size, base + (c + 1) * size) < 0) ++c;
+        if (compare(temp, base + c * size) >= 0) break;
+        _copy(base + i * size, base + c * size, size);
+        i = c;
+        c = _lchild(i);
     }
+    _copy(base + i * size, temp, size);
 }
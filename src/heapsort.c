@@ -12,8 +12,17 @@
 #include "heap.h"
 #include "sort_tools.h"
 
-void heapsort(char *base, size_t n, size_t size, compare_f compare)
+void heapsort(void *array, size_t n, size_t size, compare_f compare)
 {
+    /* Sort directly if the pointer array for the indirect sort can't be allocated. */
+    if (size > SORT_INDIRECT_SIZE
+            && _sort_indirect(array, n, size, compare, heapsort) == 0) {
+        return;
+    }
+
+    char *base = array;
+    if (n < 2) return;
+
     char *temp = malloc(size);
     check_alloc(temp);
 
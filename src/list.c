@@ -32,16 +32,15 @@ error:
  * objects. */
 #define list_n_size(L) (sizeof(list_n) + t_size((L)->data_type))
 
-/* static inline list_n *list_n_new(const list *L, const void *v)
+/* static inline list_n *list_n_new(list *L, const void *v)
  * Create a new list node with the value v. Return a pointer to it or NULL on error. */
-static inline list_n *list_n_new(const list *L, const void *v)
+static inline list_n *list_n_new(list *L, const void *v)
 {
     assert(L && L->data_type && v);
-    size_t size = list_n_size(L);
-    assert(size > sizeof(list_n));
+    assert(list_n_size(L) > sizeof(list_n));
 
-    list_n *n = calloc(1, size);
-    check_alloc(n);
+    list_n *n = pool_alloc(&L->node_pool);
+    check(n != NULL, "failed to allocate node");
 
     t_copy(L->data_type, list_n_data(n), v);
     n->has_data = 1;
@@ -52,13 +51,13 @@ error:
     return NULL;
 }
 
-/* static inline void list_n_delete(const list *L, list_n *n)
+/* static inline void list_n_delete(list *L, list_n *n)
  * Delete n, freeing any associated memory. */
-static inline void list_n_delete(const list *L, list_n *n)
+static inline void list_n_delete(list *L, list_n *n)
 {
     assert(L && L->data_type && n);
     if (n->has_data) t_destroy(L->data_type, list_n_data(n));
-    free(n);
+    pool_free(&L->node_pool, n);
 }
 
 /* static void list_n_set(const list *L, list_n *n, const void *v)
@@ -72,12 +71,19 @@ static void list_n_set(const list *L, list_n *n, const void *v)
     n->has_data = 1;
 }
 
-/* int      list_initialize(list *L, t_intf *t)
- * list *   list_new       (         t_intf *t)
+/* int      list_initialize     (list *L, t_intf *t)
+ * int      list_initialize_with(list *L, t_intf *t, allocator *A)
+ * list *   list_new            (         t_intf *t)
  * list_initialize initializes a list at the address pointed to by L (assuming there's enough
  * space), and returns 0 on success or -1 on error. list_new allocates and initializes a new list
- * and returns a pointer to it or NULL on error. */
+ * and returns a pointer to it or NULL on error.
+ * list_initialize_with takes its nodes from the allocator A instead of malloc. */
 int list_initialize(list *L, t_intf *dt)
+{
+    return list_initialize_with(L, dt, NULL);
+}
+
+int list_initialize_with(list *L, t_intf *dt, allocator *A)
 {
     check_ptr(dt);
 
@@ -85,6 +91,9 @@ int list_initialize(list *L, t_intf *dt)
     L->count = 0;
     L->data_type = dt;
 
+    int rc = pool_initialize(&L->node_pool, list_n_size(L), A);
+    check_rc(rc, "pool_initialize");
+
     assert(list_invariant(L) == 0);
     return 0;
 error:
@@ -112,13 +121,14 @@ void list_clear(list *L)
     if (L) {
         assert(list_invariant(L) == 0);
 
-        list_n *cur;
-        list_n *next;
-
-        for (cur = L->first; cur != NULL; cur = next) {
-            next = cur->next;
-            list_n_delete(L, cur);
+        /* Payloads that need destruction are destroyed one by one, but the nodes themselves are
+         * released in bulk with their pool. */
+        if (L->data_type->destroy) {
+            for (list_n *cur = L->first; cur != NULL; cur = cur->next) {
+                if (cur->has_data) t_destroy(L->data_type, list_n_data(cur));
+            }
         }
+        pool_clear(&L->node_pool);
         L->first = L->last = NULL;
         L->count = 0;
     }
@@ -130,7 +140,8 @@ void list_clear(list *L)
 void list_destroy(list *L)
 {
     if (L) {
-        if (list_count(L)) list_clear(L);
+        list_clear(L);
+        pool_destroy(&L->node_pool);
         L->data_type = NULL;
     }
 }
@@ -138,7 +149,8 @@ void list_destroy(list *L)
 void list_delete(list *L)
 {
     if (L) {
-        if (list_count(L)) list_clear(L);
+        list_clear(L);
+        pool_destroy(&L->node_pool);
         free(L);
     }
 }
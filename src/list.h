@@ -16,6 +16,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "pool.h"
 #include "type_interface.h"
 
 struct list_n;
@@ -30,6 +31,7 @@ typedef struct list {
     list_n *last;
     size_t count;
     t_intf *data_type;
+    pool node_pool;
 } list;
 
 #define list_n_data(n)   (void*)((char*)n + sizeof(list_n))
@@ -40,6 +42,7 @@ typedef struct list {
 #define list_empty(L)   ((L)->count == 0)
 
 int     list_initialize     (list *L, t_intf *t);
+int     list_initialize_with(list *L, t_intf *t, allocator *A);
 list *  list_new            (t_intf *dt);
 void    list_destroy        (list *L);
 void    list_delete         (list *L);
@@ -3,7 +3,9 @@
  * map.h
  *
  * Associative data structure that maps values to keys. Supports arbitrary data types by way of
- * type interface structs. This is just an adapter for the binary search tree, see bst.h.
+ * type interface structs. This is just an adapter for the binary search tree, see bst.h. The
+ * bmap variant has the same interface but is backed by a B-tree (see btree.h), which is faster
+ * to search for large numbers of keys.
  *
  * Author: Florian Kretlow, 2020
  * Licensed under the MIT License.
@@ -14,10 +16,12 @@
 #define _map_h
 
 #include "bst.h"
+#include "btree.h"
 
 typedef bst map;
 
 #define map_initialize(M, kt, vt)       bst_initialize(M, RB, kt, vt)
+#define map_initialize_with(M, kt, vt, A) bst_initialize_with(M, RB, kt, vt, A)
 #define map_new(kt, vt)                 bst_new(RB, kt, vt)
 #define map_destroy(M)                  bst_destroy(M)
 #define map_delete(M)                   bst_delete(M)
@@ -32,5 +36,44 @@ typedef bst map;
 #define map_remove(M, k)                bst_remove(M, k)
 
 #define map_count(M)                    bst_count(M)
+#define map_select(M, i)                bst_select(M, i)
+#define map_rank(M, k)                  bst_rank(M, k)
+#define map_count_range(M, lo, hi)      bst_count_range(M, lo, hi)
+
+#define map_lower_bound(M, k)           bst_lower_bound(M, k)
+#define map_upper_bound(M, k)           bst_upper_bound(M, k)
+#define map_floor(M, k)                 bst_floor(M, k)
+#define map_ceiling(M, k)               bst_ceiling(M, k)
+#define map_traverse_range(M, lo, hi, f, p) bst_traverse_range(M, lo, hi, f, p)
+#define map_traverse_range_values(M, lo, hi, f, p) bst_traverse_range_values(M, lo, hi, f, p)
+
+typedef bst_iter map_iter;
+
+#define map_iter_first(it, M)           bst_iter_first(it, M)
+#define map_iter_last(it, M)            bst_iter_last(it, M)
+#define map_iter_seek(it, M, k)         bst_iter_seek(it, M, k)
+#define map_iter_next(it)               bst_iter_next(it)
+#define map_iter_prev(it)               bst_iter_prev(it)
+#define map_iter_key(it)                bst_iter_key(it)
+#define map_iter_value(it)              bst_iter_value(it)
+
+typedef btree bmap;
+
+#define bmap_initialize(M, kt, vt)      btree_initialize(M, kt, vt)
+#define bmap_initialize_with(M, kt, vt, A) btree_initialize_with(M, kt, vt, A)
+#define bmap_new(kt, vt)                btree_new(kt, vt)
+#define bmap_destroy(M)                 btree_destroy(M)
+#define bmap_delete(M)                  btree_delete(M)
+
+#define bmap_clear(M)                   btree_clear(M)
+#define bmap_copy(M)                    btree_copy(M)
+#define bmap_copy_to(dest, src)         btree_copy_to(dest, src)
+
+#define bmap_set(M, k, v)               btree_set(M, k, v)
+#define bmap_get(M, k)                  btree_get(M, k)
+#define bmap_has(M, k)                  btree_has(M, k)
+#define bmap_remove(M, k)               btree_remove(M, k)
+
+#define bmap_count(M)                   btree_count(M)
 
 #endif /* _map_h */
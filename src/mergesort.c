@@ -3,19 +3,24 @@
  * mergesort.c
  * Implementation of the mergesort algorithm. Sources: Skiena, Wikipedia.
  *
+ * mergesort itself uses the adaptive natural merge sort in timsort.c. The top-down version here
+ * does the same work regardless of presortedness and remains as the building block of
+ * parallel_stable_sort, which splits the array in the same way.
+ *
  ************************************************************************************************/
 
 #include <stdlib.h>
 #include <string.h>
 
 #include "check.h"
+#include "sort.h"
 #include "sort_tools.h"
 
-static void _merge(char *base,
-                   size_t start, size_t end, size_t middle,
-                   size_t size,
-                   compare_f compare,
-                   char *temp)
+void _merge(char *base,
+            size_t start, size_t end, size_t middle,
+            size_t size,
+            compare_f compare,
+            char *temp)
 {
     /* Move the first half to the workspace. */
     memmove(temp + start * size, base + start * size, (middle - start) * size);
@@ -23,32 +28,34 @@ static void _merge(char *base,
     size_t i, j, k;
     for (i = start, j = middle, k = start; i < middle && j < end; ++k) {
         if (compare(temp + i * size, base + j * size) <= 0) {
-            memmove(base + k * size, temp + i * size, size);
+            _copy(base + k * size, temp + i * size, size);
             ++i;
         } else {
-            memmove(base + k * size, base + j * size, size);
+            _copy(base + k * size, base + j * size, size);
             ++j;
         }
     }
 
     while (i < middle) {
-        memmove(base + k * size, temp + i * size, size);
+        _copy(base + k * size, temp + i * size, size);
         ++i; ++k;
     }
     /* No need to finish walking through the second half if j < end, because the values are
      * already at their place. */
 }
 
-static void _mergesort(char *base,
-                       size_t start, size_t end,
-                       size_t size,
-                       compare_f compare,
-                       char *temp)
+void _mergesort(char *base,
+                size_t start, size_t end,
+                size_t size,
+                compare_f compare,
+                char *temp)
 {
     if (end - start <= 1) {
         return;
     } else if (end - start <= 8) {
-        _insertionsort(base, start, end, size, compare, temp);
+        /* Use the part of the workspace that belongs to this range for swaps, so that disjoint
+         * ranges can be sorted concurrently. */
+        _insertionsort(base, start, end, size, compare, temp + start * size);
     } else {
         size_t middle = (start + end) / 2;
         _mergesort(base, start, middle, size, compare, temp);
@@ -59,10 +66,5 @@ static void _mergesort(char *base,
 
 void mergesort(void *base, size_t nmemb, size_t size, compare_f compare)
 {
-    char *temp = malloc(nmemb * size);
-    check_alloc(temp);
-    _mergesort((char*)base, 0, nmemb, size, compare, temp);
-    free(temp);
-error:
-    return; /* TODO: error handling?? */
+    timsort(base, nmemb, size, compare);
 }
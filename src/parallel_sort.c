@@ -0,0 +1,172 @@
+/*************************************************************************************************
+ *
+ * parallel_sort.c
+ * Multithreaded versions of quicksort and mergesort using fork-join parallelism with pthreads.
+ *
+ * parallel_sort runs the same introsort as quicksort: every range is partitioned exactly as the
+ * sequential version would partition it, but the two halves are sorted by different threads
+ * until each thread has a share of the work. parallel_stable_sort splits the array in halves
+ * recursively, sorts the pieces with mergesort in parallel and merges them back on the way up.
+ * Both produce the same result as their sequential counterparts.
+ *
+ ************************************************************************************************/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "sort.h"
+#include "sort_tools.h"
+
+struct sort_task {
+    char *      base;
+    size_t      start;
+    size_t      end;
+    size_t      size;
+    compare_f   compare;
+    char *      temp;       /* mergesort only: shared scratch space for the whole array */
+    unsigned    depth;      /* quicksort only: the remaining introsort depth */
+    unsigned    forks;      /* the number of times the task may still split into two threads */
+    int         rc;
+};
+
+/* Run f(t1) in a new thread and f(t2) in the current one, then wait for the thread. If the thread
+ * can't be created, run both in the current thread. */
+static void _fork_join(void *(*f)(void *), struct sort_task *t1, struct sort_task *t2)
+{
+    pthread_t thread;
+    int rc = pthread_create(&thread, NULL, f, t1);
+    if (rc != 0) {
+        log_warn("failed to create thread, continuing sequentially");
+        f(t1);
+        f(t2);
+    } else {
+        f(t2);
+        pthread_join(thread, NULL);
+    }
+}
+
+static unsigned _forks_for(unsigned n_threads)
+{
+    if (n_threads == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        n_threads = n > 0 ? (unsigned)n : 1;
+    }
+
+    /* Splitting log2(n_threads) times yields (at least) one leaf task per thread. One more
+     * level helps to balance partitions of unequal size. */
+    unsigned forks = 0;
+    while ((1u << forks) < n_threads) ++forks;
+    return n_threads > 1 ? forks + 1 : 0;
+}
+
+static void *_parallel_quicksort(void *arg)
+{
+    struct sort_task *t = arg;
+    char *temp = NULL;
+
+    temp = malloc(2 * t->size);
+    check_alloc(temp);
+
+    if (t->forks == 0 || t->depth == 0 || t->end - t->start < PARALLEL_SORT_CUTOFF) {
+        _quicksort(t->base, t->start, t->end, t->size, t->compare, temp, t->depth);
+    } else {
+        /* Same as one iteration of _quicksort. */
+        size_t p = _partition(t->base, t->start, t->end, t->size, t->compare, temp);
+        struct sort_task left = *t, right = *t;
+        left.end = right.start = p + 1;
+        left.depth = right.depth = t->depth - 1;
+        left.forks = right.forks = t->forks - 1;
+
+        _fork_join(_parallel_quicksort, &left, &right);
+        t->rc = left.rc < 0 || right.rc < 0 ? -1 : 0;
+    }
+
+    free(temp);
+    return NULL;
+error:
+    t->rc = -1;
+    return NULL;
+}
+
+static void *_parallel_mergesort(void *arg)
+{
+    struct sort_task *t = arg;
+
+    if (t->forks == 0 || t->end - t->start < PARALLEL_SORT_CUTOFF) {
+        _mergesort(t->base, t->start, t->end, t->size, t->compare, t->temp);
+    } else {
+        size_t middle = (t->start + t->end) / 2;
+        struct sort_task left = *t, right = *t;
+        left.end = right.start = middle;
+        left.forks = right.forks = t->forks - 1;
+
+        _fork_join(_parallel_mergesort, &left, &right);
+        _merge(t->base, t->start, t->end, middle, t->size, t->compare, t->temp);
+    }
+
+    return NULL;
+}
+
+/* int parallel_sort       (void *base, size_t nmemb, size_t size, compare_f compare,
+ *                          unsigned n_threads)
+ * int parallel_stable_sort(void *base, size_t nmemb, size_t size, compare_f compare,
+ *                          unsigned n_threads)
+ * Sort the array like quicksort and mergesort respectively, using up to about n_threads threads,
+ * or as many as there are processors online if n_threads is 0. Ranges smaller than
+ * PARALLEL_SORT_CUTOFF are always sorted sequentially. compare must be safe to call from
+ * multiple threads at once. Return 0 on success or -1 on error. */
+int parallel_sort(void *base, size_t nmemb, size_t size, compare_f compare, unsigned n_threads)
+{
+    check_ptr(base);
+    check_ptr(compare);
+
+    struct sort_task t = {
+        .base = base,
+        .start = 0,
+        .end = nmemb,
+        .size = size,
+        .compare = compare,
+        .temp = NULL,
+        .depth = _introsort_depth(nmemb),
+        .forks = _forks_for(n_threads),
+        .rc = 0
+    };
+    _parallel_quicksort(&t);
+    check(t.rc == 0, "parallel quicksort failed");
+
+    return 0;
+error:
+    return -1;
+}
+
+int parallel_stable_sort(void *base, size_t nmemb, size_t size, compare_f compare,
+                         unsigned n_threads)
+{
+    char *temp = NULL;
+    check_ptr(base);
+    check_ptr(compare);
+
+    temp = malloc(nmemb * size);
+    check_alloc(temp);
+
+    struct sort_task t = {
+        .base = base,
+        .start = 0,
+        .end = nmemb,
+        .size = size,
+        .compare = compare,
+        .temp = temp,
+        .depth = 0,
+        .forks = _forks_for(n_threads),
+        .rc = 0
+    };
+    _parallel_mergesort(&t);
+
+    free(temp);
+    return 0;
+error:
+    if (temp) free(temp);
+    return -1;
+}
@@ -0,0 +1,399 @@
+/*************************************************************************************************
+ *
+ * pdqsort.c
+ * Implementation of pattern-defeating quicksort. Source: Orson Peters, "Pattern-defeating
+ * Quicksort" (2021), and the reference implementation pdqsort.h. Block partitioning: Edelkamp
+ * and Weiß, "BlockQuicksort: How Branch Mispredictions don't affect Quicksort" (2016).
+ *
+ * Compared to the introsort in quicksort.c, pdqsort
+ * - partitions in blocks: the comparisons for a whole block of elements are done first and their
+ *   outcomes stored as offsets without branching, then the misplaced elements are swapped;
+ * - notices when a partition step didn't have to move anything and then tries to finish both
+ *   halves with a bounded insertion sort, which makes it linear on sorted input;
+ * - groups elements equal to the pivot of the enclosing partition in one step, which makes it
+ *   linear on inputs with few distinct values;
+ * - shuffles a few elements around when a partition was very unbalanced, and falls back to
+ *   heapsort after log2(n) such partitions.
+ *
+ ************************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "heap.h"
+#include "sort_tools.h"
+
+#define INSERTION_THRESHOLD     24
+#define NINTHER_THRESHOLD       128
+#define PARTIAL_INSERTION_LIMIT 8
+#define BLOCK_SIZE              64
+
+/* The state shared by all recursion levels: element size, comparison function, and three
+ * element-sized scratch slots. */
+struct pdq {
+    size_t      size;
+    compare_f   compare;
+    char *      pivot;
+    char *      temp;
+    char *      hole;
+};
+
+#define less(S, a, b)   ((S)->compare((a), (b)) < 0)
+#define copy(S, a, b)   _copy((a), (b), (S)->size)
+#define swap(S, a, b)   _swap((a), (b), (S)->size, (S)->temp)
+
+static void _insertionsort_range(struct pdq *S, char *begin, char *end, int guarded)
+{
+    size_t size = S->size;
+    if (begin == end) return;
+
+    for (char *cur = begin + size; cur < end; cur += size) {
+        char *sift = cur;
+        if (less(S, sift, sift - size)) {
+            copy(S, S->hole, sift);
+            do {
+                copy(S, sift, sift - size);
+                sift -= size;
+            } while ((!guarded || sift != begin) && less(S, S->hole, sift - size));
+            copy(S, sift, S->hole);
+        }
+    }
+}
+
+/* Insertion sort that gives up after moving PARTIAL_INSERTION_LIMIT elements. Return 1 if the
+ * range was sorted, 0 if it gave up. */
+static int _partial_insertionsort(struct pdq *S, char *begin, char *end)
+{
+    size_t size = S->size;
+    size_t limit = 0;
+    if (begin == end) return 1;
+
+    for (char *cur = begin + size; cur < end; cur += size) {
+        char *sift = cur;
+        if (less(S, sift, sift - size)) {
+            copy(S, S->hole, sift);
+            do {
+                copy(S, sift, sift - size);
+                sift -= size;
+            } while (sift != begin && less(S, S->hole, sift - size));
+            copy(S, sift, S->hole);
+            limit += (size_t)(cur - sift) / size;
+        }
+        if (limit > PARTIAL_INSERTION_LIMIT) return 0;
+    }
+    return 1;
+}
+
+static inline void _sort2(struct pdq *S, char *a, char *b)
+{
+    if (less(S, b, a)) swap(S, a, b);
+}
+
+static inline void _sort3(struct pdq *S, char *a, char *b, char *c)
+{
+    _sort2(S, a, b);
+    _sort2(S, b, c);
+    _sort2(S, a, b);
+}
+
+/* Move the elements at the given offsets from first and last across in one cycle. */
+static void _swap_offsets(struct pdq *S, char *first, char *last,
+                          unsigned char *offsets_l, unsigned char *offsets_r,
+                          size_t num, int use_swaps)
+{
+    size_t size = S->size;
+    if (use_swaps) {
+        /* The cyclic permutation below leaves the elements in a different order when num_l ==
+         * num_r, which would make the partition worse on inputs with few distinct values. */
+        for (size_t i = 0; i < num; ++i) {
+            swap(S, first + offsets_l[i] * size, last - offsets_r[i] * size);
+        }
+    } else if (num > 0) {
+        char *l = first + offsets_l[0] * size;
+        char *r = last - offsets_r[0] * size;
+        copy(S, S->hole, l);
+        copy(S, l, r);
+        for (size_t i = 1; i < num; ++i) {
+            l = first + offsets_l[i] * size;
+            copy(S, r, l);
+            r = last - offsets_r[i] * size;
+            copy(S, l, r);
+        }
+        copy(S, r, S->hole);
+    }
+}
+
+/* Partition [begin, end[ around the pivot *begin. Elements equal to the pivot go to the right.
+ * Return the new position of the pivot, and set *already_partitioned if no elements had to be
+ * moved. */
+static char *_partition_right(struct pdq *S, char *begin, char *end, int *already_partitioned)
+{
+    size_t size = S->size;
+    char *pivot = S->pivot;
+    copy(S, pivot, begin);
+
+    char *first = begin;
+    char *last = end;
+
+    /* Find the first element >= pivot (there is one: the median of three guarantees it), and the
+     * last element < pivot if there is one. */
+    do first += size; while (less(S, first, pivot));
+    if (first - size == begin) {
+        while (first < last && !less(S, (last -= size), pivot));
+    } else {
+        while (!less(S, (last -= size), pivot));
+    }
+
+    *already_partitioned = first >= last;
+
+    if (!*already_partitioned) {
+        swap(S, first, last);
+        first += size;
+
+        unsigned char offsets_l[BLOCK_SIZE];
+        unsigned char offsets_r[BLOCK_SIZE];
+        char *offsets_l_base = first;
+        char *offsets_r_base = last;
+        size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+        while (first < last) {
+            /* Fill up the offset buffers that are empty, splitting the unknown elements between
+             * them if both are. */
+            size_t num_unknown = (size_t)(last - first) / size;
+            size_t left_split = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+            size_t right_split = num_r == 0 ? (num_unknown - left_split) : 0;
+            if (left_split > BLOCK_SIZE) left_split = BLOCK_SIZE;
+            if (right_split > BLOCK_SIZE) right_split = BLOCK_SIZE;
+
+            /* The actual branchless part: record every offset, but only advance the count if the
+             * element is on the wrong side. */
+            for (size_t i = 0; i < left_split; ++i) {
+                offsets_l[num_l] = (unsigned char)i;
+                num_l += !less(S, first, pivot);
+                first += size;
+            }
+            for (size_t i = 0; i < right_split; ) {
+                offsets_r[num_r] = (unsigned char)++i;
+                last -= size;
+                num_r += less(S, last, pivot);
+            }
+
+            size_t num = num_l < num_r ? num_l : num_r;
+            _swap_offsets(S, offsets_l_base, offsets_r_base,
+                          offsets_l + start_l, offsets_r + start_r, num, num_l == num_r);
+            num_l -= num;
+            num_r -= num;
+            start_l += num;
+            start_r += num;
+
+            if (num_l == 0) {
+                start_l = 0;
+                offsets_l_base = first;
+            }
+            if (num_r == 0) {
+                start_r = 0;
+                offsets_r_base = last;
+            }
+        }
+
+        /* At most one of the buffers has elements left. Swap them to the boundary. */
+        if (num_l) {
+            while (num_l--) {
+                last -= size;
+                swap(S, offsets_l_base + offsets_l[start_l + num_l] * size, last);
+            }
+            first = last;
+        }
+        if (num_r) {
+            while (num_r--) {
+                swap(S, offsets_r_base - offsets_r[start_r + num_r] * size, first);
+                first += size;
+            }
+            last = first;
+        }
+    }
+
+    /* Put the pivot in the right place. */
+    char *pivot_pos = first - size;
+    copy(S, begin, pivot_pos);
+    copy(S, pivot_pos, pivot);
+
+    return pivot_pos;
+}
+
+/* Partition [begin, end[ around the pivot *begin, with elements equal to the pivot going to the
+ * left. Used when the pivot equals the element before begin: then everything on the left is
+ * equal to the pivot and doesn't need to be sorted any further. */
+static char *_partition_left(struct pdq *S, char *begin, char *end)
+{
+    size_t size = S->size;
+    char *pivot = S->pivot;
+    copy(S, pivot, begin);
+
+    char *first = begin;
+    char *last = end;
+
+    do last -= size; while (less(S, pivot, last));
+    if (last + size == end) {
+        while (first < last && !less(S, pivot, (first += size)));
+    } else {
+        while (!less(S, pivot, (first += size)));
+    }
+
+    while (first < last) {
+        swap(S, first, last);
+        do last -= size; while (less(S, pivot, last));
+        do first += size; while (!less(S, pivot, first));
+    }
+
+    copy(S, begin, last);
+    copy(S, last, pivot);
+
+    return last;
+}
+
+static void _heapsort_range(struct pdq *S, char *begin, char *end)
+{
+    size_t size = S->size;
+    size_t n = (size_t)(end - begin) / size;
+
+    make_heap(begin, n, size, S->compare, S->temp);
+    while (n > 1) {
+        --n;
+        swap(S, begin, begin + n * size);
+        heap_sift_down(begin, n, size, 0, S->compare, S->temp);
+    }
+}
+
+static void _pdqsort(struct pdq *S, char *begin, char *end, int bad_allowed, int leftmost)
+{
+    size_t size = S->size;
+
+    for ( ;; ) {
+        size_t n = (size_t)(end - begin) / size;
+
+        if (n < INSERTION_THRESHOLD) {
+            /* Unless we're at the left end, the element before begin is <= everything in the
+             * range and serves as a sentinel. */
+            _insertionsort_range(S, begin, end, leftmost);
+            return;
+        }
+
+        /* Choose the pivot as the median of three or the ninther and move it to begin. */
+        size_t s2 = n / 2;
+        if (n > NINTHER_THRESHOLD) {
+            _sort3(S, begin, begin + s2 * size, end - size);
+            _sort3(S, begin + size, begin + (s2 - 1) * size, end - 2 * size);
+            _sort3(S, begin + 2 * size, begin + (s2 + 1) * size, end - 3 * size);
+            _sort3(S, begin + (s2 - 1) * size, begin + s2 * size, begin + (s2 + 1) * size);
+            swap(S, begin, begin + s2 * size);
+        } else {
+            _sort3(S, begin + s2 * size, begin, end - size);
+        }
+
+        /* If the pivot equals the pivot of the enclosing partition (which sits right before
+         * begin), there are many equal elements. Put them all to the left; they're done. */
+        if (!leftmost && !less(S, begin - size, begin)) {
+            begin = _partition_left(S, begin, end) + size;
+            continue;
+        }
+
+        int already_partitioned;
+        char *pivot_pos = _partition_right(S, begin, end, &already_partitioned);
+
+        size_t l_size = (size_t)(pivot_pos - begin) / size;
+        size_t r_size = (size_t)(end - (pivot_pos + size)) / size;
+
+        if (l_size < n / 8 || r_size < n / 8) {
+            /* A bad partition. Give up after too many of them, otherwise break up patterns by
+             * swapping a few elements to other places. */
+            if (--bad_allowed == 0) {
+                _heapsort_range(S, begin, end);
+                return;
+            }
+
+            if (l_size >= INSERTION_THRESHOLD) {
+                swap(S, begin, begin + (l_size / 4) * size);
+                swap(S, pivot_pos - size, pivot_pos - (l_size / 4) * size);
+                if (l_size > NINTHER_THRESHOLD) {
+                    swap(S, begin + size, begin + (l_size / 4 + 1) * size);
+                    swap(S, begin + 2 * size, begin + (l_size / 4 + 2) * size);
+                    swap(S, pivot_pos - 2 * size, pivot_pos - (l_size / 4 + 1) * size);
+                    swap(S, pivot_pos - 3 * size, pivot_pos - (l_size / 4 + 2) * size);
+                }
+            }
+            if (r_size >= INSERTION_THRESHOLD) {
+                swap(S, pivot_pos + size, pivot_pos + (1 + r_size / 4) * size);
+                swap(S, end - size, end - (r_size / 4) * size);
+                if (r_size > NINTHER_THRESHOLD) {
+                    swap(S, pivot_pos + 2 * size, pivot_pos + (2 + r_size / 4) * size);
+                    swap(S, pivot_pos + 3 * size, pivot_pos + (3 + r_size / 4) * size);
+                    swap(S, end - 2 * size, end - (1 + r_size / 4) * size);
+                    swap(S, end - 3 * size, end - (2 + r_size / 4) * size);
+                }
+            }
+        } else if (already_partitioned &&
+                   _partial_insertionsort(S, begin, pivot_pos) &&
+                   _partial_insertionsort(S, pivot_pos + size, end)) {
+            /* The partition didn't move anything and both halves were nearly sorted. */
+            return;
+        }
+
+        /* Sort the left partition recursively and the right one iteratively. */
+        _pdqsort(S, begin, pivot_pos, bad_allowed, leftmost);
+        begin = pivot_pos + size;
+        leftmost = 0;
+    }
+}
+
+/* Check whether the whole array is ascending, or strictly descending (and then reverse it).
+ * Either scan stops at the first element that doesn't fit, so this costs next to nothing on
+ * other inputs. Return 1 if the array is sorted afterwards. */
+static int _sorted_or_reversed(struct pdq *S, char *base, size_t nmemb)
+{
+    size_t size = S->size;
+    char *end = base + nmemb * size;
+    char *p = base + size;
+
+    if (!less(S, p, base)) {
+        while (p + size < end && !less(S, p + size, p)) p += size;
+        return p + size >= end;
+    } else {
+        while (p + size < end && less(S, p + size, p)) p += size;
+        if (p + size < end) return 0;
+        for (char *l = base, *r = end - size; l < r; l += size, r -= size) swap(S, l, r);
+        return 1;
+    }
+}
+
+void pdqsort(void *base, size_t nmemb, size_t size, compare_f compare)
+{
+    if (nmemb < 2) return;
+    /* Sort directly if the pointer array for the indirect sort can't be allocated. */
+    if (size > SORT_INDIRECT_SIZE
+            && _sort_indirect(base, nmemb, size, compare, pdqsort) == 0) {
+        return;
+    }
+
+    char *scratch = malloc(3 * size);
+    check(scratch != NULL, "failed to allocate scratch space, the array is left unsorted");
+
+    struct pdq S = {
+        .size = size,
+        .compare = compare,
+        .pivot = scratch,
+        .temp = scratch + size,
+        .hole = scratch + 2 * size
+    };
+
+    if (!_sorted_or_reversed(&S, base, nmemb)) {
+        int bad_allowed = 0;
+        for (size_t n = nmemb; n > 1; n >>= 1) ++bad_allowed;
+        _pdqsort(&S, (char*)base, (char*)base + nmemb * size, bad_allowed, 1);
+    }
+
+    free(scratch);
+error:
+    return;
+}
@@ -0,0 +1,117 @@
+/*************************************************************************************************
+ *
+ * pool.c
+ *
+ * Implementation of the fixed-size slab allocator declared in pool.h. Each chunk starts with a
+ * small header that links it to the previous chunk, followed by its slots. The slot size is
+ * rounded up to POOL_ALIGNMENT, so every slot is suitably aligned for any node type.
+ *
+ ************************************************************************************************/
+
+#include <assert.h>
+#include <string.h>
+
+#include "check.h"
+#include "pool.h"
+
+#define pool_round_up(n) (((n) + POOL_ALIGNMENT - 1) & ~(POOL_ALIGNMENT - 1))
+#define pool_chunk_header_size pool_round_up(sizeof(pool_chunk))
+
+/* int pool_initialize(pool *P, size_t slot_size, allocator *A)
+ * Initialize an empty pool at P that hands out slots of at least slot_size bytes, taking its
+ * chunks from A (or malloc_allocator if A is NULL). No memory is allocated until the first call
+ * to pool_alloc. Return 0 on success or -1 on error. */
+int pool_initialize(pool *P, size_t slot_size, allocator *A)
+{
+    check_ptr(P);
+    check(slot_size > 0, "slot size of 0");
+
+    if (slot_size < sizeof(void*)) slot_size = sizeof(void*);
+
+    P->chunks = NULL;
+    P->free_list = NULL;
+    P->next = P->end = NULL;
+    P->slot_size = pool_round_up(slot_size);
+    P->chunk_slots = POOL_MIN_CHUNK_SLOTS;
+    P->alloc = A ? A : &malloc_allocator;
+
+    return 0;
+error:
+    return -1;
+}
+
+/* void pool_clear(pool *P)
+ * Release all chunks at once. Every slot handed out by P becomes invalid. P can be used again
+ * afterwards. */
+void pool_clear(pool *P)
+{
+    if (P) {
+        pool_chunk *c = P->chunks;
+        pool_chunk *next;
+        while (c) {
+            next = c->next;
+            a_deallocate(P->alloc, c, c->size);
+            c = next;
+        }
+        P->chunks = NULL;
+        P->free_list = NULL;
+        P->next = P->end = NULL;
+        P->chunk_slots = POOL_MIN_CHUNK_SLOTS;
+    }
+}
+
+/* void pool_destroy(pool *P)
+ * Release all memory associated with P. */
+void pool_destroy(pool *P)
+{
+    if (P) {
+        pool_clear(P);
+        P->slot_size = 0;
+    }
+}
+
+/* void *pool_alloc(pool *P)
+ * Return a pointer to a zeroed slot, or NULL on error. Released slots are reused first, then the
+ * remaining slots of the current chunk. When both are exhausted, a new chunk twice the size of
+ * the previous one (up to POOL_MAX_CHUNK_SLOTS slots) is allocated. */
+void *pool_alloc(pool *P)
+{
+    assert(P && P->slot_size);
+
+    void *slot;
+
+    if (P->free_list) {
+        slot = P->free_list;
+        P->free_list = *(void**)slot;
+    } else {
+        if (P->next == P->end) {
+            size_t size = pool_chunk_header_size + P->chunk_slots * P->slot_size;
+            pool_chunk *c = a_allocate(P->alloc, size);
+            check(c != NULL, "failed to allocate chunk");
+            c->next = P->chunks;
+            c->size = size;
+            P->chunks = c;
+            P->next = (char*)c + pool_chunk_header_size;
+            P->end = P->next + P->chunk_slots * P->slot_size;
+            if (P->chunk_slots < POOL_MAX_CHUNK_SLOTS) P->chunk_slots <<= 1;
+        }
+        slot = P->next;
+        P->next += P->slot_size;
+    }
+
+    memset(slot, 0, P->slot_size);
+    return slot;
+error:
+    return NULL;
+}
+
+/* void pool_free(pool *P, void *slot)
+ * Return slot to P for reuse. The memory is not released before pool_clear/pool_destroy. */
+void pool_free(pool *P, void *slot)
+{
+    assert(P);
+    if (slot) {
+        *(void**)slot = P->free_list;
+        P->free_list = slot;
+    }
+}
@@ -0,0 +1,45 @@
+/*************************************************************************************************
+ *
+ * pool.h
+ *
+ * A fixed-size slab allocator for container nodes. Slots of one size are carved from chunks that
+ * grow geometrically; released slots are kept on a free list and reused. All chunks are released
+ * at once by pool_clear/pool_destroy, so a container whose elements need no destruction can drop
+ * all its nodes in O(chunks) instead of O(nodes).
+ *
+ ************************************************************************************************/
+
+#ifndef _pool_h
+#define _pool_h
+
+#include <stdlib.h>
+#include "allocator.h"
+
+#define POOL_ALIGNMENT          16lu
+#define POOL_MIN_CHUNK_SLOTS    8lu
+#define POOL_MAX_CHUNK_SLOTS    4096lu
+
+struct pool_chunk;
+typedef struct pool_chunk {
+    struct pool_chunk * next;
+    size_t              size;       /* total size in bytes, including this header */
+} pool_chunk;
+
+typedef struct pool {
+    pool_chunk *    chunks;     /* most recently allocated chunk first */
+    void *          free_list;  /* released slots, linked through their first bytes */
+    char *          next;       /* next untouched slot in the current chunk */
+    char *          end;        /* end of the current chunk */
+    size_t          slot_size;
+    size_t          chunk_slots;/* number of slots in the next chunk to allocate */
+    allocator *     alloc;      /* where chunks come from */
+} pool;
+
+int     pool_initialize (pool *P, size_t slot_size, allocator *A);
+void    pool_destroy    (pool *P);
+void    pool_clear      (pool *P);
+
+void *  pool_alloc      (pool *P);
+void    pool_free       (pool *P, void *slot);
+
+#endif /* _pool_h */
@@ -18,72 +18,205 @@
 #include "heap.h"
 #include "priority_queue.h"
 
+/* Checking the heap property takes O(n) time, so debug builds only do it after the 2^k-th change
+ * for every k, which costs O(1) per operation in the long run. */
+#ifndef NDEBUG
+#define _check_heap(Q) do { \
+    ++(Q)->n_ops; \
+    if (((Q)->n_ops & ((Q)->n_ops - 1)) == 0) { \
+        assert(is_heap((Q)->V.data, (Q)->V.count, \
+                       t_size((Q)->V.data_type), (Q)->V.data_type->compare)); \
+    } \
+} while (0)
+#else
+#define _check_heap(Q)
+#endif
+
+/* int pqueue_initialize     (pqueue *Q, t_intf *dt)
+ * int pqueue_initialize_with(pqueue *Q, t_intf *dt, allocator *A)
+ * Initialize the queue at Q for elements with the type interface dt, which must provide a
+ * comparison function. Elements are moved around bytewise on the heap. Return 0 on success, or
+ * -1 on error. pqueue_initialize_with takes all storage from the allocator A. */
+int pqueue_initialize(pqueue *Q, t_intf *dt)
+{
+    return pqueue_initialize_with(Q, dt, NULL);
+}
+
+int pqueue_initialize_with(pqueue *Q, t_intf *dt, allocator *A)
+{
+    check_ptr(Q);
+    check_ptr(dt);
+    check(dt->compare, "no comparison function");
+
+    int rc = vector_initialize_with(&Q->V, dt, A);
+    check_rc(rc, "vector_initialize_with");
+
+    Q->temp = a_allocate(Q->V.alloc, t_size(dt));
+    if (Q->temp == NULL) {
+        vector_destroy(&Q->V);
+        log_error("failed to allocate scratch space");
+        goto error;
+    }
+    Q->n_ops = 0;
+
+    return 0;
+error:
+    return -1;
+}
+
+/* pqueue *pqueue_new(t_intf *dt)
+ * Create a new queue on the heap and initialize it with the type interface dt. Return a pointer
+ * to the new queue or NULL on error. */
+pqueue *pqueue_new(t_intf *dt)
+{
+    pqueue *Q = malloc(sizeof(*Q));
+    check_alloc(Q);
+
+    int rc = pqueue_initialize(Q, dt);
+    check_rc(rc, "pqueue_initialize");
+
+    return Q;
+error:
+    if (Q) free(Q);
+    return NULL;
+}
+
+/* void pqueue_destroy(pqueue *Q)
+ * void pqueue_delete (pqueue *Q)
+ * Destroy Q including all its content and free the allocated storage. pqueue_delete also calls
+ * `free` on Q. */
+void pqueue_destroy(pqueue *Q)
+{
+    if (Q && Q->temp) {
+        a_deallocate(Q->V.alloc, Q->temp, t_size(Q->V.data_type));
+        Q->temp = NULL;
+        vector_destroy(&Q->V);
+    }
+}
+
+void pqueue_delete(pqueue *Q)
+{
+    if (Q) {
+        pqueue_destroy(Q);
+        free(Q);
+    }
+}
+
+/* void pqueue_clear(pqueue *Q)
+ * Remove and destroy all elements in Q. */
+void pqueue_clear(pqueue *Q)
+{
+    if (Q) vector_clear(&Q->V);
+}
+
 /* int pqueue_enqueue(pqueue *Q, const void *in)
- * Add the item at in to the queue. Return 1 if it was successfully added, or -1 on error. */
+ * Add a copy of the item at in to the queue. Return 1 if it was successfully added, or -1 on
+ * error. */
 int pqueue_enqueue(pqueue *Q, const void *in)
 {
-    char *temp = NULL;
     check_ptr(Q);
     check_ptr(in);
 
-    /* Add the new element at the end. */
-    vector_push_back(Q, in);
-
-    /* Move it upwards until the heap property is satisfied. */
-    if (pqueue_count(Q) > 1) {
-        temp = malloc(t_size(Q->data_type));
-        check_alloc(temp);
-        heap_bubble_up(Q->data, t_size(Q->data_type),
-                       Q->count - 1, Q->data_type->compare, temp);
-        assert(is_heap(Q->data, Q->count,
-                       t_size(Q->data_type),
-                       Q->data_type->compare));
-        free(temp);
-    }
+    /* Add the new element at the end and move it upwards until the heap property is satisfied. */
+    int rc = vector_push_back(&Q->V, in);
+    check_rc(rc, "vector_push_back");
+    heap_bubble_up(Q->V.data, t_size(Q->V.data_type),
+                   Q->V.count - 1, Q->V.data_type->compare, Q->temp);
+    _check_heap(Q);
 
     return 1;
 error:
-    if (temp) free(temp);
     return -1;
 }
 
+/* Replace the top element of the non-empty queue with a copy of in and repair the heap. The old
+ * top element is moved to out, or destroyed if out is NULL. If in and out are the same object,
+ * it simply trades places with the top element. */
+static void _replace_top(pqueue *Q, const void *in, void *out)
+{
+    t_intf *dt = Q->V.data_type;
+    char *top = Q->V.data;
+
+    if (in == out) {
+        t_move(dt, Q->temp, top);
+        t_move(dt, top, out);
+        t_move(dt, out, Q->temp);
+    } else {
+        if (out) t_move(dt, out, top);
+        else t_destroy(dt, top);
+        t_copy(dt, top, in);
+    }
+
+    heap_sift_down(Q->V.data, Q->V.count, t_size(dt), 0, dt->compare, Q->temp);
+    _check_heap(Q);
+}
+
 /* int pqueue_dequeue(pqueue *Q, void *out);
  * Remove the next item in the queue, store it at out (assuming sufficient memory) unless out is
  * NULL. Return 1 if an item was removed, 0 if the queue was empty, or -1 on error. */
 int pqueue_dequeue(pqueue *Q, void *out)
 {
-    char *temp = NULL;
     check_ptr(Q);
-    check_ptr(out);
 
-    if (Q->count == 0) return 0;
+    if (Q->V.count == 0) return 0;
 
-    if (out) t_move(Q->data_type, out, vector_first(Q));
-    else t_destroy(Q->data_type, vector_first(Q));
+    t_intf *dt = Q->V.data_type;
+    if (out) t_move(dt, out, vector_first(&Q->V));
+    else t_destroy(dt, vector_first(&Q->V));
 
-    /* move the last element to the top */
-    t_move(Q->data_type, vector_first(Q), vector_last(Q));
-    --Q->count;
-    if (Q->count < (Q->capacity >> 2) && Q->capacity > VECTOR_MIN_CAPACITY) {
-        int rc = vector_shrink_to_fit(Q);
+    /* Move the last element to the top and let it sink. */
+    --Q->V.count;
+    if (Q->V.count > 0) {
+        t_move(dt, Q->V.data, Q->V.data + Q->V.count * t_size(dt));
+        heap_sift_down(Q->V.data, Q->V.count, t_size(dt), 0, dt->compare, Q->temp);
+    }
+    _check_heap(Q);
+
+    if (Q->V.count < (Q->V.capacity >> 2) && Q->V.capacity > VECTOR_MIN_CAPACITY) {
+        int rc = vector_shrink_to_fit(&Q->V);
         if (rc < 0) log_warn("failed to contract internal storage");
     }
 
-    /* Repair the heap. */
-    if (Q->count > 1) {
-        temp = malloc(t_size(Q->data_type));
-        check_alloc(temp);
-        heap_sift_down(Q->data, Q->count,
-                       t_size(Q->data_type), 0,
-                       Q->data_type->compare, temp);
-        assert(is_heap(Q->data, Q->count,
-                       t_size(Q->data_type),
-                       Q->data_type->compare));
-        free(temp);
+    return 1;
+error:
+    return -1;
+}
+
+/* int pqueue_push_pop(pqueue *Q, const void *in, void *out)
+ * Add a copy of in to the queue and then remove the next item, storing it at out unless out is
+ * NULL. Cheaper than pqueue_enqueue followed by pqueue_dequeue: if in would come out first, the
+ * queue isn't touched at all, otherwise it takes the place of the top element. in and out may
+ * point to the same object. Return 1 on success, or -1 on error. */
+int pqueue_push_pop(pqueue *Q, const void *in, void *out)
+{
+    check_ptr(Q);
+    check_ptr(in);
+
+    t_intf *dt = Q->V.data_type;
+    if (Q->V.count == 0 || dt->compare(in, Q->V.data) >= 0) {
+        if (out && out != in) t_copy(dt, out, in);
+        return 1;
     }
 
+    _replace_top(Q, in, out);
+    return 1;
+error:
+    return -1;
+}
+
+/* int pqueue_replace_top(pqueue *Q, const void *in, void *out)
+ * Remove the next item from the queue and then add a copy of in, in a single pass over the heap.
+ * The removed item is stored at out unless out is NULL; in and out may point to the same object.
+ * Return 1 on success, or 0 if the queue was empty, in which case in isn't added either. */
+int pqueue_replace_top(pqueue *Q, const void *in, void *out)
+{
+    check_ptr(Q);
+    check_ptr(in);
+
+    if (Q->V.count == 0) return 0;
+
+    _replace_top(Q, in, out);
     return 1;
 error:
-    if (temp) free(temp);
     return -1;
 }
@@ -2,7 +2,8 @@
  *
  * priority_queue.h
  *
- * Declaration of the priority queue abstraction. See also vector.h and heap.h.
+ * Declaration of the priority queue abstraction: a heap on a vector, plus scratch space for one
+ * element that the heap operations need. See also vector.h and heap.h.
  *
  * Author: Florian Kretlow, 2020
  * Licensed under the MIT License.
@@ -12,20 +13,30 @@
 #ifndef _priority_queue_h
 #define _priority_queue_h
 
+#include "allocator.h"
 #include "type_interface.h"
 #include "vector.h"
 
-typedef vector pqueue;
+typedef struct {
+    vector      V;
+    char *      temp;       /* scratch space for one element */
+    size_t      n_ops;      /* the number of changes, for the sampled heap check in debug builds */
+} pqueue;
 
-#define pqueue_count(Q)             vector_count(Q)
-#define pqueue_empty(Q)             vector_empty(Q)
-#define pqueue_initialize(Q, dt)    vector_initialize(Q, dt)
-#define pqueue_destroy(Q)           vector_destroy(Q)
-#define pqueue_new(dt)              vector_new(dt)
-#define pqueue_delete(Q)            vector_delete(Q)
-#define pqueue_clear(Q)             vector_clear(Q)
+#define pqueue_count(Q)             vector_count(&(Q)->V)
+#define pqueue_empty(Q)             vector_empty(&(Q)->V)
+#define pqueue_top(Q)               vector_first(&(Q)->V)
 
-int pqueue_enqueue(pqueue *Q, const void *in);
-int pqueue_dequeue(pqueue *Q, void *out);
+int         pqueue_initialize       (pqueue *Q, t_intf *dt);
+int         pqueue_initialize_with  (pqueue *Q, t_intf *dt, allocator *A);
+pqueue *    pqueue_new              (           t_intf *dt);
+void        pqueue_destroy          (pqueue *Q);
+void        pqueue_delete           (pqueue *Q);
+void        pqueue_clear            (pqueue *Q);
+
+int         pqueue_enqueue          (pqueue *Q, const void *in);
+int         pqueue_dequeue          (pqueue *Q, void *out);
+int         pqueue_push_pop         (pqueue *Q, const void *in, void *out);
+int         pqueue_replace_top      (pqueue *Q, const void *in, void *out);
 
 #endif /* _priority_queue_h */
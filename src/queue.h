@@ -16,7 +16,8 @@ typedef list queue;
 #define queue_count(Q)          list_count(Q)
 #define queue_empty(Q)          list_empty(Q)
 
-#define queue_initialize(Q, dt) list_initialize(dt)
+#define queue_initialize(Q, dt) list_initialize(Q, dt)
+#define queue_initialize_with(Q, dt, A) list_initialize_with(Q, dt, A)
 #define queue_new(dt)           list_new(dt)
 #define queue_delete(Q)         list_delete(Q)
 #define queue_clear(Q)          list_clear(Q)
@@ -1,7 +1,9 @@
 /*************************************************************************************************
  *
  * quicksort.c
- * Implementation of the quicksort algorithm. Sources: Skiena, Wikipedia.
+ * Implementation of the quicksort algorithm as an introsort: median-of-three or ninther pivots,
+ * and a fallback to heapsort when the recursion gets too deep. Sources: Skiena, Wikipedia,
+ * Musser (1997).
  *
  ************************************************************************************************/
 
@@ -10,43 +12,66 @@
 #include <string.h>
 
 #include "check.h"
+#include "heap.h"
 #include "sort_tools.h"
 
-static size_t _partition(char *base,
-                         size_t start, size_t end,
-                         size_t size,
-                         compare_f compare,
-                         char *temp)
+/* Use the median of three elements as the pivot for ranges up to this size, and the median of
+ * three medians of three (Tukey's ninther) for larger ranges. */
+#define NINTHER_THRESHOLD 128
+
+/* Return the index of the median of the elements at the indices a, b and c. */
+static inline size_t _median3(char *base, size_t a, size_t b, size_t c,
+                              size_t size,
+                              compare_f compare)
 {
-    // Lomuto partitioning scheme
-    /* size_t first_high, pivot;
+    if (compare(base + a * size, base + b * size) < 0) {
+        if (compare(base + b * size, base + c * size) < 0) return b;
+        return compare(base + a * size, base + c * size) < 0 ? c : a;
+    } else {
+        if (compare(base + a * size, base + c * size) < 0) return a;
+        return compare(base + b * size, base + c * size) < 0 ? c : b;
+    }
+}
 
-    first_high = start;
-    pivot = end - 1;
+static size_t _choose_pivot(char *base,
+                            size_t start, size_t end,
+                            size_t size,
+                            compare_f compare)
+{
+    size_t n = end - start;
+    size_t m = start + n / 2;
+    size_t l = end - 1;
 
-    for (size_t i = start; i < pivot; ++i) {
-        if (compare(base + i*size, base + pivot*size) < 0) {
-            _swap((base + i*size), (base + first_high*size), size, temp);
-            ++first_high;
-        }
+    if (n < NINTHER_THRESHOLD) {
+        return _median3(base, start, m, l, size, compare);
+    } else {
+        size_t d = n / 8;
+        size_t a = _median3(base, start, start + d, start + 2 * d, size, compare);
+        size_t b = _median3(base, m - d, m, m + d, size, compare);
+        size_t c = _median3(base, l - 2 * d, l - d, l, size, compare);
+        return _median3(base, a, b, c, size, compare);
     }
-    _swap((base + first_high*size), (base + pivot*size), size, temp);
-
-    return first_high; */
+}
 
+size_t _partition(char *base,
+                  size_t start, size_t end,
+                  size_t size,
+                  compare_f compare,
+                  char *temp)
+{
     // Hoare partitioning scheme
     size_t i = start - 1;
     size_t j = end;
 
-    /* It's important to get the pivot position right to guarantee it's not at the last index in
-     * the range. Otherwise the upper partition could end up empty, which would lead to infinite
-     * recursion. */
-    size_t p = (end - 1 + start) / 2;
+    /* The pivot is the median of at least three elements, so there's at least one other element
+     * >= pivot before the last index and one <= pivot after the first index. This guarantees that
+     * neither partition ends up empty, which would lead to infinite recursion. */
+    size_t p = _choose_pivot(base, start, end, size, compare);
 
     /* Copy the pivot value to the allocated workspace because it may be moved and it's ugly (and
      * less efficient?) to keep track of it. */
     char *pivot = temp + size;
-    memcpy(pivot, base + p * size, size);
+    _copy(pivot, base + p * size, size);
 
     for ( ;; ) {
         do {
@@ -70,35 +95,70 @@ static size_t _partition(char *base,
     }
 }
 
-static void _quicksort(char *base,
-                        size_t start, size_t end,
-                        size_t size,
-                        compare_f compare,
-                        char *temp)
+/* Sort [start, end[ with heapsort. Used when quicksort exceeds its recursion budget. */
+static void _heapsort(char *base,
+                      size_t start, size_t end,
+                      size_t size,
+                      compare_f compare,
+                      char *temp)
 {
-    if (end - start <= 1) {
-        return;
-    } else if (end - start <= 16) {
-        /* Using insertion sort for short ranges seems to give a significant speed boost of about
-         * 10-15%. */
-        _insertionsort(base, start, end, size, compare, temp);
-    } else {
+    char *a = base + start * size;
+    size_t n = end - start;
+
+    make_heap(a, n, size, compare, temp);
+    while (n > 1) {
+        --n;
+        _swap(a, a + n * size, size, temp);
+        heap_sift_down(a, n, size, 0, compare, temp);
+    }
+}
+
+/* Introsort: quicksort that falls back to heapsort once the recursion depth exceeds depth, which
+ * bounds the worst case at O(n log n). Only the smaller partition is sorted recursively, the
+ * larger one iteratively, so the stack never grows beyond O(log n) frames either. */
+void _quicksort(char *base,
+                size_t start, size_t end,
+                size_t size,
+                compare_f compare,
+                char *temp,
+                unsigned depth)
+{
+    while (end - start > 16) {
+        if (depth == 0) {
+            _heapsort(base, start, end, size, compare, temp);
+            return;
+        }
+        --depth;
+
         size_t p = _partition(base, start, end, size, compare, temp);
-        // Lomuto partitioning scheme
-        /* _quicksort(base, start, p, size, compare, temp);
-        _quicksort(base, p + 1, end, size, compare, temp); */
+        if (p + 1 - start < end - p - 1) {
+            _quicksort(base, start, p + 1, size, compare, temp, depth);
+            start = p + 1;
+        } else {
+            _quicksort(base, p + 1, end, size, compare, temp, depth);
+            end = p + 1;
+        }
+    }
 
-        // Hoare partitioning scheme
-        _quicksort(base, start, p + 1, size, compare, temp);
-        _quicksort(base, p + 1, end, size, compare, temp);
+    /* Using insertion sort for short ranges seems to give a significant speed boost of about
+     * 10-15%. */
+    if (end - start > 1) {
+        _insertionsort(base, start, end, size, compare, temp);
     }
 }
 
 void quicksort(void *base, size_t nmemb, size_t size, compare_f compare) {
+    /* Sort directly if the pointer array for the indirect sort can't be allocated. */
+    if (size > SORT_INDIRECT_SIZE
+            && _sort_indirect(base, nmemb, size, compare, quicksort) == 0) {
+        return;
+    }
+
     // Allocate workspace for swaps and the pivot value.
     char *temp = malloc(2 * size);
     check_alloc(temp);
-    _quicksort((char*)base, 0, nmemb, size, compare, temp);
+
+    _quicksort((char*)base, 0, nmemb, size, compare, temp, _introsort_depth(nmemb));
     free(temp);
 error:
     return; /* TODO: error handling?? */
@@ -0,0 +1,221 @@
+/*************************************************************************************************
+ *
+ * radixsort.c
+ * Implementation of radix sorts on integer and float keys. Sources: Sedgewick, Wikipedia, and
+ * Pierre Terdiman, "Radix Sort Revisited" (2000).
+ *
+ * The LSD variants sort arrays of numbers one byte at a time, starting with the least significant
+ * byte. The histograms for all bytes are computed in a single pass up front, which also shows
+ * which bytes are the same for all elements; those passes are skipped. The MSD variant sorts
+ * arbitrary elements by a 64-bit key obtained from a callback, starting with the most significant
+ * byte and recursing into the buckets, again skipping bytes that don't discriminate. All of them
+ * are stable.
+ *
+ ************************************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "sort.h"
+
+#define RADIX_BITS          8
+#define RADIX               (1 << RADIX_BITS)
+#define RADIX_MSD_CUTOFF    64
+
+/* Generate an LSD radix sort on arrays of type T. flip is XORed with every element before its
+ * digits are taken, which is how signed integers are ordered correctly: flipping the sign bit
+ * maps INT_MIN..INT_MAX to 0..UINT_MAX in order. */
+#define _define_lsd(name, T) \
+static int name(T *A, size_t n, T flip) \
+{ \
+    enum { n_digits = sizeof(T) }; \
+    size_t (*counts)[RADIX] = NULL; \
+    T *buffer = NULL; \
+    \
+    if (n < 2) return 0; \
+    \
+    counts = calloc(n_digits, sizeof(*counts)); \
+    check_alloc(counts); \
+    for (size_t i = 0; i < n; ++i) { \
+        T x = A[i] ^ flip; \
+        for (unsigned d = 0; d < n_digits; ++d) { \
+            ++counts[d][(x >> (d * RADIX_BITS)) & (RADIX - 1)]; \
+        } \
+    } \
+    \
+    buffer = malloc(n * sizeof(T)); \
+    check_alloc(buffer); \
+    \
+    T *src = A, *dest = buffer; \
+    for (unsigned d = 0; d < n_digits; ++d) { \
+        size_t *count = counts[d]; \
+        unsigned shift = d * RADIX_BITS; \
+        \
+        /* All elements have the same digit: nothing to do. */ \
+        if (count[((src[0] ^ flip) >> shift) & (RADIX - 1)] == n) continue; \
+        \
+        size_t offset = 0; \
+        for (unsigned b = 0; b < RADIX; ++b) { \
+            size_t c = count[b]; \
+            count[b] = offset; \
+            offset += c; \
+        } \
+        for (size_t i = 0; i < n; ++i) { \
+            dest[count[((src[i] ^ flip) >> shift) & (RADIX - 1)]++] = src[i]; \
+        } \
+        \
+        T *t = src; \
+        src = dest; \
+        dest = t; \
+    } \
+    \
+    if (src != A) memcpy(A, src, n * sizeof(T)); \
+    \
+    free(buffer); \
+    free(counts); \
+    return 0; \
+error: \
+    if (counts) free(counts); \
+    return -1; \
+}
+
+_define_lsd(_lsd32, uint32_t)
+_define_lsd(_lsd64, uint64_t)
+
+/* int radixsort_u32  (uint32_t *A, size_t n)
+ * int radixsort_u64  (uint64_t *A, size_t n)
+ * int radixsort_int  (int *A, size_t n)
+ * int radixsort_float(float *A, size_t n)
+ * Sort the array A of n numbers in ascending order. Negative zero is ordered before zero, and NaNs
+ * are ordered by their bit patterns (at the ends). Return 0 on success, or -1 on error. */
+int radixsort_u32(uint32_t *A, size_t n)
+{
+    return _lsd32(A, n, 0);
+}
+
+int radixsort_u64(uint64_t *A, size_t n)
+{
+    return _lsd64(A, n, 0);
+}
+
+int radixsort_int(int *A, size_t n)
+{
+    _Static_assert(sizeof(int) == sizeof(uint32_t), "radixsort_int expects 32-bit int");
+    return _lsd32((uint32_t*)A, n, UINT32_C(1) << 31);
+}
+
+int radixsort_float(float *A, size_t n)
+{
+    _Static_assert(sizeof(float) == sizeof(uint32_t), "radixsort_float expects 32-bit float");
+    uint32_t *U = (uint32_t*)A;
+
+    /* Map floats to unsigned integers with the same order: flip all bits of negative numbers
+     * (whose magnitude grows with the bit pattern), and only the sign bit of positive ones. */
+    for (size_t i = 0; i < n; ++i) {
+        U[i] ^= (U[i] >> 31) ? UINT32_MAX : UINT32_C(1) << 31;
+    }
+
+    int rc = _lsd32(U, n, 0);
+
+    for (size_t i = 0; i < n; ++i) {
+        U[i] ^= (U[i] >> 31) ? UINT32_C(1) << 31 : UINT32_MAX;
+    }
+
+    return rc;
+}
+
+/* MSD radix sort on elements of any size with keys from a callback. */
+
+struct msd {
+    size_t      size;
+    uint64_t    (*key)(const void *);
+    char *      buffer;
+};
+
+/* Stable insertion sort by key for small buckets. */
+static void _msd_insertionsort(struct msd *S, char *base, size_t n)
+{
+    size_t size = S->size;
+    char *temp = S->buffer;
+
+    for (size_t i = 1; i < n; ++i) {
+        uint64_t k = S->key(base + i * size);
+        size_t j = i;
+        if (S->key(base + (j - 1) * size) <= k) continue;
+        memcpy(temp, base + i * size, size);
+        do {
+            memcpy(base + j * size, base + (j - 1) * size, size);
+            --j;
+        } while (j > 0 && S->key(base + (j - 1) * size) > k);
+        memcpy(base + j * size, temp, size);
+    }
+}
+
+static void _msd(struct msd *S, char *base, size_t n, int shift)
+{
+    size_t size = S->size;
+    size_t count[RADIX];
+
+    while (n > 1) {
+        if (n <= RADIX_MSD_CUTOFF) {
+            _msd_insertionsort(S, base, n);
+            return;
+        }
+
+        memset(count, 0, sizeof(count));
+        for (size_t i = 0; i < n; ++i) {
+            ++count[(S->key(base + i * size) >> shift) & (RADIX - 1)];
+        }
+
+        /* If all elements fall into the same bucket, go straight to the next digit. */
+        unsigned b = (S->key(base) >> shift) & (RADIX - 1);
+        if (count[b] < n) break;
+        if (shift == 0) return;
+        shift -= RADIX_BITS;
+    }
+    if (n <= 1) return;
+
+    /* Scatter into the buffer by the current digit and copy back. */
+    size_t offset[RADIX];
+    size_t o = 0;
+    for (unsigned b = 0; b < RADIX; ++b) {
+        offset[b] = o;
+        o += count[b];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        unsigned b = (S->key(base + i * size) >> shift) & (RADIX - 1);
+        memcpy(S->buffer + offset[b]++ * size, base + i * size, size);
+    }
+    memcpy(base, S->buffer, n * size);
+
+    if (shift == 0) return;
+
+    o = 0;
+    for (unsigned b = 0; b < RADIX; ++b) {
+        if (count[b] > 1) _msd(S, base + o * size, count[b], shift - RADIX_BITS);
+        o += count[b];
+    }
+}
+
+/* int radixsort_by_key(void *base, size_t nmemb, size_t size, uint64_t (*key)(const void *))
+ * Sort the array at base of nmemb elements of the given size in ascending order of the unsigned
+ * keys that key returns for them. Elements with equal keys keep their relative order. key should
+ * be cheap; it's called a few times per element and digit. Return 0 on success, or -1 on error. */
+int radixsort_by_key(void *base, size_t nmemb, size_t size, uint64_t (*key)(const void *))
+{
+    check_ptr(base);
+    check_ptr(key);
+    if (nmemb < 2) return 0;
+
+    struct msd S = { .size = size, .key = key, .buffer = malloc(nmemb * size) };
+    check_alloc(S.buffer);
+
+    _msd(&S, base, nmemb, 64 - RADIX_BITS);
+
+    free(S.buffer);
+    return 0;
+error:
+    return -1;
+}
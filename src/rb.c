@@ -25,7 +25,8 @@
 
 /* static inline bst_n *rb_n_rotate_left  (bst_n **np)
  * static inline bst_n *rb_n_rotate_right (bst_n **np)
- * Normal tree rotations with RB color adjustments. The pointer at np is changed. */
+ * Normal tree rotations with RB color adjustments. The pointer at np is changed. The new root
+ * takes over the subtree size of the old one, which then gets the size of its new subtree. */
 static inline void rb_n_rotate_left(bst_n **np)
 {
     bst_n *n = *np;
@@ -35,6 +36,8 @@ static inline void rb_n_rotate_left(bst_n **np)
     r->left = n;
     r->flags.rb.color = n->flags.rb.color;
     n->flags.rb.color = RED;
+    r->count = n->count;
+    bst_n_update_count(n);
     *np = r;
 }
 
@@ -47,6 +50,8 @@ static inline void rb_n_rotate_right(bst_n **np)
     l->right = n;
     l->flags.rb.color = n->flags.rb.color;
     n->flags.rb.color = RED;
+    l->count = n->count;
+    bst_n_update_count(n);
     *np = l;
 }
 
@@ -108,6 +113,7 @@ int rb_n_insert(bst *T,
         rc = 0;
     }
 
+    if (rc == 1) ++n->count;
     rb_n_repair(&n);
     *np = n;
     return rc;
@@ -168,6 +174,7 @@ int rb_n_remove_min(bst *T, bst_n **np)
         /* Ensure the left child isn't a 2-node. */
         if (n->left && !rb_n_is_red(n->left) && !rb_n_is_red(n->left->left))  rb_n_move_red_left(&n);
         rc = rb_n_remove_min(T, &n->left);
+        --n->count;
         rb_n_repair(&n);
         *np = n;
     }
@@ -229,6 +236,7 @@ int rb_n_remove(
         }
     }
 
+    if (rc == 1) --n->count;
     rb_n_repair(&n);
     *np = n;
     return rc;
@@ -0,0 +1,175 @@
+/*************************************************************************************************
+ *
+ * select.c
+ * Selection algorithms: nth_element (introselect), partial_sort, and a streaming top-k
+ * accumulator. Sources: Musser (1997), Wikipedia.
+ *
+ * nth_element partitions like quicksort but only continues with the side that contains the
+ * wanted index, which takes O(n) time on average; when the partitions keep coming out badly it
+ * switches to heap selection, so the worst case is O(n log n). partial_sort and topk keep the k
+ * smallest elements seen so far in a max-heap, which takes O(n log k) time.
+ *
+ ************************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "heap.h"
+#include "sort.h"
+#include "sort_tools.h"
+
+/* Move the k smallest elements of the n elements at base to the front, as a max-heap. */
+static void _heap_select(char *base, size_t n, size_t k, size_t size,
+                         compare_f compare,
+                         char *temp)
+{
+    make_heap(base, k, size, compare, temp);
+    for (size_t i = k; i < n; ++i) {
+        if (compare(base + i * size, base) < 0) {
+            _swap(base, base + i * size, size, temp);
+            heap_sift_down(base, k, size, 0, compare, temp);
+        }
+    }
+}
+
+/* Sort the max-heap of n elements at base in place. */
+static void _sort_heap(char *base, size_t n, size_t size, compare_f compare, char *temp)
+{
+    while (n > 1) {
+        --n;
+        _swap(base, base + n * size, size, temp);
+        heap_sift_down(base, n, size, 0, compare, temp);
+    }
+}
+
+/* void nth_element(void *base, size_t nmemb, size_t size, compare_f compare, size_t n)
+ * Rearrange the array at base of nmemb elements of the given size so that the element at index
+ * n is the one that would be there if the array were sorted, no element before it is greater and
+ * no element after it is smaller. Nothing happens if n >= nmemb. */
+void nth_element(void *base, size_t nmemb, size_t size, compare_f compare, size_t n)
+{
+    char *temp = NULL;
+    if (n >= nmemb) return;
+
+    temp = malloc(2 * size);
+    check_alloc(temp);
+
+    char *a = base;
+    size_t start = 0, end = nmemb;
+    unsigned depth = _introsort_depth(nmemb);
+
+    while (end - start > 16) {
+        if (depth == 0) {
+            /* Heap selection: the n - start + 1 smallest elements of the range form a max-heap
+             * at its front, with the element we want on top. */
+            _heap_select(a + start * size, end - start, n - start + 1, size, compare, temp);
+            _swap(a + start * size, a + n * size, size, temp);
+            free(temp);
+            return;
+        }
+        --depth;
+
+        size_t p = _partition(a, start, end, size, compare, temp);
+        if (n <= p) {
+            end = p + 1;
+        } else {
+            start = p + 1;
+        }
+    }
+    if (end - start > 1) {
+        _insertionsort(a, start, end, size, compare, temp);
+    }
+
+    free(temp);
+error:
+    return;
+}
+
+/* void partial_sort(void *base, size_t nmemb, size_t size, compare_f compare, size_t k)
+ * Rearrange the array at base of nmemb elements of the given size so that the first k elements
+ * are the k smallest, in ascending order. The order of the others is unspecified. */
+void partial_sort(void *base, size_t nmemb, size_t size, compare_f compare, size_t k)
+{
+    char *temp = NULL;
+    if (k > nmemb) k = nmemb;
+    if (k == 0) return;
+
+    temp = malloc(size);
+    check_alloc(temp);
+
+    _heap_select(base, nmemb, k, size, compare, temp);
+    _sort_heap(base, k, size, compare, temp);
+
+    free(temp);
+error:
+    return;
+}
+
+/* int topk_initialize(topk *T, size_t k, size_t size, compare_f compare)
+ * Initialize the accumulator T to keep the k smallest of the elements of the given size pushed
+ * into it, in the order given by compare. (Reverse the comparison to keep the k largest.)
+ * Return 0 on success or -1 on error. */
+int topk_initialize(topk *T, size_t k, size_t size, compare_f compare)
+{
+    check_ptr(T);
+    check_ptr(compare);
+    check(k > 0 && size > 0, "invalid arguments: k = %zu, size = %zu", k, size);
+
+    T->data = malloc((k + 1) * size);
+    check_alloc(T->data);
+    T->k = k;
+    T->count = 0;
+    T->size = size;
+    T->compare = compare;
+    return 0;
+error:
+    return -1;
+}
+
+/* void topk_destroy(topk *T)
+ * Free the memory allocated by T. */
+void topk_destroy(topk *T)
+{
+    if (T && T->data) {
+        free(T->data);
+        T->data = NULL;
+        T->count = 0;
+    }
+}
+
+/* int topk_push(topk *T, const void *e)
+ * Offer the element e to T. The elements are copied bytewise. Return 1 if e is among the k
+ * smallest elements so far and was kept, 0 if not, or -1 on error. */
+int topk_push(topk *T, const void *e)
+{
+    check_ptr(T);
+    check_ptr(e);
+
+    size_t size = T->size;
+    char *temp = T->data + T->k * size;
+
+    if (T->count < T->k) {
+        memcpy(T->data + T->count * size, e, size);
+        heap_bubble_up(T->data, size, T->count++, T->compare, temp);
+        return 1;
+    }
+
+    /* The heap is full: e replaces the greatest element if it's smaller. */
+    if (T->compare(e, T->data) >= 0) return 0;
+    memcpy(T->data, e, size);
+    heap_sift_down(T->data, T->count, size, 0, T->compare, temp);
+    return 1;
+error:
+    return -1;
+}
+
+/* size_t topk_extract(topk *T, void *out)
+ * Copy the elements kept by T to out in ascending order, and return their number (at most k).
+ * T is not modified. */
+size_t topk_extract(topk *T, void *out)
+{
+    memcpy(out, T->data, T->count * T->size);
+    _sort_heap(out, T->count, T->size, T->compare, T->data + T->k * T->size);
+    return T->count;
+}
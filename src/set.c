@@ -4,17 +4,23 @@
  *
  * Implementation of the set methods that are not covered by generic BST methods.
  *
+ * The set operations walk through both operands in order with two iterators, like the merge step
+ * of mergesort, and collect the elements of the result in a sorted array of pointers. The result
+ * tree is then built directly from the array, perfectly balanced, in linear time. Red-black
+ * results are built as 2-3 trees with all leaves at the same depth, so they satisfy the LLRB
+ * invariants without any rotations. So all three operations take O(m + n) time.
+ *
  * Author: Florian Kretlow, 2020
  * Licensed under the MIT License.
  *
  ************************************************************************************************/
 
+#include <assert.h>
 #include <stdlib.h>
 
 #include "check.h"
 #include "log.h"
 #include "set.h"
-#include "vector.h"
 
 set *set_new(t_intf *dt)
 {
@@ -30,107 +36,190 @@ error:
     return NULL;
 }
 
-/* set *set_union(set *S1, set *S2)
- * Return a new set that contains all elements that are in either of S1 and S2 or both, or NULL on
- * error.
- * Create an exact copy of the larger set in linear time and traverse the smaller set, inserting
- * each of its elements into the copy. If m, n are the sizes of the larger and the smaller set
- * respectively, this gives an upper bound of m + n * log (m + n) steps. */
-static inline int insert_into_set(void *e, void *S)
+enum set_ops { SET_UNION, SET_INTERSECTION, SET_DIFFERENCE };
+
+/* Merge the elements of S1 and S2 in ascending order and store pointers to those that belong to
+ * the result of op in E. Return their number. */
+static size_t set_merge(set *S1, set *S2, int op, const void **E)
 {
-    int rc = set_insert(S, e);
-    return rc >= 0 ? 0 : -1;
+    bst_iter i1, i2;
+    void *a = bst_iter_first(&i1, S1);
+    void *b = bst_iter_first(&i2, S2);
+    size_t n = 0;
+
+    while (a && b) {
+        int cmp = t_compare(S1->key_type, a, b);
+        if (cmp < 0) {
+            if (op != SET_INTERSECTION) E[n++] = a;
+            a = bst_iter_next(&i1);
+        } else if (cmp > 0) {
+            if (op == SET_UNION) E[n++] = b;
+            b = bst_iter_next(&i2);
+        } else { /* cmp == 0 */
+            if (op != SET_DIFFERENCE) E[n++] = a;
+            a = bst_iter_next(&i1);
+            b = bst_iter_next(&i2);
+        }
+    }
+
+    if (op != SET_INTERSECTION) {
+        for ( ; a; a = bst_iter_next(&i1)) E[n++] = a;
+    }
+    if (op == SET_UNION) {
+        for ( ; b; b = bst_iter_next(&i2)) E[n++] = b;
+    }
+    return n;
 }
 
-set *set_union(set *S1, set *S2)
+/* Create a node for a copy of e with the subtrees l and r and store it at np. On error, delete
+ * the subtrees. */
+static int set_n_join(set *S, bst_n *l, const void *e, bst_n *r, bst_n **np)
 {
-    set *larger = set_count(S1) > set_count(S2) ? S1 : S2;
-    set *smaller = larger == S1 ? S2 : S1;
+    bst_n *n = bst_n_new(S, e, NULL);
+    if (!n) {
+        if (l) bst_n_delete_rec(S, l);
+        if (r) bst_n_delete_rec(S, r);
+        log_error("failed to create new node");
+        return -1;
+    }
+    n->left = l;
+    n->right = r;
+    bst_n_update_count(n);
+    *np = n;
+    return 0;
+}
 
-    set *U = set_copy(larger);
-    set_traverse(smaller, insert_into_set, U);
-    return U;
+/* The height of a perfectly balanced tree with n nodes. */
+static int set_height(size_t n)
+{
+    int h = 0;
+    for ( ; n; n >>= 1) ++h;
+    return h;
 }
 
-/* set *set_intersection(set *S1, set *S2)
- * Return a new set that contains all elements that are in both S1 and S2 or NULL on error.
- * The naive approach would be to create a new set, then traverse both sets and insert every
- * element into the new set. If m is the size of the larger set, and n of the other one, that
- * would require m + n insertions with a logarithmic number of steps each, resulting in an upper
- * bound of (m + n) * log n steps.  We trade space for time and create two arrays of pointers to
- * data elements as an in-between data structure in linear time. Then we walk through both arrays
- * simultaneously, comparing elements and inserting only elements that are in both arrays. This
- * should give us slightly fewer m + n + n * log n steps. */
-
-static inline int push_pointer_into_vector(void *e, void *V)
+/* Build a perfectly balanced tree from the n sorted elements at E, with AVL balance factors. */
+static int set_build_balanced(set *S, const void **E, size_t n, bst_n **np)
 {
-    int rc = vector_push_back(V, &e);
-    return rc >= 0 ? 0 : -1;
+    bst_n *l = NULL, *r = NULL;
+    *np = NULL;
+    if (n == 0) return 0;
+
+    size_t m = n / 2;
+    if (set_build_balanced(S, E, m, &l) < 0) return -1;
+    if (set_build_balanced(S, E + m + 1, n - m - 1, &r) < 0) {
+        if (l) bst_n_delete_rec(S, l);
+        return -1;
+    }
+    if (set_n_join(S, l, E[m], r, np) < 0) return -1;
+
+    if (S->flavor == AVL) {
+        (*np)->flags.avl.balance = set_height(n - m - 1) - set_height(m);
+    }
+    return 0;
 }
 
-set *set_intersection(set *S1, set *S2)
+/* Build a left-leaning red-black tree of black height h from the n sorted elements at E, which
+ * requires 2^h - 1 <= n <= 3^h - 1. This is a 2-3 tree with all leaves at depth h, where a
+ * 3-node is a black node with a red left child. Each subtree of a node gets an equal share of
+ * the elements. */
+static int set_build_rb(set *S, const void **E, size_t n, int h, bst_n **np)
 {
-    set *I = NULL;
-    vector V1, V2;
-    void *e1, *e2;
-    int comp;
+    bst_n *a = NULL, *b = NULL, *c = NULL, *x = NULL;
+    *np = NULL;
+    if (n == 0) return 0;
+
+    size_t max = 1;
+    for (int i = 1; i < h; ++i) max *= 3;
+    --max;  /* the most elements a subtree of black height h - 1 can take */
+
+    if (n - 1 <= 2 * max) {
+        /* a 2-node */
+        size_t na = (n - 1) / 2;
+        if (set_build_rb(S, E, na, h - 1, &a) < 0) return -1;
+        if (set_build_rb(S, E + na + 1, n - na - 1, h - 1, &b) < 0) goto error;
+        if (set_n_join(S, a, E[na], b, np) < 0) return -1;
+    } else {
+        /* a 3-node */
+        size_t na = (n - 2) / 3;
+        size_t nb = (n - 2 - na) / 2;
+        size_t nc = n - 2 - na - nb;
+        if (set_build_rb(S, E, na, h - 1, &a) < 0) return -1;
+        if (set_build_rb(S, E + na + 1, nb, h - 1, &b) < 0) goto error;
+        if (set_n_join(S, a, E[na], b, &x) < 0) return -1;
+        x->flags.rb.color = RED;
+        a = NULL;
+        b = NULL;
+        if (set_build_rb(S, E + na + nb + 2, nc, h - 1, &c) < 0) goto error;
+        if (set_n_join(S, x, E[na + nb + 1], c, np) < 0) return -1;
+    }
+    (*np)->flags.rb.color = BLACK;
+    return 0;
+error:
+    if (a) bst_n_delete_rec(S, a);
+    if (x) bst_n_delete_rec(S, x);
+    return -1;
+}
+
+/* Compute the result of op on S1 and S2 as a new set of the same kind as S1. */
+static set *set_operation(set *S1, set *S2, int op)
+{
+    const void **E = NULL;
+    set *R = NULL;
 
     check_ptr(S1);
     check_ptr(S2);
     check(S1->key_type == S2->key_type, "Element types don't match.");
 
-    I = set_new(S1->key_type);
-    vector_initialize(&V1, &pointer_type);
-    vector_initialize(&V2, &pointer_type);
-
-    vector_reserve(&V1, set_count(S1));
-    vector_reserve(&V2, set_count(S2));
-
-    set_traverse_r(S1, push_pointer_into_vector, &V1);
-    set_traverse_r(S2, push_pointer_into_vector, &V2);
-
-    vector_pop_back(&V1, &e1);
-    vector_pop_back(&V2, &e2);
-
-    for ( ;; ) {
-        comp = t_compare(S1->key_type, e1, e2);
-        if (comp < 0) {
-            if (vector_count(&V1) == 0) break;
-            vector_pop_back(&V1, &e1);
-        } else if (comp > 0) {
-            if (vector_count(&V2) == 0) break;
-            vector_pop_back(&V2, &e2);
-        } else { /* comp == 0 */
-            set_insert(I, e1);
-            if (vector_count(&V1) == 0 || vector_count(&V2) == 0) break;
-            vector_pop_back(&V1, &e1);
-            vector_pop_back(&V2, &e2);
-        }
+    size_t capacity = set_count(S1) + (op == SET_UNION ? set_count(S2) : 0);
+    if (capacity > 0) {
+        E = malloc(capacity * sizeof(*E));
+        check_alloc(E);
     }
+    size_t n = capacity > 0 ? set_merge(S1, S2, op, E) : 0;
+
+    /* The result takes its nodes from the same allocator as S1, like a copy would. */
+    R = calloc(1, sizeof(*R));
+    check_alloc(R);
+    int rc = bst_initialize_with(R, S1->flavor, S1->key_type, NULL, S1->node_pool.alloc);
+    check_rc(rc, "bst_initialize_with");
+
+    if (S1->flavor == RB) {
+        /* The greatest black height such that the 2-3 tree isn't too big. */
+        int h = set_height(n + 1) - 1;
+        rc = set_build_rb(R, E, n, h, &R->root);
+    } else {
+        rc = set_build_balanced(R, E, n, &R->root);
+    }
+    check_rc(rc, "failed to build result");
+    R->count = n;
 
-    vector_destroy(&V1);
-    vector_destroy(&V2);
-
-    return I;
-
+    assert(bst_invariant(R, NULL) == 0);
+    if (E) free(E);
+    return R;
 error:
-    if (I) set_delete(I);
+    if (R) bst_delete(R);
+    if (E) free(E);
     return NULL;
 }
 
-/* set *set_difference(set *S1, set *S2)
- * Return a new set that contains all elements that are in the first but not in the second set.
- * Create an exact copy of the larger set and traverse the smaller set, removing each of its
- * elements from the copy. */
-static int remove_from_set(void *e, void *S)
+/* set *set_union       (set *S1, set *S2)
+ * set *set_intersection(set *S1, set *S2)
+ * set *set_difference  (set *S1, set *S2)
+ * Return a new set that contains all elements that are in S1 or S2 or both (union), in both S1
+ * and S2 (intersection), or in S1 but not in S2 (difference), or NULL on error. The new set has
+ * the same balancing strategy as S1. If m and n are the sizes of the sets, this takes O(m + n)
+ * time and O(m + n) additional space for the pointers to the elements of the result. */
+set *set_union(set *S1, set *S2)
+{
+    return set_operation(S1, S2, SET_UNION);
+}
+
+set *set_intersection(set *S1, set *S2)
 {
-    int rc = set_remove(S, e);
-    return rc >= 0 ? 0 : 1;
+    return set_operation(S1, S2, SET_INTERSECTION);
 }
 
 set *set_difference(set *S1, set *S2)
 {
-    set *D = set_copy(S1);
-    set_traverse(S2, remove_from_set, D);
-    return D;
+    return set_operation(S1, S2, SET_DIFFERENCE);
 }
@@ -3,7 +3,8 @@
  * set.h
  *
  * Declaration of the set container abstraction that stores unique values. Mostly an adapter to
- * the binary search tree, see bst.c for more info.
+ * the binary search tree, see bst.c for more info. The bset variant is backed by a B-tree
+ * instead (see btree.h).
  *
  * Author: Florian Kretlow, 2020
  * Licensed under the MIT License.
@@ -14,6 +15,7 @@
 #define _set_h
 
 #include "bst.h"
+#include "btree.h"
 #include "type_interface.h"
 
 typedef bst set;
@@ -23,6 +25,7 @@ typedef bst set;
 set *set_new(t_intf *dt);
 #define set_delete(S)               bst_delete(S);
 #define set_initialize(S, dt)       bst_initialize(S, RB, dt, NULL)
+#define set_initialize_with(S, dt, A) bst_initialize_with(S, RB, dt, NULL, A)
 #define set_destroy(S)              bst_destroy(S)
 #define set_clear(S)                bst_clear(S)
 #define set_insert(S, e)            bst_insert(S, e)
@@ -31,9 +34,41 @@ set *set_new(t_intf *dt);
 #define set_has(S, e)               bst_has(S, e);
 #define set_traverse(S, f, p)       bst_traverse_keys(S, f, p)
 #define set_traverse_r(S, f, p)     bst_traverse_keys_r(S, f, p)
+#define set_select(S, i)            bst_select(S, i)
+#define set_rank(S, e)              bst_rank(S, e)
+#define set_count_range(S, lo, hi)  bst_count_range(S, lo, hi)
+#define set_lower_bound(S, e)       bst_lower_bound(S, e)
+#define set_upper_bound(S, e)       bst_upper_bound(S, e)
+#define set_floor(S, e)             bst_floor(S, e)
+#define set_ceiling(S, e)           bst_ceiling(S, e)
+#define set_traverse_range(S, lo, hi, f, p) bst_traverse_range(S, lo, hi, f, p)
+
+typedef bst_iter set_iter;
+
+#define set_iter_first(it, S)       bst_iter_first(it, S)
+#define set_iter_last(it, S)        bst_iter_last(it, S)
+#define set_iter_seek(it, S, e)     bst_iter_seek(it, S, e)
+#define set_iter_next(it)           bst_iter_next(it)
+#define set_iter_prev(it)           bst_iter_prev(it)
 
 set *set_union(set *S1, set *S2);
 set *set_intersection(set *S1, set *S2);
 set *set_difference(set *S1, set *S2);
 
+typedef btree bset;
+
+#define bset_count(S)               btree_count(S)
+#define bset_new(dt)                btree_new(dt, NULL)
+#define bset_delete(S)              btree_delete(S)
+#define bset_initialize(S, dt)      btree_initialize(S, dt, NULL)
+#define bset_initialize_with(S, dt, A) btree_initialize_with(S, dt, NULL, A)
+#define bset_destroy(S)             btree_destroy(S)
+#define bset_clear(S)               btree_clear(S)
+#define bset_insert(S, e)           btree_insert(S, e)
+#define bset_remove(S, e)           btree_remove(S, e)
+#define bset_copy(S)                btree_copy(S)
+#define bset_has(S, e)              btree_has(S, e)
+#define bset_traverse(S, f, p)      btree_traverse_keys(S, f, p)
+#define bset_traverse_r(S, f, p)    btree_traverse_keys_r(S, f, p)
+
 #endif // _set_h
@@ -8,6 +8,7 @@
 #ifndef _sort_h
 #define _sort_h
 
+#include <stdint.h>
 #include <stdlib.h>
 
 typedef void (*sort_f)(void *base, size_t nmemb, size_t size,
@@ -16,12 +17,82 @@ typedef void (*sort_f)(void *base, size_t nmemb, size_t size,
 void quicksort(void *base, size_t nmemb, size_t size,
                int (*compar)(const void*, const void*));
 
+void pdqsort(void *base, size_t nmemb, size_t size,
+             int (*compar)(const void*, const void*));
+
 void mergesort(void *base, size_t nmemb, size_t size,
                int (*compar)(const void*, const void*));
 
+void timsort(void *base, size_t nmemb, size_t size,
+             int (*compar)(const void*, const void*));
+
 void heapsort(void *base, size_t nmemb, size_t size,
               int (*compar)(const void*, const void*));
 
+int radixsort_u32(uint32_t *A, size_t n);
+int radixsort_u64(uint64_t *A, size_t n);
+int radixsort_int(int *A, size_t n);
+int radixsort_float(float *A, size_t n);
+
+int radixsort_by_key(void *base, size_t nmemb, size_t size,
+                     uint64_t (*key)(const void*));
+
+/* The largest number of elements the sorting networks sort. The sortnet functions pass longer
+ * arrays on to the quicksorts of the same type. */
+#define SORTNET_MAX 64lu
+
+void sortnet_i32(int32_t *A, size_t n);
+void sortnet_float(float *A, size_t n);
+void sortnet_i64(int64_t *A, size_t n);
+
+void quicksort_i32(int32_t *A, size_t n);
+void quicksort_float(float *A, size_t n);
+void quicksort_i64(int64_t *A, size_t n);
+
+/* Ranges with fewer elements than this are sorted sequentially by the parallel sorts. */
+#define PARALLEL_SORT_CUTOFF 16384lu
+
+int parallel_sort(void *base, size_t nmemb, size_t size,
+                  int (*compar)(const void*, const void*),
+                  unsigned n_threads);
+
+int parallel_stable_sort(void *base, size_t nmemb, size_t size,
+                         int (*compar)(const void*, const void*),
+                         unsigned n_threads);
+
+int external_sort(int in_fd, int out_fd, size_t size,
+                  int (*compar)(const void*, const void*),
+                  size_t memory);
+
+int external_sort_to(int in_fd, size_t size,
+                     int (*compar)(const void*, const void*),
+                     size_t memory,
+                     int (*emit)(const void *record, void *data), void *data);
+
+void nth_element(void *base, size_t nmemb, size_t size,
+                 int (*compar)(const void*, const void*),
+                 size_t n);
+
+void partial_sort(void *base, size_t nmemb, size_t size,
+                  int (*compar)(const void*, const void*),
+                  size_t k);
+
+/* Streaming top-k: keeps the k smallest elements pushed into it in a max-heap of k + 1 slots
+ * (the last one is scratch space). */
+typedef struct {
+    char *      data;
+    size_t      k;
+    size_t      count;
+    size_t      size;
+    int         (*compare)(const void*, const void*);
+} topk;
+
+int     topk_initialize (topk *T, size_t k, size_t size,
+                         int (*compar)(const void*, const void*));
+void    topk_destroy    (topk *T);
+int     topk_push       (topk *T, const void *e);
+size_t  topk_extract    (topk *T, void *out);
+
 int is_sorted(void *base, size_t nmemb, size_t size,
               int (*compar)(const void*, const void*));
 
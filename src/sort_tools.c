@@ -5,20 +5,86 @@
  *
  ************************************************************************************************/
 
+#include <stdlib.h>
+
+#include "check.h"
 #include "sort_tools.h"
 
 void _insertionsort(char *base,
-                     size_t start, size_t end,
-                     size_t size,
-                     compare_f compare,
-                     char *temp)
+                    size_t start, size_t end,
+                    size_t size,
+                    compare_f compare,
+                    char *temp)
 {
+    /* Take each element out into temp and shift the greater ones before it to the right. */
     size_t i, j;
     for (i = start + 1; i < end; ++i) {
+        if (compare(base + i * size, base + (i - 1) * size) >= 0) continue;
+        _copy(temp, base + i * size, size);
         j = i;
-        while (j > start && compare(base + j * size, base + (j - 1) * size) < 0) {
-            _swap(base + j * size, base + (j - 1) * size, size, temp);
+        do {
+            _copy(base + j * size, base + (j - 1) * size, size);
             --j;
+        } while (j > start && compare(temp, base + (j - 1) * size) < 0);
+        _copy(base + j * size, temp, size);
+    }
+}
+
+/* The comparison function of the current indirect sort. Thread-local so that indirect sorts can
+ * run in several threads at once; saved and restored around nested sorts. */
+static _Thread_local compare_f _indirect_compare_f;
+
+static int _indirect_compare(const void *a, const void *b)
+{
+    return _indirect_compare_f(*(char**)a, *(char**)b);
+}
+
+/* int _sort_indirect(void *base, size_t nmemb, size_t size, compare_f compare, _sort_f sort)
+ * Sort the array with the given algorithm by sorting pointers to its elements, then move every
+ * element to its final place, following the cycles of the permutation. Each element is moved
+ * once, which pays off for large elements. Return 0 on success or -1 on error, in which case the
+ * array is left untouched. */
+int _sort_indirect(void *base, size_t nmemb, size_t size, compare_f compare, _sort_f sort)
+{
+    char **P = NULL;
+    char *temp = NULL;
+
+    P = malloc(nmemb * sizeof(*P));
+    check(P != NULL, "failed to allocate pointer array");
+    temp = malloc(size);
+    check(temp != NULL, "failed to allocate temporary element");
+
+    for (size_t i = 0; i < nmemb; ++i) P[i] = (char*)base + i * size;
+
+    compare_f saved = _indirect_compare_f;
+    _indirect_compare_f = compare;
+    sort(P, nmemb, sizeof(*P), _indirect_compare);
+    _indirect_compare_f = saved;
+
+    /* P[i] now points to the element that belongs at index i. */
+    for (size_t i = 0; i < nmemb; ++i) {
+        char *dest = (char*)base + i * size;
+        if (P[i] == dest) continue;
+
+        memcpy(temp, dest, size);
+        size_t j = i;
+        for ( ;; ) {
+            char *src = P[j];
+            size_t k = (size_t)(src - (char*)base) / size;
+            P[j] = (char*)base + j * size;
+            if (k == i) {
+                memcpy((char*)base + j * size, temp, size);
+                break;
+            }
+            memcpy((char*)base + j * size, src, size);
+            j = k;
         }
     }
+
+    free(temp);
+    free(P);
+    return 0;
+error:
+    if (P) free(P);
+    return -1;
 }
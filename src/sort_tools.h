@@ -9,20 +9,98 @@
 #define _sort_tools_h
 
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
 typedef int (*compare_f)(const void *a, const void *b);
 
+/* Elements larger than this are sorted indirectly: the sorts rearrange an array of pointers to
+ * the elements, and the elements themselves are moved only once at the end. */
+#define SORT_INDIRECT_SIZE 128lu
+
+/* Copy and swap single elements. The element size is the same for all calls during a sort, so
+ * the switch is predicted perfectly, and for the common sizes the fixed-size memcpy calls compile
+ * to plain register moves. dest and src may be the same element in _copy. */
+static inline void _copy(char *dest, const char *src, size_t size)
+{
+    switch (size) {
+    case 1:  *dest = *src; break;
+    case 2:  memcpy(dest, src, 2); break;
+    case 4:  memcpy(dest, src, 4); break;
+    case 8:  memcpy(dest, src, 8); break;
+    case 16: memcpy(dest, src, 16); break;
+    default: memmove(dest, src, size); break;
+    }
+}
+
+#define _swap_as(T, a, b) do { \
+    T _x, _y; \
+    memcpy(&_x, (a), sizeof(T)); \
+    memcpy(&_y, (b), sizeof(T)); \
+    memcpy((a), &_y, sizeof(T)); \
+    memcpy((b), &_x, sizeof(T)); \
+} while (0)
+
 static inline void _swap(char *a, char *b, size_t size, char *temp)
 {
-    memcpy(temp, a, size);
-    memcpy(a, b, size);
-    memcpy(b, temp, size);
+    switch (size) {
+    case 1:  _swap_as(uint8_t, a, b); break;
+    case 2:  _swap_as(uint16_t, a, b); break;
+    case 4:  _swap_as(uint32_t, a, b); break;
+    case 8:  _swap_as(uint64_t, a, b); break;
+    case 16: _swap_as(uint64_t, a, b); _swap_as(uint64_t, a + 8, b + 8); break;
+    default:
+        memcpy(temp, a, size);
+        memcpy(a, b, size);
+        memcpy(b, temp, size);
+        break;
+    }
 }
 
+typedef void (*_sort_f)(void *base, size_t nmemb, size_t size, compare_f compare);
+
+int _sort_indirect(void *base, size_t nmemb, size_t size, compare_f compare, _sort_f sort);
+
 void _insertionsort(char *base,
                     size_t start, size_t end, size_t size,
                     compare_f compare,
                     char *temp);
 
+/* Quicksort (introsort) and mergesort on the range [start, end[, shared with the parallel sorts.
+ * _partition splits the range at the returned index j into [start, j] and ]j, end[. _quicksort
+ * switches to heapsort after depth levels of partitioning; _introsort_depth(n) is the depth
+ * quicksort starts with. _mergesort uses the same range of temp as scratch space. */
+size_t _partition(char *base,
+                  size_t start, size_t end,
+                  size_t size,
+                  compare_f compare,
+                  char *temp);
+
+void _quicksort(char *base,
+                size_t start, size_t end,
+                size_t size,
+                compare_f compare,
+                char *temp,
+                unsigned depth);
+
+static inline unsigned _introsort_depth(size_t n)
+{
+    /* 2 * floor(log2(n)) */
+    unsigned depth = 0;
+    for ( ; n > 1; n >>= 1) depth += 2;
+    return depth;
+}
+
+void _merge(char *base,
+            size_t start, size_t end, size_t middle,
+            size_t size,
+            compare_f compare,
+            char *temp);
+
+void _mergesort(char *base,
+                size_t start, size_t end,
+                size_t size,
+                compare_f compare,
+                char *temp);
+
 #endif /* _sort_tools_h */
@@ -0,0 +1,388 @@
+/*************************************************************************************************
+ *
+ * sortnet.c
+ * Bitonic sorting networks for small arrays of int32_t, float and int64_t, and quicksorts on
+ * those types that use them as the base case. Sources: Batcher (1968), Wikipedia, and
+ * Bramas, "A Novel Hybrid Quicksort Algorithm Vectorized using AVX-512 on Intel Skylake" (2017).
+ *
+ * The callback sorts don't know what they're sorting, so the networks are only used by the
+ * typed entry points here. A block of up to SORTNET_MAX elements is padded with the largest
+ * value of its type to the next power of two, loaded into vector registers of W lanes (element
+ * i lives in lane i % W of register i / W) and run through the bitonic network: stages whose
+ * pairs are W or more elements apart compare whole registers, the others compare each register
+ * with a permutation of itself and blend the minima and maxima back together. With AVX2 the
+ * registers hold 8 int32s or floats or 4 int64s; with only SSE2 they hold 4 int32s or floats;
+ * without either (or for int64 without AVX2) the same network runs on scalars.
+ *
+ ************************************************************************************************/
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "sort.h"
+
+/* Generate a sorting network for up to SORTNET_MAX elements of type T, held in registers of type
+ * V with W lanes. MIN(a, b) and MAX(a, b) compare two registers lane by lane; where the lanes are
+ * equal, MIN must take a and MAX b, so that every compare-exchange yields a permutation of its
+ * inputs even when equal values differ in their bits, like -0.0 and 0.0. (Within a register, lane
+ * i of v meets lane i of its permutation p, so the maxima come from MAX(p, v).) PERM(v, x) moves
+ * lane i ^ x to lane i, and BLEND(lo, hi, b) takes the lanes whose index has the bit b set from
+ * hi and the others from lo. Longer arrays are handed to FALLBACK, which must not come back here with
+ * more than SORTNET_MAX elements. */
+#define _define_network(name, T, V, W, LOAD, STORE, MIN, MAX, PERM, BLEND, T_MAX, FALLBACK) \
+void name(T *A, size_t n) \
+{ \
+    T buffer[SORTNET_MAX]; \
+    V v[SORTNET_MAX / W]; \
+    \
+    if (n < 2) return; \
+    if (n > SORTNET_MAX) { \
+        FALLBACK(A, n); \
+        return; \
+    } \
+    \
+    size_t N = W; \
+    while (N < n) N <<= 1; \
+    size_t R = N / W; \
+    \
+    memcpy(buffer, A, n * sizeof(T)); \
+    for (size_t i = n; i < N; ++i) buffer[i] = T_MAX; \
+    for (size_t r = 0; r < R; ++r) v[r] = LOAD(buffer + r * W); \
+    \
+    for (size_t k = 2; k <= N; k <<= 1) { \
+        /* Sort the halves of each block of k elements into opposite directions: compare \
+         * element i with element i ^ (k - 1), which mirrors it within the block. */ \
+        if (k <= W) { \
+            for (size_t r = 0; r < R; ++r) { \
+                V p = PERM(v[r], k - 1); \
+                v[r] = BLEND(MIN(v[r], p), MAX(p, v[r]), k / 2); \
+            } \
+        } else { \
+            size_t kr = k / W; \
+            for (size_t r = 0; r < R; ++r) { \
+                size_t s = r ^ (kr - 1); \
+                if (s < r) continue; \
+                V b = PERM(v[s], W - 1); \
+                V lo = MIN(v[r], b), hi = MAX(v[r], b); \
+                v[r] = lo; \
+                v[s] = PERM(hi, W - 1); \
+            } \
+        } \
+        /* Merge the resulting bitonic sequences: compare element i with element i ^ j. */ \
+        for (size_t j = k / 4; j > 0; j >>= 1) { \
+            if (j >= W) { \
+                size_t jr = j / W; \
+                for (size_t r = 0; r < R; ++r) { \
+                    if (r & jr) continue; \
+                    V lo = MIN(v[r], v[r | jr]), hi = MAX(v[r], v[r | jr]); \
+                    v[r] = lo; \
+                    v[r | jr] = hi; \
+                } \
+            } else { \
+                for (size_t r = 0; r < R; ++r) { \
+                    V p = PERM(v[r], j); \
+                    v[r] = BLEND(MIN(v[r], p), MAX(p, v[r]), j); \
+                } \
+            } \
+        } \
+    } \
+    \
+    for (size_t r = 0; r < R; ++r) STORE(buffer + r * W, v[r]); \
+    memcpy(A, buffer, n * sizeof(T)); \
+}
+
+/* Scalar operations, W = 1. */
+
+#define _scalar_load(p)             (*(p))
+#define _scalar_store(p, v)         (*(p) = (v))
+#define _scalar_min(a, b)           ((b) < (a) ? (b) : (a))
+#define _scalar_max(a, b)           ((b) < (a) ? (a) : (b))
+#define _scalar_perm(v, x)          (v)
+#define _scalar_blend(lo, hi, b)    (lo)
+
+/* void sortnet_i32  (int32_t *A, size_t n)
+ * void sortnet_float(float *A, size_t n)
+ * void sortnet_i64  (int64_t *A, size_t n)
+ * Sort the array A of n numbers in ascending order. A must not contain NaNs. Arrays of more than
+ * SORTNET_MAX elements are sorted with the quicksorts below. */
+
+#if defined(__AVX2__)
+
+static inline __m256i _iota_i32x8(void)
+{
+    return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+}
+
+/* Lanes whose index has the bit b set. */
+static inline __m256i _lanes_i32x8(size_t b)
+{
+    __m256i bit = _mm256_set1_epi32((int)b);
+    return _mm256_cmpeq_epi32(_mm256_and_si256(_iota_i32x8(), bit), bit);
+}
+
+static inline __m256i _perm_i32x8(__m256i v, size_t x)
+{
+    return _mm256_permutevar8x32_epi32(v, _mm256_xor_si256(_iota_i32x8(),
+                                                           _mm256_set1_epi32((int)x)));
+}
+
+static inline __m256i _blend_i32x8(__m256i lo, __m256i hi, size_t b)
+{
+    return _mm256_blendv_epi8(lo, hi, _lanes_i32x8(b));
+}
+
+static inline __m256 _perm_f32x8(__m256 v, size_t x)
+{
+    return _mm256_permutevar8x32_ps(v, _mm256_xor_si256(_iota_i32x8(),
+                                                        _mm256_set1_epi32((int)x)));
+}
+
+static inline __m256 _blend_f32x8(__m256 lo, __m256 hi, size_t b)
+{
+    return _mm256_blendv_ps(lo, hi, _mm256_castsi256_ps(_lanes_i32x8(b)));
+}
+
+/* _mm256_min_ps and _mm256_max_ps both return b where a == b, which would turn {-0.0, 0.0} into
+ * {0.0, 0.0}. Derive both from the same mask instead. */
+static inline __m256 _min_f32x8(__m256 a, __m256 b)
+{
+    return _mm256_blendv_ps(a, b, _mm256_cmp_ps(b, a, _CMP_LT_OQ));
+}
+
+static inline __m256 _max_f32x8(__m256 a, __m256 b)
+{
+    return _mm256_blendv_ps(b, a, _mm256_cmp_ps(b, a, _CMP_LT_OQ));
+}
+
+/* AVX2 has no 64-bit min and max, and no variable 64-bit permutation; 64-bit lane i ^ x is
+ * 32-bit lanes (2i + h) ^ 2x. */
+static inline __m256i _min_i64x4(__m256i a, __m256i b)
+{
+    return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+static inline __m256i _max_i64x4(__m256i a, __m256i b)
+{
+    return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+}
+
+static inline __m256i _perm_i64x4(__m256i v, size_t x)
+{
+    return _mm256_permutevar8x32_epi32(v, _mm256_xor_si256(_iota_i32x8(),
+                                                           _mm256_set1_epi32((int)(2 * x))));
+}
+
+static inline __m256i _blend_i64x4(__m256i lo, __m256i hi, size_t b)
+{
+    __m256i bit = _mm256_set1_epi64x((long long)b);
+    __m256i iota = _mm256_setr_epi64x(0, 1, 2, 3);
+    return _mm256_blendv_epi8(lo, hi, _mm256_cmpeq_epi64(_mm256_and_si256(iota, bit), bit));
+}
+
+#define _load_i32x8(p)      _mm256_loadu_si256((const __m256i*)(p))
+#define _store_i32x8(p, v)  _mm256_storeu_si256((__m256i*)(p), (v))
+
+_define_network(sortnet_i32, int32_t, __m256i, 8,
+                _load_i32x8, _store_i32x8, _mm256_min_epi32, _mm256_max_epi32,
+                _perm_i32x8, _blend_i32x8, INT32_MAX, quicksort_i32)
+
+_define_network(sortnet_float, float, __m256, 8,
+                _mm256_loadu_ps, _mm256_storeu_ps, _min_f32x8, _max_f32x8,
+                _perm_f32x8, _blend_f32x8, INFINITY, quicksort_float)
+
+_define_network(sortnet_i64, int64_t, __m256i, 4,
+                _load_i32x8, _store_i32x8, _min_i64x4, _max_i64x4,
+                _perm_i64x4, _blend_i64x4, INT64_MAX, quicksort_i64)
+
+#elif defined(__SSE2__)
+
+static inline __m128i _lanes_x4(size_t b)
+{
+    __m128i bit = _mm_set1_epi32((int)b);
+    return _mm_cmpeq_epi32(_mm_and_si128(_mm_setr_epi32(0, 1, 2, 3), bit), bit);
+}
+
+/* SSE2 has no 32-bit integer min and max, and shuffles take their pattern as an immediate. */
+static inline __m128i _select_i32x4(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128i _min_i32x4(__m128i a, __m128i b)
+{
+    return _select_i32x4(_mm_cmpgt_epi32(a, b), b, a);
+}
+
+static inline __m128i _max_i32x4(__m128i a, __m128i b)
+{
+    return _select_i32x4(_mm_cmpgt_epi32(a, b), a, b);
+}
+
+static inline __m128i _perm_i32x4(__m128i v, size_t x)
+{
+    switch (x) {
+    case 1:  return _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+    case 2:  return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+    default: return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+    }
+}
+
+static inline __m128i _blend_i32x4(__m128i lo, __m128i hi, size_t b)
+{
+    return _select_i32x4(_lanes_x4(b), hi, lo);
+}
+
+static inline __m128 _perm_f32x4(__m128 v, size_t x)
+{
+    switch (x) {
+    case 1:  return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    case 2:  return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2));
+    default: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3));
+    }
+}
+
+static inline __m128 _select_f32x4(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 _blend_f32x4(__m128 lo, __m128 hi, size_t b)
+{
+    return _select_f32x4(_mm_castsi128_ps(_lanes_x4(b)), hi, lo);
+}
+
+/* _mm_min_ps and _mm_max_ps both return b where a == b (see _min_f32x8). */
+static inline __m128 _min_f32x4(__m128 a, __m128 b)
+{
+    return _select_f32x4(_mm_cmplt_ps(b, a), b, a);
+}
+
+static inline __m128 _max_f32x4(__m128 a, __m128 b)
+{
+    return _select_f32x4(_mm_cmplt_ps(b, a), a, b);
+}
+
+#define _load_i32x4(p)      _mm_loadu_si128((const __m128i*)(p))
+#define _store_i32x4(p, v)  _mm_storeu_si128((__m128i*)(p), (v))
+
+_define_network(sortnet_i32, int32_t, __m128i, 4,
+                _load_i32x4, _store_i32x4, _min_i32x4, _max_i32x4,
+                _perm_i32x4, _blend_i32x4, INT32_MAX, quicksort_i32)
+
+_define_network(sortnet_float, float, __m128, 4,
+                _mm_loadu_ps, _mm_storeu_ps, _min_f32x4, _max_f32x4,
+                _perm_f32x4, _blend_f32x4, INFINITY, quicksort_float)
+
+_define_network(sortnet_i64, int64_t, int64_t, 1,
+                _scalar_load, _scalar_store, _scalar_min, _scalar_max,
+                _scalar_perm, _scalar_blend, INT64_MAX, quicksort_i64)
+
+#else
+
+_define_network(sortnet_i32, int32_t, int32_t, 1,
+                _scalar_load, _scalar_store, _scalar_min, _scalar_max,
+                _scalar_perm, _scalar_blend, INT32_MAX, quicksort_i32)
+
+_define_network(sortnet_float, float, float, 1,
+                _scalar_load, _scalar_store, _scalar_min, _scalar_max,
+                _scalar_perm, _scalar_blend, INFINITY, quicksort_float)
+
+_define_network(sortnet_i64, int64_t, int64_t, 1,
+                _scalar_load, _scalar_store, _scalar_min, _scalar_max,
+                _scalar_perm, _scalar_blend, INT64_MAX, quicksort_i64)
+
+#endif
+
+/* Generate an introsort on arrays of type T that sorts the ranges of up to SORTNET_MAX elements
+ * left over by partitioning with the network. */
+#define _define_quicksort(name, T, network) \
+static void name##_sift_down(T *A, size_t i, size_t n) \
+{ \
+    T x = A[i]; \
+    size_t c; \
+    while ((c = 2 * i + 1) < n) { \
+        if (c + 1 < n && A[c] < A[c + 1]) ++c; \
+        if (!(x < A[c])) break; \
+        A[i] = A[c]; \
+        i = c; \
+    } \
+    A[i] = x; \
+} \
+\
+static void name##_heapsort(T *A, size_t n) \
+{ \
+    for (size_t i = n / 2; i-- > 0; ) name##_sift_down(A, i, n); \
+    for (size_t i = n; i-- > 1; ) { \
+        T t = A[0]; A[0] = A[i]; A[i] = t; \
+        name##_sift_down(A, 0, i); \
+    } \
+} \
+\
+static void name##_introsort(T *A, size_t n, unsigned depth) \
+{ \
+    while (n > SORTNET_MAX) { \
+        if (depth-- == 0) { \
+            name##_heapsort(A, n); \
+            return; \
+        } \
+        \
+        /* Median of three as the pivot, then Hoare partitioning. */ \
+        T a = A[0], b = A[n / 2], c = A[n - 1]; \
+        T pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b)); \
+        size_t i = 0, j = n - 1; \
+        for (;;) { \
+            while (A[i] < pivot) ++i; \
+            while (pivot < A[j]) --j; \
+            if (i >= j) break; \
+            T t = A[i]; A[i] = A[j]; A[j] = t; \
+            ++i; \
+            --j; \
+        } \
+        size_t left = j + 1; \
+        \
+        /* Recurse into the smaller side only. */ \
+        if (left < n - left) { \
+            name##_introsort(A, left, depth); \
+            A += left; \
+            n -= left; \
+        } else { \
+            name##_introsort(A + left, n - left, depth); \
+            n = left; \
+        } \
+    } \
+    network(A, n); \
+} \
+\
+void name(T *A, size_t n) \
+{ \
+    unsigned depth = 0; \
+    for (size_t m = n; m > 1; m >>= 1) depth += 2; \
+    name##_introsort(A, n, depth); \
+}
+
+_define_quicksort(quicksort_i32, int32_t, sortnet_i32)
+_define_quicksort(_quicksort_float, float, sortnet_float)
+_define_quicksort(quicksort_i64, int64_t, sortnet_i64)
+
+/* void quicksort_i32  (int32_t *A, size_t n)
+ * void quicksort_float(float *A, size_t n)
+ * void quicksort_i64  (int64_t *A, size_t n)
+ * Sort the array A of n numbers in ascending order. quicksort_float moves NaNs to the end, since
+ * they don't compare to anything and the vector min and max would drop them. */
+void quicksort_float(float *A, size_t n)
+{
+    size_t m = n;
+    for (size_t i = 0; i < m; ) {
+        if (isnan(A[i])) {
+            float t = A[i]; A[i] = A[--m]; A[m] = t;
+        } else {
+            ++i;
+        }
+    }
+    _quicksort_float(A, m);
+}
@@ -21,6 +21,7 @@ typedef flist stack;
 #define stack_empty(S)          ((S)->count == 0)
 
 #define stack_initialize(S, dt) flist_initialize(S, dt)
+#define stack_initialize_with(S, dt, A) flist_initialize_with(S, dt, A)
 #define stack_new(dt)           flist_new(dt)
 #define stack_delete(S)         flist_delete(S)
 #define stack_destroy(S)        flist_destroy(S)
@@ -346,11 +346,12 @@ error:
 }
 
 /* uint32_t str_hash(const void *s)
- * Generate a hash of s (using the Jenkins hashing algorithm). */
+ * Generate a hash of s (using wyhash with the global hash seed). */
 uint32_t str_hash(const void *s)
 {
     char *data = str_data((str*)s);
-    return jenkins_hash(data, ((str *)s)->length);
+    uint64_t h = wyhash(data, ((str *)s)->length, hash_seed);
+    return hash_fold(h);
 }
 
 /* void str_print(FILE *stream, const void *s)
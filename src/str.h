@@ -74,4 +74,7 @@ int         str_compare         (const void *a, const void *b);
 uint32_t    str_hash            (const void *s);
 void        str_print           (FILE *stream, const void *s);
 
+int         str_sort            (str *A, size_t n);
+int         cstr_sort           (char **A, size_t n);
+
 #endif // _str_h
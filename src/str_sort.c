@@ -0,0 +1,169 @@
+/*************************************************************************************************
+ *
+ * str_sort.c
+ * Multikey quicksort (three-way radix quicksort) for arrays of str and of C strings. Sources:
+ * Bentley & Sedgewick, "Fast Algorithms for Sorting and Searching Strings" (1997), Sedgewick.
+ *
+ * Comparison sorts compare strings from the first character every time, which is expensive
+ * when they share long prefixes (paths, URLs). Multikey quicksort partitions by a single
+ * character at the current depth into smaller, equal and greater parts, and only the equal part
+ * moves on to the next character, so no character of a common prefix is examined more than
+ * once per partitioning step. The strings are sorted through an array of keys that caches their
+ * data pointers and lengths; the elements themselves are moved once at the end.
+ *
+ ************************************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "str.h"
+
+/* Ranges up to this size are sorted with insertion sort on the remaining suffixes. */
+#define MKQ_INSERTION_CUTOFF 12
+
+struct skey {
+    const unsigned char *   data;
+    size_t                  length;
+    size_t                  index;
+};
+
+/* The character at position d, or 0 past the end. Strings end at their first null character
+ * like in str_compare. */
+static inline int _char_at(const struct skey *k, size_t d)
+{
+    return d < k->length ? k->data[d] : 0;
+}
+
+static inline void _swap_keys(struct skey *a, struct skey *b)
+{
+    struct skey t = *a;
+    *a = *b;
+    *b = t;
+}
+
+/* Compare two strings that are known to be equal in their first d characters. */
+static int _compare_from(const struct skey *a, const struct skey *b, size_t d)
+{
+    for ( ;; ++d) {
+        int x = _char_at(a, d), y = _char_at(b, d);
+        if (x != y) return x - y;
+        if (x == 0) return 0;
+    }
+}
+
+static void _insertionsort_from(struct skey *K, size_t n, size_t d)
+{
+    for (size_t i = 1; i < n; ++i) {
+        struct skey t = K[i];
+        size_t j = i;
+        while (j > 0 && _compare_from(K + j - 1, &t, d) > 0) {
+            K[j] = K[j - 1];
+            --j;
+        }
+        K[j] = t;
+    }
+}
+
+/* Sort the n keys, which are all equal in their first d characters. */
+static void _mkqsort(struct skey *K, size_t n, size_t d)
+{
+    while (n > MKQ_INSERTION_CUTOFF) {
+        /* The median of three characters as the pivot. */
+        int a = _char_at(K, d), b = _char_at(K + n / 2, d), c = _char_at(K + n - 1, d);
+        int v = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+
+        /* Three-way partition: [0, lt[ < v, [lt, gt[ == v, [gt, n[ > v. */
+        size_t lt = 0, i = 0, gt = n;
+        while (i < gt) {
+            int x = _char_at(K + i, d);
+            if (x < v) {
+                _swap_keys(K + lt++, K + i++);
+            } else if (x > v) {
+                _swap_keys(K + i, K + --gt);
+            } else {
+                ++i;
+            }
+        }
+
+        _mkqsort(K, lt, d);
+        _mkqsort(K + gt, n - gt, d);
+
+        /* The strings in the middle end here if the pivot is the end of the string, otherwise
+         * they continue with the next character. */
+        if (v == 0) return;
+        K += lt;
+        n = gt - lt;
+        ++d;
+    }
+    _insertionsort_from(K, n, d);
+}
+
+/* int str_sort(str *A, size_t n)
+ * Sort the array A of n strings in the order of str_compare. Also works on the data of a vector
+ * of str_type elements. Return 0 on success or -1 on error. */
+int str_sort(str *A, size_t n)
+{
+    struct skey *K = NULL;
+    str *sorted = NULL;
+    check_ptr(A);
+    if (n < 2) return 0;
+
+    K = malloc(n * sizeof(*K));
+    check_alloc(K);
+    sorted = malloc(n * sizeof(*sorted));
+    check_alloc(sorted);
+
+    for (size_t i = 0; i < n; ++i) {
+        K[i].data = (const unsigned char*)str_data(A + i);
+        K[i].length = A[i].length;
+        K[i].index = i;
+    }
+
+    _mkqsort(K, n, 0);
+
+    /* Strings are trivially relocatable: short ones move along with their struct, long ones
+     * only own a pointer to their data. */
+    for (size_t i = 0; i < n; ++i) {
+        memcpy(sorted + i, A + K[i].index, sizeof(*sorted));
+    }
+    memcpy(A, sorted, n * sizeof(*A));
+
+    free(sorted);
+    free(K);
+    return 0;
+error:
+    if (K) free(K);
+    return -1;
+}
+
+/* int cstr_sort(char **A, size_t n)
+ * Sort the array A of n pointers to null-terminated strings in the order of strcmp. Return 0 on
+ * success or -1 on error. */
+int cstr_sort(char **A, size_t n)
+{
+    struct skey *K = NULL;
+    check_ptr(A);
+    if (n < 2) return 0;
+
+    K = malloc(n * sizeof(*K));
+    check_alloc(K);
+
+    for (size_t i = 0; i < n; ++i) {
+        K[i].data = (const unsigned char*)A[i];
+        K[i].length = SIZE_MAX;
+        K[i].index = i;
+    }
+
+    _mkqsort(K, n, 0);
+
+    for (size_t i = 0; i < n; ++i) {
+        A[i] = (char*)K[i].data;
+    }
+
+    free(K);
+    return 0;
+error:
+    return -1;
+}
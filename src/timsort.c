@@ -0,0 +1,488 @@
+/*************************************************************************************************
+ *
+ * timsort.c
+ * Implementation of an adaptive, stable natural merge sort after Tim Peters' timsort. Sources:
+ * Objects/listsort.txt and Objects/listobject.c in CPython, and de Gouw et al., "OpenJDK's
+ * java.utils.Collection.sort() is broken" (2015) for the corrected run stack invariant.
+ *
+ * The array is scanned for runs that are already ascending (or strictly descending, which are
+ * reversed in place). Runs shorter than a minimum length are extended with binary insertion
+ * sort. The runs are pushed on a stack and merged in an order that keeps the merges balanced.
+ * When one run keeps winning during a merge, the merge switches to galloping: it searches for the
+ * end of the winning streak with exponential search and moves the whole streak at once. Only the
+ * shorter of the two runs is copied to temporary storage, so at most n/2 elements are needed.
+ * If that much memory isn't available, runs are merged in place by rotations instead (after
+ * SGI STL's __merge_without_buffer), which is still stable but takes O(n log^2 n) time.
+ * On sorted input this does n - 1 comparisons, on nearly sorted input close to linear work.
+ *
+ ************************************************************************************************/
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "sort_tools.h"
+
+#define MIN_MERGE       64
+#define MIN_GALLOP      7
+#define MAX_RUNS        85
+
+struct run {
+    char *      base;
+    size_t      len;
+};
+
+struct timsort {
+    size_t      size;
+    compare_f   compare;
+    char *      temp;           /* (n / 2 + 1) elements; also the pivot slot for insertion sort */
+    int         in_place;       /* temp holds a single element, merge without it */
+    size_t      min_gallop;
+    size_t      n_runs;
+    struct run  runs[MAX_RUNS];
+};
+
+#define lt(S, a, b)         ((S)->compare((a), (b)) < 0)
+#define el(p, i)            ((p) + (ptrdiff_t)(i) * (ptrdiff_t)size)
+
+/* Return the length of the run beginning at lo, reversing it first if it is descending. */
+static size_t _count_run(struct timsort *S, char *lo, size_t n)
+{
+    size_t size = S->size;
+    size_t i = 1;
+    if (n == 1) return 1;
+
+    if (lt(S, el(lo, 1), lo)) {
+        /* Strictly descending, so reversing keeps the sort stable. */
+        while (++i < n && lt(S, el(lo, i), el(lo, i - 1)));
+        for (char *l = lo, *r = el(lo, i - 1); l < r; l += size, r -= size) {
+            _swap(l, r, size, S->temp);
+        }
+    } else {
+        while (++i < n && !lt(S, el(lo, i), el(lo, i - 1)));
+    }
+
+    return i;
+}
+
+/* Sort lo[0..n[ given that lo[0..start[ is already sorted. */
+static void _binary_insertionsort(struct timsort *S, char *lo, size_t n, size_t start)
+{
+    size_t size = S->size;
+    char *pivot = S->temp;
+
+    for (size_t i = start; i < n; ++i) {
+        _copy(pivot, el(lo, i), size);
+
+        /* Insert after all elements <= pivot to stay stable. */
+        size_t l = 0, r = i;
+        while (l < r) {
+            size_t m = l + (r - l) / 2;
+            if (lt(S, pivot, el(lo, m))) r = m;
+            else l = m + 1;
+        }
+
+        memmove(el(lo, l + 1), el(lo, l), (i - l) * size);
+        _copy(el(lo, l), pivot, size);
+    }
+}
+
+/* Return the index k in [0, n] at which key would have to be inserted into the sorted array a
+ * before all elements equal to it, i.e. a[k - 1] < key <= a[k]. The search starts at hint and
+ * widens exponentially, so it is fast if the result is close to hint. */
+static size_t _gallop_left(struct timsort *S, const char *key, char *a, size_t n, size_t hint)
+{
+    size_t size = S->size;
+    ptrdiff_t ofs = 1, lastofs = 0, maxofs, k;
+
+    if (lt(S, el(a, hint), key)) {
+        /* a[hint] < key: gallop right until a[hint + lastofs] < key <= a[hint + ofs]. */
+        maxofs = (ptrdiff_t)(n - hint);
+        while (ofs < maxofs && lt(S, el(a, hint + ofs), key)) {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > maxofs) ofs = maxofs;
+        lastofs += (ptrdiff_t)hint;
+        ofs += (ptrdiff_t)hint;
+    } else {
+        /* key <= a[hint]: gallop left until a[hint - ofs] < key <= a[hint - lastofs]. */
+        maxofs = (ptrdiff_t)hint + 1;
+        while (ofs < maxofs && !lt(S, el(a, (ptrdiff_t)hint - ofs), key)) {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > maxofs) ofs = maxofs;
+        k = lastofs;
+        lastofs = (ptrdiff_t)hint - ofs;
+        ofs = (ptrdiff_t)hint - k;
+    }
+
+    /* Now a[lastofs] < key <= a[ofs]; binary search in between. */
+    ++lastofs;
+    while (lastofs < ofs) {
+        ptrdiff_t m = lastofs + ((ofs - lastofs) >> 1);
+        if (lt(S, el(a, m), key)) lastofs = m + 1;
+        else ofs = m;
+    }
+    return (size_t)ofs;
+}
+
+/* Like _gallop_left, but return the index after all elements equal to key, i.e. a[k - 1] <= key
+ * < a[k]. */
+static size_t _gallop_right(struct timsort *S, const char *key, char *a, size_t n, size_t hint)
+{
+    size_t size = S->size;
+    ptrdiff_t ofs = 1, lastofs = 0, maxofs, k;
+
+    if (lt(S, key, el(a, hint))) {
+        /* key < a[hint]: gallop left until a[hint - ofs] <= key < a[hint - lastofs]. */
+        maxofs = (ptrdiff_t)hint + 1;
+        while (ofs < maxofs && lt(S, key, el(a, (ptrdiff_t)hint - ofs))) {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > maxofs) ofs = maxofs;
+        k = lastofs;
+        lastofs = (ptrdiff_t)hint - ofs;
+        ofs = (ptrdiff_t)hint - k;
+    } else {
+        /* a[hint] <= key: gallop right until a[hint + lastofs] <= key < a[hint + ofs]. */
+        maxofs = (ptrdiff_t)(n - hint);
+        while (ofs < maxofs && !lt(S, key, el(a, hint + ofs))) {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > maxofs) ofs = maxofs;
+        lastofs += (ptrdiff_t)hint;
+        ofs += (ptrdiff_t)hint;
+    }
+
+    ++lastofs;
+    while (lastofs < ofs) {
+        ptrdiff_t m = lastofs + ((ofs - lastofs) >> 1);
+        if (lt(S, key, el(a, m))) ofs = m;
+        else lastofs = m + 1;
+    }
+    return (size_t)ofs;
+}
+
+/* Merge the adjacent runs a[0..na[ and b[0..nb[ in place, where na <= nb, a[0] is known to belong
+ * after b[0] and a[na - 1] is known to be the last element overall. */
+static void _merge_lo(struct timsort *S, char *a, size_t na, char *b, size_t nb)
+{
+    size_t size = S->size;
+    size_t min_gallop = S->min_gallop;
+    size_t acount, bcount, k;
+
+    memcpy(S->temp, a, na * size);
+    char *dest = a, *pa = S->temp, *pb = b;
+
+    _copy(dest, pb, size);
+    dest += size; pb += size; --nb;
+    if (nb == 0) goto succeed;
+    if (na == 1) goto copy_b;
+
+    for ( ;; ) {
+        acount = bcount = 0;
+
+        /* One element at a time until one run wins often enough in a row. */
+        for ( ;; ) {
+            if (lt(S, pb, pa)) {
+                _copy(dest, pb, size);
+                dest += size; pb += size; --nb;
+                ++bcount; acount = 0;
+                if (nb == 0) goto succeed;
+                if (bcount >= min_gallop) break;
+            } else {
+                _copy(dest, pa, size);
+                dest += size; pa += size; --na;
+                ++acount; bcount = 0;
+                if (na == 1) goto copy_b;
+                if (acount >= min_gallop) break;
+            }
+        }
+
+        /* Gallop until neither run wins by a big enough margin any more. */
+        ++min_gallop;
+        do {
+            min_gallop -= min_gallop > 1;
+            S->min_gallop = min_gallop;
+
+            k = acount = _gallop_right(S, pb, pa, na, 0);
+            if (k) {
+                memcpy(dest, pa, k * size);
+                dest = el(dest, k); pa = el(pa, k); na -= k;
+                if (na == 1) goto copy_b;
+                if (na == 0) goto succeed;  /* only possible with an inconsistent comparison */
+            }
+            _copy(dest, pb, size);
+            dest += size; pb += size; --nb;
+            if (nb == 0) goto succeed;
+
+            k = bcount = _gallop_left(S, pa, pb, nb, 0);
+            if (k) {
+                memmove(dest, pb, k * size);
+                dest = el(dest, k); pb = el(pb, k); nb -= k;
+                if (nb == 0) goto succeed;
+            }
+            _copy(dest, pa, size);
+            dest += size; pa += size; --na;
+            if (na == 1) goto copy_b;
+        } while (acount >= MIN_GALLOP || bcount >= MIN_GALLOP);
+        ++min_gallop;
+        S->min_gallop = min_gallop;
+    }
+
+succeed:
+    if (na) memcpy(dest, pa, na * size);
+    return;
+copy_b:
+    /* The last element of a belongs at the very end. */
+    memmove(dest, pb, nb * size);
+    _copy(el(dest, nb), pa, size);
+}
+
+/* Merge the adjacent runs a[0..na[ and b[0..nb[ in place, where nb <= na, working from the end
+ * backwards. */
+static void _merge_hi(struct timsort *S, char *a, size_t na, char *b, size_t nb)
+{
+    size_t size = S->size;
+    size_t min_gallop = S->min_gallop;
+    size_t acount, bcount, k;
+    char *base_b = S->temp;
+
+    memcpy(base_b, b, nb * size);
+    char *dest = el(b, nb - 1), *pa = el(a, na - 1), *pb = el(base_b, nb - 1);
+
+    _copy(dest, pa, size);
+    dest -= size; pa -= size; --na;
+    if (na == 0) goto succeed;
+    if (nb == 1) goto copy_a;
+
+    for ( ;; ) {
+        acount = bcount = 0;
+
+        for ( ;; ) {
+            if (lt(S, pb, pa)) {
+                _copy(dest, pa, size);
+                dest -= size; pa -= size; --na;
+                ++acount; bcount = 0;
+                if (na == 0) goto succeed;
+                if (acount >= min_gallop) break;
+            } else {
+                _copy(dest, pb, size);
+                dest -= size; pb -= size; --nb;
+                ++bcount; acount = 0;
+                if (nb == 1) goto copy_a;
+                if (bcount >= min_gallop) break;
+            }
+        }
+
+        ++min_gallop;
+        do {
+            min_gallop -= min_gallop > 1;
+            S->min_gallop = min_gallop;
+
+            k = acount = na - _gallop_right(S, pb, a, na, na - 1);
+            if (k) {
+                dest = el(dest, -(ptrdiff_t)k); pa = el(pa, -(ptrdiff_t)k);
+                memmove(dest + size, pa + size, k * size);
+                na -= k;
+                if (na == 0) goto succeed;
+            }
+            _copy(dest, pb, size);
+            dest -= size; pb -= size; --nb;
+            if (nb == 1) goto copy_a;
+
+            k = bcount = nb - _gallop_left(S, pa, base_b, nb, nb - 1);
+            if (k) {
+                dest = el(dest, -(ptrdiff_t)k); pb = el(pb, -(ptrdiff_t)k);
+                memcpy(dest + size, pb + size, k * size);
+                nb -= k;
+                if (nb == 1) goto copy_a;
+                if (nb == 0) goto succeed;  /* only possible with an inconsistent comparison */
+            }
+            _copy(dest, pa, size);
+            dest -= size; pa -= size; --na;
+            if (na == 0) goto succeed;
+        } while (acount >= MIN_GALLOP || bcount >= MIN_GALLOP);
+        ++min_gallop;
+        S->min_gallop = min_gallop;
+    }
+
+succeed:
+    if (nb) memcpy(el(dest, -(ptrdiff_t)(nb - 1)), base_b, nb * size);
+    return;
+copy_a:
+    /* The first element of b belongs at the very beginning. */
+    dest = el(dest, -(ptrdiff_t)na);
+    pa = el(pa, -(ptrdiff_t)na);
+    memmove(dest + size, pa + size, na * size);
+    _copy(dest, pb, size);
+}
+
+/* Reverse lo[0..n[. */
+static void _reverse(struct timsort *S, char *lo, size_t n)
+{
+    size_t size = S->size;
+    if (n < 2) return;
+    for (char *l = lo, *r = el(lo, n - 1); l < r; l += size, r -= size) {
+        _swap(l, r, size, S->temp);
+    }
+}
+
+/* Merge the adjacent sorted runs a[0..na[ and b[0..nb[ without a buffer: split the longer run in
+ * half, find where its middle element goes in the other run, rotate the two middle parts past
+ * each other and merge both halves recursively. */
+static void _merge_in_place(struct timsort *S, char *a, size_t na, char *b, size_t nb)
+{
+    size_t size = S->size;
+    size_t ka, kb;
+
+    if (na == 0 || nb == 0) return;
+    if (na + nb == 2) {
+        if (lt(S, b, a)) _swap(a, b, size, S->temp);
+        return;
+    }
+
+    if (na > nb) {
+        ka = na / 2;
+        kb = _gallop_left(S, el(a, ka), b, nb, 0);
+    } else {
+        kb = nb / 2;
+        ka = _gallop_right(S, el(b, kb), a, na, 0);
+    }
+
+    /* Rotate a[ka..na[ b[0..kb[ into b[0..kb[ a[ka..na[. */
+    _reverse(S, el(a, ka), na - ka);
+    _reverse(S, b, kb);
+    _reverse(S, el(a, ka), na - ka + kb);
+
+    char *mid = el(a, ka + kb);
+    _merge_in_place(S, a, ka, el(a, ka), kb);
+    _merge_in_place(S, mid, na - ka, el(mid, na - ka), nb - kb);
+}
+
+/* Merge the runs i and i + 1 on the stack. */
+static void _merge_at(struct timsort *S, size_t i)
+{
+    size_t size = S->size;
+    char *a = S->runs[i].base;
+    size_t na = S->runs[i].len;
+    char *b = S->runs[i + 1].base;
+    size_t nb = S->runs[i + 1].len;
+
+    S->runs[i].len = na + nb;
+    if (i == S->n_runs - 3) S->runs[i + 1] = S->runs[i + 2];
+    --S->n_runs;
+
+    /* Elements at the start of a that are <= b[0] and at the end of b that are >= a[na - 1] are
+     * already in place. */
+    size_t k = _gallop_right(S, b, a, na, 0);
+    a = el(a, k);
+    na -= k;
+    if (na == 0) return;
+
+    nb = _gallop_left(S, el(a, na - 1), b, nb, nb - 1);
+    if (nb == 0) return;
+
+    if (S->in_place) _merge_in_place(S, a, na, b, nb);
+    else if (na <= nb) _merge_lo(S, a, na, b, nb);
+    else _merge_hi(S, a, na, b, nb);
+}
+
+/* Merge runs on the stack until the lengths satisfy len[i - 2] > len[i - 1] + len[i] and
+ * len[i - 1] > len[i] for all i, which bounds the stack height logarithmically. */
+static void _merge_collapse(struct timsort *S)
+{
+    struct run *r = S->runs;
+    while (S->n_runs > 1) {
+        size_t n = S->n_runs - 2;
+        if ((n > 0 && r[n - 1].len <= r[n].len + r[n + 1].len) ||
+            (n > 1 && r[n - 2].len <= r[n - 1].len + r[n].len)) {
+            if (r[n - 1].len < r[n + 1].len) --n;
+            _merge_at(S, n);
+        } else if (r[n].len <= r[n + 1].len) {
+            _merge_at(S, n);
+        } else {
+            break;
+        }
+    }
+}
+
+static void _merge_force_collapse(struct timsort *S)
+{
+    struct run *r = S->runs;
+    while (S->n_runs > 1) {
+        size_t n = S->n_runs - 2;
+        if (n > 0 && r[n - 1].len < r[n + 1].len) --n;
+        _merge_at(S, n);
+    }
+}
+
+/* Return the minimum run length for an array of n elements: a value between MIN_MERGE / 2 and
+ * MIN_MERGE such that n / minrun is a power of two or slightly less. */
+static size_t _min_run(size_t n)
+{
+    size_t r = 0;
+    while (n >= MIN_MERGE) {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+void timsort(void *base, size_t nmemb, size_t size, compare_f compare)
+{
+    struct timsort state, *S = &state;
+    char element[SORT_INDIRECT_SIZE];
+
+    if (nmemb < 2) return;
+    /* Sort directly if the pointer array for the indirect sort can't be allocated. */
+    if (size > SORT_INDIRECT_SIZE
+            && _sort_indirect(base, nmemb, size, compare, timsort) == 0) {
+        return;
+    }
+
+    S->size = size;
+    S->compare = compare;
+    S->min_gallop = MIN_GALLOP;
+    S->n_runs = 0;
+    S->temp = malloc((nmemb / 2 + 1) * size);
+    S->in_place = S->temp == NULL;
+    if (S->in_place) {
+        if (size > SORT_INDIRECT_SIZE) {
+            log_error("failed to allocate merge buffer, the array is left unsorted");
+            return;
+        }
+        log_warn("failed to allocate merge buffer, merging in place");
+        S->temp = element;
+    }
+
+    char *lo = base;
+    size_t remaining = nmemb;
+    size_t min_run = _min_run(nmemb);
+
+    do {
+        size_t n = _count_run(S, lo, remaining);
+        if (n < min_run) {
+            size_t force = remaining < min_run ? remaining : min_run;
+            _binary_insertionsort(S, lo, force, n);
+            n = force;
+        }
+
+        S->runs[S->n_runs].base = lo;
+        S->runs[S->n_runs].len = n;
+        ++S->n_runs;
+        _merge_collapse(S);
+
+        lo = el(lo, n);
+        remaining -= n;
+    } while (remaining);
+
+    _merge_force_collapse(S);
+
+    if (!S->in_place) free(S->temp);
+}
@@ -24,7 +24,7 @@ error:
 
 void t_copy(const t_intf *T, void *dest, const void *src)
 {
-    if (T->copy) {
+    if (T->copy && !(T->traits & T_TRIVIALLY_COPYABLE)) {
         T->copy(dest, src);
     } else {
         memmove(dest, src, T->size);
@@ -41,10 +41,41 @@ void t_move(const t_intf *T, void *dest, void *src)
     }
 }
 
+/* void t_relocate(const t_intf *T, void *dest, void *src, size_t n)
+ * Move n contiguous objects from src to dest. The ranges may overlap. For trivially relocatable
+ * types this is a single memmove, and the source objects that aren't overwritten are left as
+ * they are; they must not be destroyed afterwards. */
+void t_relocate(const t_intf *T, void *dest, void *src, size_t n)
+{
+    if (n == 0 || dest == src) return;
+
+    if (t_trivially_relocatable(T)) {
+        memmove(dest, src, n * T->size);
+    } else if ((char*)dest < (char*)src) {
+        for (size_t i = 0; i < n; ++i) {
+            t_move(T, (char*)dest + i * T->size, (char*)src + i * T->size);
+        }
+    } else {
+        for (size_t i = n; i-- > 0; ) {
+            t_move(T, (char*)dest + i * T->size, (char*)src + i * T->size);
+        }
+    }
+}
+
 int t_swap(const t_intf *T, void *a, void *b)
 {
     if (T->swap) {
         T->swap(a, b);
+    } else if (t_trivially_relocatable(T)) {
+        /* Swap the bytes through a small buffer on the stack. */
+        char temp[64];
+        char *p = a, *q = b;
+        for (size_t n = T->size, k; n > 0; n -= k, p += k, q += k) {
+            k = n < sizeof(temp) ? n : sizeof(temp);
+            memcpy(temp, p, k);
+            memcpy(p, q, k);
+            memcpy(q, temp, k);
+        }
     } else {
         void *temp = malloc(T->size);
         check_alloc(temp);
@@ -60,7 +91,17 @@ error:
 
 void t_destroy(const t_intf *T, void *obj)
 {
-    if (T->destroy) T->destroy(obj);
+    if (!t_trivially_destructible(T)) T->destroy(obj);
+}
+
+/* void t_destroy_n(const t_intf *T, void *base, size_t n)
+ * Destroy n contiguous objects starting at base. Does nothing for trivially destructible types. */
+void t_destroy_n(const t_intf *T, void *base, size_t n)
+{
+    if (t_trivially_destructible(T)) return;
+    for (size_t i = 0; i < n; ++i) {
+        T->destroy((char*)base + i * T->size);
+    }
 }
 
 int t_compare(const t_intf *T, const void *a, const void *b)
@@ -73,7 +114,8 @@ uint32_t t_hash(const t_intf *T, const void *obj)
     if (T->hash) {
         return T->hash(obj);
     } else {
-        return jenkins_hash(obj, T->size);
+        uint64_t h = wyhash(obj, T->size, hash_seed);
+        return hash_fold(h);
     }
 }
 
@@ -86,6 +128,7 @@ void t_print(const t_intf *T, FILE *stream, const void *obj)
 
 t_intf str_type = {
     .size = sizeof(str),
+    .traits = T_TRIVIALLY_RELOCATABLE | T_ZERO_INITIALIZABLE,
     .copy = str_copy_to,
     .destroy = str_destroy,
     .compare = str_compare,
@@ -103,7 +146,8 @@ int int_compare(const void *a, const void *b)
 
 uint32_t int_hash(const void *i)
 {
-    return jenkins_hash(i, sizeof(int));
+    uint64_t h = wyhash_u32((uint32_t)*(int*)i, hash_seed);
+    return hash_fold(h);
 }
 
 void int_print(FILE *stream, const void *i)
@@ -113,6 +157,8 @@ void int_print(FILE *stream, const void *i)
 
 t_intf int_type = {
     .size = sizeof(int),
+    .traits = T_TRIVIALLY_COPYABLE | T_TRIVIALLY_RELOCATABLE | T_TRIVIALLY_DESTRUCTIBLE |
+              T_ZERO_INITIALIZABLE,
     .copy = NULL,
     .destroy = NULL,
     .compare = int_compare,
@@ -127,6 +173,8 @@ int pointer_compare(const void *a, const void *b)
 
 t_intf pointer_type = {
     .size = sizeof(void*),
+    .traits = T_TRIVIALLY_COPYABLE | T_TRIVIALLY_RELOCATABLE | T_TRIVIALLY_DESTRUCTIBLE |
+              T_ZERO_INITIALIZABLE,
     .copy = NULL,
     .destroy = NULL,
     .compare = pointer_compare,
@@ -11,6 +11,10 @@
  * the operations will only handle the top level data of the type, ignoring possible pointers to
  * sub-data.
  *
+ * A type interface can additionally declare traits that tell the containers which of these
+ * operations are plain byte copies. Containers use them to handle whole ranges of objects with a
+ * single memmove (or not at all) instead of calling back into the type interface per object.
+ *
  ************************************************************************************************/
 
 #ifndef _type_interface_h
@@ -31,8 +35,20 @@ typedef int         (*compare_f)    (const void *a, const void *b);
 typedef uint32_t    (*hash_f)       (const void *obj);
 typedef void        (*print_f)      (FILE *stream, const void *obj);
 
+/* Type traits. A type without a copy (move, destroy) callback is treated as trivially copyable
+ * (relocatable, destructible) in any case, so the flags are only needed for types that define a
+ * callback but don't depend on it for all operations (e.g. a string type that needs a deep copy,
+ * but can be moved around in memory freely). */
+enum t_traits {
+    T_TRIVIALLY_COPYABLE        = 1 << 0,   /* copy is a byte copy */
+    T_TRIVIALLY_RELOCATABLE     = 1 << 1,   /* moving to another address is a byte copy */
+    T_TRIVIALLY_DESTRUCTIBLE    = 1 << 2,   /* destroy does nothing */
+    T_ZERO_INITIALIZABLE        = 1 << 3    /* all bytes zero is a valid (empty) object */
+};
+
 typedef struct t_intf {
     size_t      size;
+    uint8_t     traits;
     copy_f      copy;
     move_f      move;
     swap_f      swap;
@@ -45,14 +61,21 @@ typedef struct t_intf {
 void *      t_allocate  (const t_intf *T, size_t n);
 void        t_copy      (const t_intf *T, void *dest, const void *src);
 void        t_move      (const t_intf *T, void *dest, void *src);
+void        t_relocate  (const t_intf *T, void *dest, void *src, size_t n);
 int         t_swap      (const t_intf *T, void *a, void *b);
 void        t_destroy   (const t_intf *T, void *obj);
+void        t_destroy_n (const t_intf *T, void *base, size_t n);
 int         t_compare   (const t_intf *T, const void *a, const void *b);
 uint32_t    t_hash      (const t_intf *T, const void *obj);
 void        t_print     (const t_intf *T, FILE *stream, const void *obj);
 
 #define t_size(T) (T)->size
 
+#define t_trivially_copyable(T)     (((T)->traits & T_TRIVIALLY_COPYABLE) || !(T)->copy)
+#define t_trivially_relocatable(T)  (((T)->traits & T_TRIVIALLY_RELOCATABLE) || !(T)->move)
+#define t_trivially_destructible(T) (((T)->traits & T_TRIVIALLY_DESTRUCTIBLE) || !(T)->destroy)
+#define t_zero_initializable(T)     ((T)->traits & T_ZERO_INITIALIZABLE)
+
 /* Predefined type interfaces */
 t_intf str_type;
 
@@ -0,0 +1,425 @@
+/*************************************************************************************************
+ *
+ * typed.h
+ *
+ * Code generation for type-specialized containers and sorts. The generic containers in the
+ * library handle their elements through the function pointers in a type interface, which the
+ * compiler can't see through. The macros in this header instead emit a set of static inline
+ * functions for one concrete element type, so that element sizes are compile-time constants and
+ * comparisons and hashes can be inlined:
+ *
+ *   DSA_DEFINE_VECTOR(name, T)                     a growable array of T
+ *   DSA_DEFINE_SORT(name, T, less)                 a quicksort on arrays of T
+ *   DSA_DEFINE_HASHMAP(name, K, V, hash, equal)    an open-addressing hashmap from K to V
+ *   DSA_DEFINE_BST_LOOKUP(name, K, compare)        typed lookups in a generic bst with keys of K
+ *
+ * less, hash, equal and compare can be functions or function-like macros taking values (not
+ * pointers): less(a, b) is nonzero if a < b, compare(a, b) is <0, 0 or >0, equal(a, b) is nonzero
+ * if a == b, and hash(k) returns an unsigned integer. DSA_LESS, DSA_COMPARE, DSA_EQUAL and
+ * dsa_hash_int are suitable for arithmetic types.
+ *
+ * The typed containers copy elements by assignment and never destroy them, so they are meant for
+ * plain types. Types that own resources should use the generic containers.
+ *
+ * Example:
+ *
+ *   DSA_DEFINE_VECTOR(ivec, int)
+ *   DSA_DEFINE_SORT(isort, int, DSA_LESS)
+ *
+ *   ivec V;
+ *   ivec_initialize(&V);
+ *   ivec_push_back(&V, 42);
+ *   isort(V.data, V.count);
+ *
+ ************************************************************************************************/
+
+#ifndef _typed_h
+#define _typed_h
+
+#include <stdint.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "bst.h"
+#include "check.h"
+#include "hash.h"
+
+#define DSA_LESS(a, b)      ((a) < (b))
+#define DSA_EQUAL(a, b)     ((a) == (b))
+#define DSA_COMPARE(a, b)   (((a) > (b)) - ((a) < (b)))
+
+#define DSA_VECTOR_MIN_CAPACITY     8lu
+#define DSA_HASHMAP_MIN_CAPACITY    16lu
+#define DSA_SORT_THRESHOLD          16lu
+
+/* Hash an integer of up to 64 bits with a single multiplication, salted with hash_seed. */
+static inline uint32_t dsa_hash_int(uint64_t k)
+{
+    uint64_t h = (k ^ hash_seed) * 0x9e3779b97f4a7c15ull;
+    return hash_fold(h);
+}
+
+/*************************************************************************************************
+ * Vector
+ *
+ * int  name_initialize     (name *V)
+ * int  name_initialize_with(name *V, allocator *A)
+ * void name_destroy        (name *V)
+ * int  name_reserve        (name *V, size_t n)
+ * int  name_push_back      (name *V, T e)
+ * int  name_pop_back       (name *V, T *out)
+ * int  name_insert         (name *V, size_t i, T e)
+ * int  name_remove         (name *V, size_t i)
+ * T *  name_get            (name *V, size_t i)
+ *
+ * Same semantics and return values as the corresponding functions in vector.h, except that
+ * name_insert also accepts i == count to append.
+ */
+#define DSA_DEFINE_VECTOR(name, T) \
+    \
+typedef struct name { \
+    T *         data; \
+    size_t      count; \
+    size_t      capacity; \
+    allocator * alloc; \
+} name; \
+    \
+static inline int name##_reserve(name *V, size_t n) \
+{ \
+    size_t c = DSA_VECTOR_MIN_CAPACITY; \
+    while (c < n) c <<= 1; \
+    if (c == V->capacity) return 0; \
+    if (c < V->count) V->count = c; \
+    \
+    T *data = a_allocate(V->alloc, c * sizeof(T)); \
+    check(data != NULL, "failed to allocate storage"); \
+    if (V->count) memcpy(data, V->data, V->count * sizeof(T)); \
+    a_deallocate(V->alloc, V->data, V->capacity * sizeof(T)); \
+    V->data = data; \
+    V->capacity = c; \
+    return 0; \
+error: \
+    return -1; \
+} \
+    \
+static inline int name##_initialize_with(name *V, allocator *A) \
+{ \
+    check_ptr(V); \
+    V->data = NULL; \
+    V->count = 0; \
+    V->capacity = 0; \
+    V->alloc = A ? A : &malloc_allocator; \
+    return name##_reserve(V, DSA_VECTOR_MIN_CAPACITY); \
+error: \
+    return -1; \
+} \
+    \
+static inline int name##_initialize(name *V) \
+{ \
+    return name##_initialize_with(V, NULL); \
+} \
+    \
+static inline void name##_destroy(name *V) \
+{ \
+    if (V && V->data) { \
+        a_deallocate(V->alloc, V->data, V->capacity * sizeof(T)); \
+        V->data = NULL; \
+        V->count = 0; \
+        V->capacity = 0; \
+    } \
+} \
+    \
+static inline T *name##_get(name *V, size_t i) \
+{ \
+    return i < V->count ? V->data + i : NULL; \
+} \
+    \
+static inline int name##_push_back(name *V, T e) \
+{ \
+    if (V->count == V->capacity && name##_reserve(V, V->capacity << 1) < 0) return -1; \
+    V->data[V->count++] = e; \
+    return 1; \
+} \
+    \
+static inline int name##_pop_back(name *V, T *out) \
+{ \
+    if (V->count == 0) return 0; \
+    --V->count; \
+    if (out) *out = V->data[V->count]; \
+    return 1; \
+} \
+    \
+static inline int name##_insert(name *V, size_t i, T e) \
+{ \
+    check(i <= V->count, "index out of range"); \
+    if (V->count == V->capacity && name##_reserve(V, V->capacity << 1) < 0) return -1; \
+    memmove(V->data + i + 1, V->data + i, (V->count - i) * sizeof(T)); \
+    V->data[i] = e; \
+    ++V->count; \
+    return 1; \
+error: \
+    return -1; \
+} \
+    \
+static inline int name##_remove(name *V, size_t i) \
+{ \
+    check(i < V->count, "index out of range"); \
+    memmove(V->data + i, V->data + i + 1, (V->count - i - 1) * sizeof(T)); \
+    --V->count; \
+    return 1; \
+error: \
+    return -1; \
+}
+
+/*************************************************************************************************
+ * Sort
+ *
+ * void name(T *base, size_t n)
+ *
+ * Sort the n elements at base in ascending order according to less. Quicksort with a
+ * median-of-three pivot and Hoare partitioning, finishing short ranges with insertion sort. The
+ * recursion always descends into the smaller partition, so the stack depth is O(log n).
+ */
+#define DSA_DEFINE_SORT(name, T, less) \
+    \
+static inline void name##_insertion(T *a, size_t n) \
+{ \
+    for (size_t i = 1; i < n; ++i) { \
+        T x = a[i]; \
+        size_t j = i; \
+        while (j > 0 && less(x, a[j - 1])) { \
+            a[j] = a[j - 1]; \
+            --j; \
+        } \
+        a[j] = x; \
+    } \
+} \
+    \
+static inline void name(T *a, size_t n) \
+{ \
+    T t; \
+    while (n > DSA_SORT_THRESHOLD) { \
+        /* Order a[0], a[n/2], a[n-1], so the pivot is the median of the three. */ \
+        size_t m = n / 2; \
+        if (less(a[m], a[0]))     { t = a[m]; a[m] = a[0]; a[0] = t; } \
+        if (less(a[n - 1], a[m])) { t = a[m]; a[m] = a[n - 1]; a[n - 1] = t; } \
+        if (less(a[m], a[0]))     { t = a[m]; a[m] = a[0]; a[0] = t; } \
+        T pivot = a[m]; \
+        \
+        size_t i = 0, j = n - 1; \
+        for ( ;; ) { \
+            while (less(a[i], pivot)) ++i; \
+            while (less(pivot, a[j])) --j; \
+            if (i >= j) break; \
+            t = a[i]; a[i] = a[j]; a[j] = t; \
+            ++i; --j; \
+        } \
+        \
+        /* [0, j] and ]j, n[ are both non-empty. */ \
+        if (j + 1 < n - j - 1) { \
+            name(a, j + 1); \
+            a += j + 1; \
+            n -= j + 1; \
+        } else { \
+            name(a + j + 1, n - j - 1); \
+            n = j + 1; \
+        } \
+    } \
+    name##_insertion(a, n); \
+}
+
+/*************************************************************************************************
+ * Hashmap
+ *
+ * int  name_initialize     (name *M)
+ * int  name_initialize_with(name *M, allocator *A)
+ * void name_destroy        (name *M)
+ * void name_clear          (name *M)
+ * int  name_reserve        (name *M, size_t n)
+ * int  name_set            (name *M, K k, V v)
+ * V *  name_get            (name *M, K k)
+ * int  name_has            (const name *M, K k)
+ * int  name_remove         (name *M, K k)
+ *
+ * Same semantics and return values as the corresponding functions in hashmap.h. Entries are
+ * stored inline with linear probing. Removal shifts the following entries of the cluster back, so
+ * there are no tombstones and the table never needs to be rebuilt because of deletions. The table
+ * grows when it is more than 3/4 full.
+ */
+#define DSA_DEFINE_HASHMAP(name, K, V, hash, equal) \
+    \
+typedef struct name##_entry { \
+    K           key; \
+    V           value; \
+} name##_entry; \
+    \
+typedef struct name { \
+    name##_entry *  entries; \
+    uint8_t *       used; \
+    size_t          capacity; \
+    size_t          count; \
+    allocator *     alloc; \
+} name; \
+    \
+static inline size_t name##_slot(const name *M, K k) \
+{ \
+    size_t mask = M->capacity - 1; \
+    size_t i = (size_t)hash(k) & mask; \
+    while (M->used[i] && !equal(M->entries[i].key, k)) i = (i + 1) & mask; \
+    return i; \
+} \
+    \
+static inline int name##_rehash(name *M, size_t capacity) \
+{ \
+    name##_entry *entries = a_allocate(M->alloc, capacity * sizeof(name##_entry)); \
+    uint8_t *used = a_callocate(M->alloc, capacity); \
+    check(entries != NULL && used != NULL, "failed to allocate table"); \
+    \
+    name N = { entries, used, capacity, M->count, M->alloc }; \
+    for (size_t i = 0; i < M->capacity; ++i) { \
+        if (!M->used[i]) continue; \
+        size_t j = name##_slot(&N, M->entries[i].key); \
+        N.entries[j] = M->entries[i]; \
+        N.used[j] = 1; \
+    } \
+    \
+    a_deallocate(M->alloc, M->entries, M->capacity * sizeof(name##_entry)); \
+    a_deallocate(M->alloc, M->used, M->capacity); \
+    *M = N; \
+    return 0; \
+error: \
+    a_deallocate(M->alloc, entries, capacity * sizeof(name##_entry)); \
+    a_deallocate(M->alloc, used, capacity); \
+    return -1; \
+} \
+    \
+static inline int name##_initialize_with(name *M, allocator *A) \
+{ \
+    check_ptr(M); \
+    M->entries = NULL; \
+    M->used = NULL; \
+    M->capacity = 0; \
+    M->count = 0; \
+    M->alloc = A ? A : &malloc_allocator; \
+    return name##_rehash(M, DSA_HASHMAP_MIN_CAPACITY); \
+error: \
+    return -1; \
+} \
+    \
+static inline int name##_initialize(name *M) \
+{ \
+    return name##_initialize_with(M, NULL); \
+} \
+    \
+static inline void name##_destroy(name *M) \
+{ \
+    if (M && M->entries) { \
+        a_deallocate(M->alloc, M->entries, M->capacity * sizeof(name##_entry)); \
+        a_deallocate(M->alloc, M->used, M->capacity); \
+        M->entries = NULL; \
+        M->used = NULL; \
+        M->capacity = 0; \
+        M->count = 0; \
+    } \
+} \
+    \
+static inline void name##_clear(name *M) \
+{ \
+    memset(M->used, 0, M->capacity); \
+    M->count = 0; \
+} \
+    \
+static inline int name##_reserve(name *M, size_t n) \
+{ \
+    size_t c = DSA_HASHMAP_MIN_CAPACITY; \
+    while (c / 4 * 3 < n) c <<= 1; \
+    return c > M->capacity ? name##_rehash(M, c) : 0; \
+} \
+    \
+static inline int name##_set(name *M, K k, V v) \
+{ \
+    size_t i = name##_slot(M, k); \
+    if (M->used[i]) { \
+        M->entries[i].value = v; \
+        return 0; \
+    } \
+    if (M->count + 1 > M->capacity / 4 * 3) { \
+        if (name##_rehash(M, M->capacity << 1) < 0) return -1; \
+        i = name##_slot(M, k); \
+    } \
+    M->entries[i].key = k; \
+    M->entries[i].value = v; \
+    M->used[i] = 1; \
+    ++M->count; \
+    return 1; \
+} \
+    \
+static inline V *name##_get(name *M, K k) \
+{ \
+    size_t i = name##_slot(M, k); \
+    return M->used[i] ? &M->entries[i].value : NULL; \
+} \
+    \
+static inline int name##_has(const name *M, K k) \
+{ \
+    return M->used[name##_slot(M, k)]; \
+} \
+    \
+static inline int name##_remove(name *M, K k) \
+{ \
+    size_t mask = M->capacity - 1; \
+    size_t i = name##_slot(M, k); \
+    if (!M->used[i]) return 0; \
+    \
+    /* Move entries of the same cluster back into the hole unless that would put them before \
+     * their home slot. */ \
+    for (size_t j = (i + 1) & mask; M->used[j]; j = (j + 1) & mask) { \
+        size_t h = (size_t)hash(M->entries[j].key) & mask; \
+        if (((j - h) & mask) >= ((j - i) & mask)) { \
+            M->entries[i] = M->entries[j]; \
+            i = j; \
+        } \
+    } \
+    M->used[i] = 0; \
+    --M->count; \
+    return 1; \
+}
+
+/*************************************************************************************************
+ * BST lookup
+ *
+ * int    name_has(const bst *T, K k)
+ * void * name_get(      bst *T, K k)
+ *
+ * Search a generic bst whose key type interface stores objects of type K, comparing keys inline
+ * instead of through the type interface. Same return values as bst_has and bst_get. Insertion and
+ * removal still go through the generic interface.
+ */
+#define DSA_DEFINE_BST_LOOKUP(name, K, compare) \
+    \
+static inline bst_n *name##_find(const bst *T, K k) \
+{ \
+    bst_n *n = T->root; \
+    while (n) { \
+        K nk; \
+        memcpy(&nk, bst_n_key(T, n), sizeof(K)); \
+        int cmp = compare(k, nk); \
+        if      (cmp < 0) n = n->left; \
+        else if (cmp > 0) n = n->right; \
+        else break; \
+    } \
+    return n; \
+} \
+    \
+static inline int name##_has(const bst *T, K k) \
+{ \
+    return name##_find(T, k) != NULL; \
+} \
+    \
+static inline void *name##_get(bst *T, K k) \
+{ \
+    bst_n *n = name##_find(T, k); \
+    return n ? bst_n_value(T, n) : NULL; \
+}
+
+#endif /* _typed_h */
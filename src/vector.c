@@ -16,17 +16,25 @@
 #include "check.h"
 #include "vector.h"
 
-/* int vector_initialize(vector *V, t_intf *dt)
+/* int vector_initialize     (vector *V, t_intf *dt)
+ * int vector_initialize_with(vector *V, t_intf *dt, allocator *A)
  * Initialize the vector at V with the type interface dt. We assume there's enough space. Returns
- * 0 on success, or -1 on error. */
+ * 0 on success, or -1 on error. vector_initialize_with takes the storage for elements from the
+ * allocator A instead of malloc. */
 int vector_initialize(vector *V, t_intf *dt)
+{
+    return vector_initialize_with(V, dt, NULL);
+}
+
+int vector_initialize_with(vector *V, t_intf *dt, allocator *A)
 {
     check_ptr(V);
     check_ptr(dt);
     check(dt->size, "no data size");
 
-    V->data = malloc(VECTOR_MIN_CAPACITY * t_size(dt));
-    check_alloc(V->data);
+    V->alloc = A ? A : &malloc_allocator;
+    V->data = a_allocate(V->alloc, VECTOR_MIN_CAPACITY * t_size(dt));
+    check(V->data != NULL, "failed to allocate storage");
 
     V->count = 0;
     V->capacity = VECTOR_MIN_CAPACITY;
@@ -50,7 +58,6 @@ vector *vector_new(t_intf *dt)
 
     return V;
 error:
-    if (V->data) free(V->data);
     if (V) free(V);
     return NULL;
 }
@@ -63,7 +70,7 @@ void vector_destroy(vector *V)
 {
     if (V && V->data) {
         vector_clear(V);
-        free(V->data);
+        a_deallocate(V->alloc, V->data, V->capacity * t_size(V->data_type));
         V->data = NULL;
         V->count = 0;
         V->capacity = 0;
@@ -96,22 +103,18 @@ int vector_reserve(vector *V, const size_t n)
     /* If we have an element destructor, we need to make sure that all elements that we are going
      * to cut off are properly destroyed. */
     if (c < V->count) {
-        for (size_t i = c; i < V->count; ++i) {
-            t_destroy(V->data_type, V->data + i * s);
-        }
+        t_destroy_n(V->data_type, V->data + c * s, V->count - c);
         V->count = c;
     }
 
     /* We can't assume that all types of objects remain intact when only the top level data is
      * moved, so we can't use realloc. Allocate the new storage, move all elements there, destroy
      * the old storage. */
-    char *new_data = malloc(c * s);
-    check_alloc(new_data);
-    for (size_t i = 0; i < V->count; ++i) {
-        t_move(V->data_type, new_data + i * s, V->data + i * s);
-    }
+    char *new_data = a_allocate(V->alloc, c * s);
+    check(new_data != NULL, "failed to allocate storage");
+    t_relocate(V->data_type, new_data, V->data, V->count);
 
-    free(V->data);
+    a_deallocate(V->alloc, V->data, V->capacity * s);
     V->data = new_data;
     V->capacity = c;
 
@@ -136,14 +139,11 @@ int vector_shrink_to_fit(vector *V)
 
     size_t s = t_size(V->data_type);
 
-    char *new_data = malloc(c * s);
-    check_alloc(new_data);
-
-    for (size_t i = 0; i < V->count; ++i) {
-        t_move(V->data_type, new_data + i * s, V->data + i * s);
-    }
+    char *new_data = a_allocate(V->alloc, c * s);
+    check(new_data != NULL, "failed to allocate storage");
+    t_relocate(V->data_type, new_data, V->data, V->count);
 
-    free(V->data);
+    a_deallocate(V->alloc, V->data, V->capacity * s);
     V->data = new_data;
     V->capacity = c;
 
@@ -157,9 +157,7 @@ error:
 void vector_clear(vector *V)
 {
     if (V && V->data) {
-        for (size_t i = 0; i < V->count; ++i) {
-            t_destroy(V->data_type, V->data + i * t_size(V->data_type));
-        }
+        t_destroy_n(V->data_type, V->data, V->count);
         V->count = 0;
         vector_reserve(V, VECTOR_MIN_CAPACITY);
     }
@@ -215,14 +213,10 @@ int vector_insert(vector *V, const size_t i, const void *e)
         check_rc(rc, "vector_reserve");
     }
 
-    /* Move all subsequent elements one slot to the right, beginning with the last one so as to
-     * not overwrite anything. */
+    /* Move all subsequent elements one slot to the right (with a single memmove if the type
+     * allows it). */
     size_t s = t_size(V->data_type);
-    if (V->count) {
-        for (size_t j = V->count - 1; j >= i && j != SIZE_MAX; --j) {
-            t_move(V->data_type, V->data + (j + 1) * s, V->data + j * s);
-        }
-    }
+    t_relocate(V->data_type, V->data + (i + 1) * s, V->data + i * s, V->count - i);
 
     t_copy(V->data_type, V->data + i * s, e);
     ++V->count;
@@ -244,11 +238,7 @@ int vector_remove(vector *V, const size_t i)
     t_destroy(V->data_type, V->data + i * s);
 
     /* Move all subsequent elements one slot to the left. */
-    if (i < V->count - 1) {
-        for (size_t j = i + 1; j < V->count; ++j) {
-            t_move(V->data_type, V->data + (j - 1) * s, V->data + j * s);
-        }
-    }
+    t_relocate(V->data_type, V->data + i * s, V->data + (i + 1) * s, V->count - i - 1);
 
     --V->count;
 
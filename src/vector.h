@@ -13,6 +13,7 @@
 #define _vector_h
 
 #include <stdlib.h>
+#include "allocator.h"
 #include "type_interface.h"
 
 #define VECTOR_MIN_CAPACITY 8lu
@@ -22,6 +23,7 @@ typedef struct {
     size_t      count;
     size_t      capacity;
     t_intf *    data_type;
+    allocator * alloc;
 } vector;
 
 #define vector_capacity(V)  (V)->capacity
@@ -36,6 +38,7 @@ typedef struct {
     ((V)->count > 0 ? (void*)((V)->data + ((V)->count - 1) * t_size((V)->data_type)) : NULL)
 
 int         vector_initialize       (vector *V, t_intf *dt);
+int         vector_initialize_with  (vector *V, t_intf *dt, allocator *A);
 vector *    vector_new              (           t_intf *dt);
 void        vector_destroy          (vector *V);
 void        vector_delete           (vector *V);
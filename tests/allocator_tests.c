@@ -0,0 +1,140 @@
+#include <stdint.h>
+
+#include "allocator.h"
+#include "bst.h"
+#include "fhashmap.h"
+#include "hashmap.h"
+#include "list.h"
+#include "test.h"
+#include "vector.h"
+
+static arena A;
+
+int test_arena(void)
+{
+    int rc = arena_initialize(&A, 256);
+    test(rc == 0);
+    test(A.chunks == NULL);
+
+    allocator *a = arena_allocator(&A);
+    char *p = a_allocate(a, 3);
+    char *q = a_allocate(a, 3);
+    test(p && q);
+    test((uintptr_t)p % ALLOCATOR_ALIGNMENT == 0);
+    test(q == p + ALLOCATOR_ALIGNMENT);
+
+    /* Requests larger than the chunk size get a chunk of their own. */
+    char *r = a_callocate(a, 1000);
+    test(r != NULL);
+    test(r[0] == 0 && r[999] == 0);
+
+    a_deallocate(a, q, 3);
+    arena_clear(&A);
+    test(A.chunks == NULL);
+
+    return 0;
+}
+
+int test_bump(void)
+{
+    char buffer[129];
+    bump B;
+
+    int rc = bump_initialize(&B, buffer, sizeof(buffer));
+    test(rc == 0);
+    test((uintptr_t)B.buffer % ALLOCATOR_ALIGNMENT == 0);
+
+    allocator *a = bump_allocator(&B);
+    char *p = a_allocate(a, 16);
+    char *q = a_allocate(a, 20);
+    test(p && q);
+    test(q == p + 16);
+
+    /* Only the most recent allocation can be released. */
+    a_deallocate(a, p, 16);
+    test(B.used == 48);
+    a_deallocate(a, q, 20);
+    test(B.used == 16);
+
+    bump_reset(&B);
+    test(B.used == 0);
+
+    /* The buffer is never exceeded. */
+    test(a_allocate(&B.base, B.size) != NULL);
+    test(B.base.allocate(&B.base, 1) == NULL);
+
+    return 0;
+}
+
+int test_containers_with_arena(void)
+{
+    int rc = arena_initialize(&A, 0);
+    test(rc == 0);
+
+    vector V;
+    rc = vector_initialize_with(&V, &int_type, arena_allocator(&A));
+    test(rc == 0);
+    for (int i = 0; i < 1000; ++i) {
+        rc = vector_push_back(&V, &i);
+        test(rc == 1);
+    }
+    test(*(int*)vector_last(&V) == 999);
+
+    list L;
+    rc = list_initialize_with(&L, &int_type, arena_allocator(&A));
+    test(rc == 0);
+    for (int i = 0; i < 1000; ++i) {
+        rc = list_push_back(&L, &i);
+        test(rc == 1);
+    }
+    test(list_count(&L) == 1000);
+
+    bst T;
+    rc = bst_initialize_with(&T, RB, &int_type, &int_type, arena_allocator(&A));
+    test(rc == 0);
+    for (int i = 0; i < 1000; ++i) {
+        rc = bst_set(&T, &i, &i);
+        test(rc == 1);
+    }
+    test(bst_count(&T) == 1000);
+    test(bst_invariant(&T, NULL) == 0);
+
+    hashmap M;
+    rc = hashmap_initialize_with(&M, &int_type, &int_type, 0, arena_allocator(&A));
+    test(rc == 0);
+    for (int i = 0; i < 1000; ++i) {
+        rc = hashmap_set(&M, &i, &i);
+        test(rc == 1);
+    }
+    test(hashmap_count(&M) == 1000);
+
+    fhashmap F;
+    rc = fhashmap_initialize_with(&F, &int_type, &int_type, arena_allocator(&A));
+    test(rc == 0);
+    for (int i = 0; i < 1000; ++i) {
+        rc = fhashmap_set(&F, &i, &i);
+        test(rc == 1);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        int *v = fhashmap_get(&F, &i);
+        test(v && *v == i);
+    }
+
+    vector_destroy(&V);
+    list_destroy(&L);
+    bst_destroy(&T);
+    hashmap_destroy(&M);
+    fhashmap_destroy(&F);
+    arena_destroy(&A);
+
+    return 0;
+}
+
+int main(void)
+{
+    test_suite_start();
+    run_test(test_arena);
+    run_test(test_bump);
+    run_test(test_containers_with_arena);
+    test_suite_end();
+}
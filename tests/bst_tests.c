@@ -16,7 +16,7 @@ int test_node_handlers(void)
     bst *T = bst_new(NONE, &str_type, &int_type);
     test(T);
 
-    bst_n *n = calloc(1, bst_n_size(T));
+    bst_n *n = pool_alloc(&T->node_pool);
     test(n);
 
     str *k1 = str_from_cstr("key");
@@ -72,6 +72,8 @@ int test_bst_copy(void)
     n->left = l;
     n->right = r;
     r->left = rl;
+    r->count = 2;
+    n->count = 4;
 
     /* test bst_n_find here for lack of a better place */
     bst_n *x = bst_n_find(T, T->root, krl);
@@ -145,6 +147,8 @@ int test_bst_has(void)
     T->root = bst_n_new(T, c, NULL);
     T->root->left = bst_n_new(T, a, NULL);
     T->root->left->right = bst_n_new(T, b, NULL);
+    T->root->left->count = 2;
+    T->root->count = 3;
 
     T->count = 3;
 
@@ -313,6 +317,235 @@ int test_bst_set_get(void)
     return 0;
 }
 
+int test_bst_order_statistics(void)
+{
+    uint8_t flavors[] = { NONE, RB, AVL };
+    char present[MAXV];
+    int rc, i, v;
+
+    for (size_t f = 0; f < sizeof(flavors); ++f) {
+        bst *T = bst_new(flavors[f], &int_type, NULL);
+        memset(present, 0, sizeof(present));
+
+        for (i = 0; i < 4 * NMEMB; ++i) {
+            v = rand() % MAXV;
+            if (rand() % 3) {
+                rc = bst_insert(T, &v);
+                present[v] = 1;
+            } else {
+                rc = bst_remove(T, &v);
+                present[v] = 0;
+            }
+            test(rc >= 0);
+        }
+        test(bst_invariant(T, NULL) == 0);
+
+        /* Compare with ranks computed by counting. */
+        size_t rank = 0;
+        for (v = 0; v < MAXV; ++v) {
+            test(bst_rank(T, &v) == rank);
+            if (present[v]) {
+                int *k = bst_select(T, rank);
+                test(k && *k == v);
+                ++rank;
+            }
+        }
+        test(rank == bst_count(T));
+        test(bst_select(T, rank) == NULL);
+
+        for (i = 0; i < NMEMB; ++i) {
+            int lo = rand() % MAXV, hi = rand() % MAXV;
+            size_t count = 0;
+            for (v = lo; v < hi; ++v) count += present[v];
+            test(bst_count_range(T, &lo, &hi) == count);
+
+            /* A NULL bound leaves the range open on that side. */
+            test(bst_count_range(T, NULL, &hi) == bst_rank(T, &hi));
+            test(bst_count_range(T, &lo, NULL) == bst_count(T) - bst_rank(T, &lo));
+        }
+        test(bst_count_range(T, NULL, NULL) == bst_count(T));
+
+        bst_delete(T);
+    }
+
+    return 0;
+}
+
+struct range_check {
+    const char *present;
+    int next;           /* the next key we expect */
+    int hi;
+    int visited;
+};
+
+static int check_range_key(void *k, void *p)
+{
+    struct range_check *r = p;
+    while (r->next < r->hi && !r->present[r->next]) ++r->next;
+    if (*(int*)k != r->next) return 1;
+    ++r->next;
+    ++r->visited;
+    return 0;
+}
+
+static int check_range_value(void *v, void *p)
+{
+    int k = -*(int*)v;
+    return check_range_key(&k, p);
+}
+
+static int stop_after_one(void *k, void *p)
+{
+    (void)k;
+    ++*(int*)p;
+    return 7;
+}
+
+int test_bst_bounds_range(void)
+{
+    uint8_t flavors[] = { NONE, RB, AVL };
+    char present[MAXV];
+    int rc, i, v, w;
+
+    for (size_t f = 0; f < sizeof(flavors); ++f) {
+        bst *T = bst_new(flavors[f], &int_type, &int_type);
+        memset(present, 0, sizeof(present));
+
+        for (i = 0; i < NMEMB; ++i) {
+            v = rand() % MAXV;
+            w = -v;
+            rc = bst_set(T, &v, &w);
+            test(rc >= 0);
+            present[v] = 1;
+        }
+
+        for (v = -1; v <= MAXV; ++v) {
+            int lower = v < 0 ? 0 : v;
+            while (lower < MAXV && !present[lower]) ++lower;
+            int upper = v + 1;
+            while (upper < MAXV && !present[upper]) ++upper;
+            int floor = v >= MAXV ? MAXV - 1 : v;
+            while (floor >= 0 && !present[floor]) --floor;
+
+            int *k = bst_lower_bound(T, &v);
+            test(lower < MAXV ? k && *k == lower : k == NULL);
+            test(bst_ceiling(T, &v) == k);
+            k = bst_upper_bound(T, &v);
+            test(upper < MAXV ? k && *k == upper : k == NULL);
+            k = bst_floor(T, &v);
+            test(floor >= 0 ? k && *k == floor : k == NULL);
+        }
+
+        for (i = 0; i < NMEMB; ++i) {
+            int lo = rand() % MAXV, hi = rand() % MAXV;
+            struct range_check r = { present, lo, hi, 0 };
+            rc = bst_traverse_range(T, &lo, &hi, check_range_key, &r);
+            test(rc == 0);
+            test((size_t)r.visited == bst_count_range(T, &lo, &hi));
+
+            r = (struct range_check){ present, lo, hi, 0 };
+            rc = bst_traverse_range_values(T, &lo, &hi, check_range_value, &r);
+            test(rc == 0);
+        }
+
+        /* Unbounded on both sides means everything. */
+        struct range_check r = { present, 0, MAXV, 0 };
+        rc = bst_traverse_range(T, NULL, NULL, check_range_key, &r);
+        test(rc == 0);
+        test((size_t)r.visited == bst_count(T));
+
+        int calls = 0;
+        rc = bst_traverse_range(T, NULL, NULL, stop_after_one, &calls);
+        test(rc == 7 && calls == 1);
+
+        bst_delete(T);
+    }
+
+    return 0;
+}
+
+int test_bst_iter(void)
+{
+    uint8_t flavors[] = { NONE, RB, AVL };
+    char present[MAXV];
+    bst_iter it, jt;
+    int rc, i, v, *k;
+
+    for (size_t f = 0; f < sizeof(flavors); ++f) {
+        bst *T = bst_new(flavors[f], &int_type, &int_type);
+        bst_iter_first(&it, T);
+        test(bst_iter_key(&it) == NULL);
+        test(bst_iter_next(&it) == NULL);
+
+        memset(present, 0, sizeof(present));
+        for (i = 0; i < NMEMB; ++i) {
+            v = rand() % MAXV;
+            rc = bst_set(T, &v, &i);
+            test(rc >= 0);
+            present[v] = 1;
+        }
+
+        /* forwards and backwards */
+        v = 0;
+        for (k = bst_iter_first(&it, T); k; k = bst_iter_next(&it)) {
+            while (!present[v]) ++v;
+            test(*k == v);
+            test(bst_iter_value(&it) == bst_get(T, k));
+            ++v;
+        }
+        test(bst_iter_next(&it) == NULL);
+
+        v = MAXV - 1;
+        for (k = bst_iter_last(&it, T); k; k = bst_iter_prev(&it)) {
+            while (!present[v]) --v;
+            test(*k == v);
+            --v;
+        }
+
+        /* seek, then change direction */
+        for (i = 0; i < NMEMB; ++i) {
+            v = rand() % MAXV;
+            k = bst_iter_seek(&it, T, &v);
+            test(k == bst_lower_bound(T, &v));
+            if (!k) continue;
+            int *n = bst_iter_next(&it);
+            test(n == bst_upper_bound(T, k));
+            if (n) {
+                test(bst_iter_prev(&it) == k);
+            }
+        }
+
+        bst_delete(T);
+    }
+
+    /* Two iterators over the same tree advance independently. */
+    bst *T = bst_new(RB, &int_type, NULL);
+    for (i = 0; i < NMEMB; ++i) bst_insert(T, &i);
+    bst_iter_first(&it, T);
+    bst_iter_first(&jt, T);
+    for (i = 0; i < NMEMB / 2; ++i) bst_iter_next(&it);
+    test(*(int*)bst_iter_key(&it) == NMEMB / 2);
+    test(*(int*)bst_iter_key(&jt) == 0);
+    bst_delete(T);
+
+    /* An unbalanced tree deeper than the path of the iterator. */
+    T = bst_new(NONE, &int_type, NULL);
+    for (i = 0; i < 2 * BST_ITER_MAX_DEPTH; ++i) bst_insert(T, &i);
+    i = 0;
+    for (k = bst_iter_first(&it, T); k; k = bst_iter_next(&it)) test(*k == i++);
+    test(i == 2 * BST_ITER_MAX_DEPTH);
+    for (k = bst_iter_last(&it, T); k; k = bst_iter_prev(&it)) test(*k == --i);
+    test(i == 0);
+    v = BST_ITER_MAX_DEPTH + 3;
+    k = bst_iter_seek(&it, T, &v);
+    test(k && *k == v);
+    k = bst_iter_prev(&it);
+    test(k && *k == v - 1);
+    bst_delete(T);
+
+    return 0;
+}
+
 int main(void)
 {
     test_suite_start();
@@ -328,6 +561,9 @@ int main(void)
     run_test(test_bst_insert);
     run_test(test_bst_remove);
     run_test(test_bst_set_get);
+    run_test(test_bst_order_statistics);
+    run_test(test_bst_bounds_range);
+    run_test(test_bst_iter);
 
     test_suite_end();
 }
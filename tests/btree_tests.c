@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "btree.h"
+#include "map.h"
+#include "set.h"
+#include "str.h"
+#include "test.h"
+#include "test_utils.h"
+#include "type_interface.h"
+
+#define NMEMB 4096
+#define MAXV 8192
+
+int test_btree_insert(void)
+{
+    btree *T = btree_new(&int_type, NULL);
+    size_t height;
+    int rc, i, v;
+
+    for (i = 0; i < NMEMB; ++i) {
+        rc = btree_insert(T, &i);
+        test(rc == 1);
+        test(btree_count(T) == (size_t)i + 1);
+        test(btree_has(T, &i) == 1);
+    }
+    test(btree_invariant(T, &height) == 0);
+    test(height <= 3);
+
+    v = 0;
+    rc = btree_insert(T, &v);
+    test(rc == 0);
+    v = -1;
+    test(btree_has(T, &v) == 0);
+
+    btree_clear(T);
+    test(btree_count(T) == 0);
+    test(T->root == NULL);
+
+    for (i = NMEMB; i > 0; --i) {
+        rc = btree_insert(T, &i);
+        test(rc == 1);
+    }
+    test(btree_invariant(T, NULL) == 0);
+
+    btree_clear(T);
+
+    char present[MAXV] = { 0 };
+    size_t count = 0;
+    for (i = 0; i < NMEMB; ++i) {
+        v = rand() % MAXV;
+        rc = btree_insert(T, &v);
+        test(rc == !present[v]);
+        if (rc == 1) ++count;
+        present[v] = 1;
+        test(btree_count(T) == count);
+    }
+    test(btree_invariant(T, NULL) == 0);
+
+    for (v = 0; v < MAXV; ++v) {
+        test(btree_has(T, &v) == present[v]);
+    }
+
+    btree_delete(T);
+    return 0;
+}
+
+int test_btree_remove(void)
+{
+    btree *T = btree_new(&int_type, NULL);
+    char present[MAXV] = { 0 };
+    size_t count = 0;
+    int rc, i, v;
+
+    for (i = 0; i < NMEMB; ++i) {
+        v = rand() % MAXV;
+        rc = btree_insert(T, &v);
+        if (rc == 1) ++count;
+        present[v] = 1;
+    }
+
+    for (i = 0; i < 4 * NMEMB; ++i) {
+        v = rand() % MAXV;
+        if (rand() % 2) {
+            rc = btree_remove(T, &v);
+            test(rc == present[v]);
+            if (rc == 1) --count;
+            present[v] = 0;
+        } else {
+            rc = btree_insert(T, &v);
+            test(rc == !present[v]);
+            if (rc == 1) ++count;
+            present[v] = 1;
+        }
+        test(btree_count(T) == count);
+        if (i % 256 == 0) test(btree_invariant(T, NULL) == 0);
+    }
+    test(btree_invariant(T, NULL) == 0);
+
+    for (v = 0; v < MAXV; ++v) {
+        rc = btree_remove(T, &v);
+        test(rc == present[v]);
+    }
+    test(btree_count(T) == 0);
+    test(T->root == NULL);
+    test(btree_invariant(T, NULL) == 0);
+
+    btree_delete(T);
+    return 0;
+}
+
+int test_btree_set_get(void)
+{
+    btree *T = btree_new(&str_type, &int_type);
+    str *keys[NMEMB];
+    int values[NMEMB];
+    int rc, i, *v;
+
+    /* Random keys can repeat, so every key takes the value of its last occurrence. */
+    for (i = 0; i < NMEMB; ++i) {
+        keys[i] = random_str(rand() % 32 + 1);
+        values[i] = i;
+        rc = btree_set(T, keys[i], values + i);
+        test(rc >= 0);
+    }
+    test(btree_invariant(T, NULL) == 0);
+
+    for (i = 0; i < NMEMB; ++i) {
+        v = btree_get(T, keys[i]);
+        test(v != NULL);
+        test(str_compare(keys[*v], keys[i]) == 0);
+        test(*v >= i);
+    }
+
+    for (i = 0; i < NMEMB; ++i) {
+        values[i] = -i;
+        rc = btree_set(T, keys[i], values + i);
+        test(rc == 0);
+    }
+
+    for (i = NMEMB; i-- > 0; ) {
+        rc = btree_remove(T, keys[i]);
+        if (rc == 1) {
+            test(btree_get(T, keys[i]) == NULL);
+        } else {
+            test(rc == 0);
+        }
+    }
+    test(btree_count(T) == 0);
+
+    /* A key inserted without a value gets a zero value. */
+    rc = btree_insert(T, keys[0]);
+    test(rc == 1);
+    v = btree_get(T, keys[0]);
+    test(v && *v == 0);
+
+    for (i = 0; i < NMEMB; ++i) str_delete(keys[i]);
+    btree_delete(T);
+    return 0;
+}
+
+static int check_ascending(void *k, void *p)
+{
+    int *last = p;
+    if (*(int*)k <= *last) return 1;
+    *last = *(int*)k;
+    return 0;
+}
+
+static int check_descending(void *k, void *p)
+{
+    int *last = p;
+    if (*(int*)k >= *last) return 1;
+    *last = *(int*)k;
+    return 0;
+}
+
+static int sum_values(void *v, void *p)
+{
+    *(long*)p += *(int*)v;
+    return 0;
+}
+
+int test_btree_copy_traverse(void)
+{
+    btree *T = btree_new(&int_type, &int_type);
+    long sum = 0, copy_sum = 0;
+    int rc, i, v, last;
+
+    for (i = 0; i < NMEMB; ++i) {
+        v = rand() % MAXV;
+        rc = btree_set(T, &v, &i);
+        test(rc >= 0);
+    }
+    rc = btree_traverse_values(T, sum_values, &sum);
+    test(rc == 0);
+
+    btree *C = btree_copy(T);
+    test(C != NULL);
+    test(btree_count(C) == btree_count(T));
+    test(btree_invariant(C, NULL) == 0);
+
+    last = -1;
+    rc = btree_traverse_keys(C, check_ascending, &last);
+    test(rc == 0);
+    last = MAXV;
+    rc = btree_traverse_keys_r(C, check_descending, &last);
+    test(rc == 0);
+    rc = btree_traverse_values_r(C, sum_values, &copy_sum);
+    test(rc == 0);
+    test(sum == copy_sum);
+
+    /* The copy is independent of the original. */
+    btree_clear(T);
+    test(btree_invariant(C, NULL) == 0);
+    last = -1;
+    rc = btree_traverse_keys(C, check_ascending, &last);
+    test(rc == 0);
+
+    btree_delete(C);
+    btree_delete(T);
+    return 0;
+}
+
+int test_bmap_bset(void)
+{
+    bmap *M = bmap_new(&int_type, &int_type);
+    bset *S = bset_new(&int_type);
+    int rc, i, w;
+
+    for (i = 0; i < NMEMB; ++i) {
+        w = 2 * i;
+        rc = bmap_set(M, &i, &w);
+        test(rc == 1);
+        rc = bset_insert(S, &w);
+        test(rc == 1);
+    }
+    test(bmap_count(M) == NMEMB);
+    test(bset_count(S) == NMEMB);
+
+    for (i = 0; i < NMEMB; ++i) {
+        int *v = bmap_get(M, &i);
+        test(v && *v == 2 * i);
+        test(bset_has(S, v) == 1);
+        w = 2 * i + 1;
+        test(bset_has(S, &w) == 0);
+    }
+
+    for (i = 0; i < NMEMB; i += 2) {
+        rc = bmap_remove(M, &i);
+        test(rc == 1);
+        test(bmap_has(M, &i) == 0);
+    }
+    test(bmap_count(M) == NMEMB / 2);
+
+    bset_delete(S);
+    bmap_delete(M);
+    return 0;
+}
+
+int main(void)
+{
+    test_suite_start();
+
+    unsigned seed = (unsigned)time(NULL);
+    srand(seed);
+
+    run_test(test_btree_insert);
+    run_test(test_btree_remove);
+    run_test(test_btree_set_get);
+    run_test(test_btree_copy_traverse);
+    run_test(test_bmap_bset);
+
+    test_suite_end();
+}
@@ -0,0 +1,170 @@
+#include "log.h"
+#include "fhashmap.h"
+#include "str.h"
+#include "test.h"
+#include "test_utils.h"
+#include "type_interface.h"
+
+static fhashmap *M;
+static int rc, k, v;
+
+int test_fhashmap_new(void)
+{
+    M = fhashmap_new(&int_type, &int_type);
+    test(M != NULL);
+    test(M->key_type == &int_type);
+    test(M->value_type == &int_type);
+    test(M->ctrl != NULL);
+    test(fhashmap_capacity(M) == FHASHMAP_MIN_CAPACITY);
+
+    return 0;
+}
+
+int test_fhashmap_usage(void)
+{
+    int *vp;
+
+    for (int i = 0, j = 0; i < 10; ++i, j = 10 * i) {
+        rc = fhashmap_set(M, &i, &j);
+        test(rc == 1);
+        test(fhashmap_count(M) == (size_t)i + 1);
+    }
+
+    for (int i = 0, j = 0; i < 10; ++i, j = 10 * i) {
+        vp = fhashmap_get(M, &i);
+        test(vp);
+        test(*vp == j);
+    }
+
+    k = 10;
+    v = 0;
+
+    rc = fhashmap_has(M, &k);
+    test(rc == 0);
+
+    vp = fhashmap_get(M, &k);
+    test(!vp);
+
+    rc = fhashmap_remove(M, &k);
+    test(rc == 0);
+
+    k = 1;
+    v = 11;
+
+    rc = fhashmap_set(M, &k, &v);
+    test(rc == 0);
+    vp = fhashmap_get(M, &k);
+    test(vp);
+    test(*vp == 11);
+
+    rc = fhashmap_remove(M, &k);
+    test(rc == 1);
+    test(fhashmap_count(M) == 9);
+
+    rc = fhashmap_has(M, &k);
+    test(rc == 0);
+
+    return 0;
+}
+
+int test_fhashmap_growth(void)
+{
+    int *vp;
+    int n = 10000;
+
+    fhashmap_clear(M);
+    test(fhashmap_count(M) == 0);
+
+    for (int i = 0; i < n; ++i) {
+        v = -i;
+        rc = fhashmap_set(M, &i, &v);
+        test(rc == 1);
+    }
+    test(fhashmap_count(M) == (size_t)n);
+    test(fhashmap_count(M) <= fhashmap_capacity(M));
+
+    /* Remove every other key, then make sure the remaining ones can still be found past the
+     * tombstones. */
+    for (int i = 0; i < n; i += 2) {
+        rc = fhashmap_remove(M, &i);
+        test(rc == 1);
+    }
+    test(fhashmap_count(M) == (size_t)n / 2);
+
+    for (int i = 0; i < n; ++i) {
+        vp = fhashmap_get(M, &i);
+        if (i % 2) {
+            test(vp && *vp == -i);
+        } else {
+            test(vp == NULL);
+        }
+    }
+
+    /* Churn through many insertions and removals without growing the table. */
+    size_t capacity = fhashmap_capacity(M);
+    for (int i = n; i < 4 * n; ++i) {
+        rc = fhashmap_set(M, &i, &i);
+        test(rc == 1);
+        rc = fhashmap_remove(M, &i);
+        test(rc == 1);
+    }
+    test(fhashmap_capacity(M) == capacity);
+    test(fhashmap_count(M) == (size_t)n / 2);
+
+    rc = fhashmap_reserve(M, 8 * n);
+    test(rc == 0);
+    test(fhashmap_capacity(M) >= (size_t)8 * n);
+    for (int i = 1; i < n; i += 2) {
+        test(fhashmap_has(M, &i) == 1);
+    }
+
+    return 0;
+}
+
+int test_fhashmap_teardown(void)
+{
+    fhashmap_delete(M);
+    return 0;
+}
+
+int test_fhashmap_with_strings(void)
+{
+    M = fhashmap_new(&str_type, &str_type);
+    test(M);
+
+    str *k = str_from_cstr("name");
+    str *v = str_from_cstr("Johann");
+    str *r;
+    rc = fhashmap_set(M, k, v);
+    test(rc == 1);
+    r = fhashmap_get(M, k);
+    test(r);
+    test(str_compare(v, r) == 0);
+
+    for (int i = 0; i < 1000; ++i) {
+        str_make_random(k, 20);
+        rc = fhashmap_set(M, k, v);
+        test(rc >= 0);
+    }
+
+    str_assign_cstr(k, "name");
+    r = fhashmap_get(M, k);
+    test(r);
+    test(str_compare(v, r) == 0);
+
+    str_delete(k);
+    str_delete(v);
+    fhashmap_delete(M);
+    return 0;
+}
+
+int main(void)
+{
+    test_suite_start();
+    run_test(test_fhashmap_new);
+    run_test(test_fhashmap_usage);
+    run_test(test_fhashmap_growth);
+    run_test(test_fhashmap_teardown);
+    run_test(test_fhashmap_with_strings);
+    test_suite_end();
+}
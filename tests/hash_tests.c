@@ -0,0 +1,66 @@
+#include "hash.h"
+#include "test.h"
+#include "test_utils.h"
+
+int test_jenkins_hash(void)
+{
+    const char *s = "Galileo Galilei";
+    test(jenkins_hash(s, strlen(s)) == jenkins_hash(s, strlen(s)));
+    test(jenkins_hash(s, strlen(s)) != jenkins_hash(s, strlen(s) - 1));
+    return 0;
+}
+
+int test_wyhash(void)
+{
+    char buf[128];
+    uint64_t hashes[129];
+
+    for (size_t i = 0; i < sizeof(buf); ++i) buf[i] = rand() % 256;
+
+    /* Every length exercises a different combination of loads; all prefixes should differ. */
+    for (size_t n = 0; n <= sizeof(buf); ++n) {
+        hashes[n] = wyhash(buf, n, hash_seed);
+        test(hashes[n] == wyhash(buf, n, hash_seed));
+        test(hashes[n] != wyhash(buf, n, hash_seed + 1));
+        for (size_t m = 0; m < n; ++m) test(hashes[m] != hashes[n]);
+    }
+
+    /* Flipping a single bit must change the hash. */
+    for (size_t n = 1; n <= sizeof(buf); n += 7) {
+        uint64_t h = wyhash(buf, n, hash_seed);
+        buf[n / 2] ^= 0x10;
+        test(wyhash(buf, n, hash_seed) != h);
+        buf[n / 2] ^= 0x10;
+    }
+
+    return 0;
+}
+
+int test_wyhash_fixed_size(void)
+{
+    for (uint32_t k = 0; k < 1000; ++k) {
+        test(wyhash_u32(k, hash_seed) == wyhash_u32(k, hash_seed));
+        test(wyhash_u32(k, hash_seed) != wyhash_u32(k + 1, hash_seed));
+        test(wyhash_u32(k, hash_seed) != wyhash_u32(k, hash_seed ^ 1));
+        test(wyhash_u64((uint64_t)k << 32, 0) != wyhash_u64((uint64_t)(k + 1) << 32, 0));
+    }
+
+    /* The low bits are used as bucket indices, so they should be spread evenly. */
+    int buckets[16] = { 0 };
+    for (uint32_t k = 0; k < 16000; ++k) {
+        uint64_t h = wyhash_u32(k, hash_seed);
+        ++buckets[hash_fold(h) & 15];
+    }
+    for (int i = 0; i < 16; ++i) test(buckets[i] > 800 && buckets[i] < 1200);
+
+    return 0;
+}
+
+int main(void)
+{
+    test_suite_start();
+    run_test(test_jenkins_hash);
+    run_test(test_wyhash);
+    run_test(test_wyhash_fixed_size);
+    test_suite_end();
+}
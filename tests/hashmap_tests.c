@@ -9,9 +9,23 @@
 static hashmap *M;
 static int rc, k, v;
 
+static size_t hash_calls;
+
+static uint32_t counting_int_hash(const void *i)
+{
+    ++hash_calls;
+    return int_hash(i);
+}
+
+static t_intf counting_int_type = {
+    .size = sizeof(int),
+    .compare = int_compare,
+    .hash = counting_int_hash,
+};
+
 int test_hashmap_new(void)
 {
-    M = hashmap_new(&int_type, &int_type);
+    M = hashmap_new(&int_type, &int_type, 0);
     test(M != NULL);
     test(M->key_type == &int_type);
     test(M->value_type == &int_type);
@@ -67,15 +81,209 @@ int test_hashmap_usage(void)
     return 0;
 }
 
+int test_hashmap_resize(void)
+{
+    int *vp;
+    int n = 10000;
+
+    hashmap_clear(M);
+    test(hashmap_count(M) == 0);
+    test(hashmap_n_buckets(M) == HASHMAP_MIN_BUCKETS);
+
+    for (int i = 0; i < n; ++i) {
+        v = -i;
+        rc = hashmap_set(M, &i, &v);
+        test(rc == 1);
+        test(hashmap_load(M) <= M->max_load);
+    }
+    test(hashmap_count(M) == (size_t)n);
+    test(hashmap_n_buckets(M) >= (size_t)n);
+
+    for (int i = 0; i < n; ++i) {
+        vp = hashmap_get(M, &i);
+        test(vp && *vp == -i);
+    }
+
+    for (int i = 0; i < n - 10; ++i) {
+        rc = hashmap_remove(M, &i);
+        test(rc == 1);
+    }
+    test(hashmap_count(M) == 10);
+    test(hashmap_n_buckets(M) <= 64);
+
+    for (int i = n - 10; i < n; ++i) {
+        test(hashmap_has(M, &i) == 1);
+    }
+
+    rc = hashmap_reserve(M, 1000);
+    test(rc == 0);
+    test(hashmap_n_buckets(M) == 1024);
+
+    rc = hashmap_set_max_load(M, 4.0f);
+    test(rc == 0);
+    rc = hashmap_reserve(M, 1000);
+    test(rc == 0);
+    test(hashmap_n_buckets(M) == 1024);
+
+    hashmap_clear(M);
+    test(hashmap_n_buckets(M) == HASHMAP_MIN_BUCKETS);
+    rc = hashmap_reserve(M, 1000);
+    test(rc == 0);
+    test(hashmap_n_buckets(M) == 256);
+
+    /* Removals don't undo the reservation. */
+    for (int i = 0; i < 1000; ++i) {
+        rc = hashmap_set(M, &i, &i);
+        test(rc == 1);
+    }
+    for (int i = 0; i < 990; ++i) {
+        rc = hashmap_remove(M, &i);
+        test(rc == 1);
+    }
+    test(hashmap_n_buckets(M) == 256);
+
+    return 0;
+}
+
 int test_hashmap_teardown(void)
 {
     hashmap_delete(M);
     return 0;
 }
 
+int test_hashmap_incremental(void)
+{
+    int *vp;
+    int n = 10000;
+    int saw_rehash = 0;
+
+    M = hashmap_new(&int_type, &int_type, HASHMAP_INCREMENTAL);
+    test(M);
+
+    for (int i = 0; i < n; ++i) {
+        v = -i;
+        rc = hashmap_set(M, &i, &v);
+        test(rc == 1);
+        if (hashmap_rehashing(M)) {
+            saw_rehash = 1;
+            /* Entries in both bucket arrays must be reachable. */
+            for (int j = 0; j <= i; j += 97) {
+                test(hashmap_has(M, &j) == 1);
+            }
+        }
+    }
+    test(saw_rehash);
+    test(hashmap_count(M) == (size_t)n);
+
+    for (int i = 0; i < n; ++i) {
+        vp = hashmap_get(M, &i);
+        test(vp && *vp == -i);
+    }
+
+    v = 1;
+    for (int i = 0; i < n; ++i) {
+        rc = hashmap_set(M, &i, &v);
+        test(rc == 0);
+    }
+    test(hashmap_count(M) == (size_t)n);
+
+    for (int i = 0; i < n - 10; ++i) {
+        rc = hashmap_remove(M, &i);
+        test(rc == 1);
+        test(hashmap_has(M, &i) == 0);
+    }
+    test(hashmap_count(M) == 10);
+    for (int i = n - 10; i < n; ++i) {
+        vp = hashmap_get(M, &i);
+        test(vp && *vp == 1);
+    }
+
+    hashmap_clear(M);
+    test(!hashmap_rehashing(M));
+    test(hashmap_count(M) == 0);
+
+    for (int i = 0; i < 100; ++i) {
+        rc = hashmap_set(M, &i, &i);
+        test(rc == 1);
+    }
+    hashmap_delete(M);
+    return 0;
+}
+
+int test_hashmap_incremental_small_load(void)
+{
+    int n = 50000;
+    size_t n_buckets;
+    int was_rehashing, resizes = 0;
+
+    /* With a small maximum load the next resize comes sooner, but a migration must still be
+     * finished by then instead of being forced through in one go. */
+    M = hashmap_new(&int_type, &int_type, HASHMAP_INCREMENTAL);
+    test(M);
+    rc = hashmap_set_max_load(M, 0.1f);
+    test(rc == 0);
+
+    for (int i = 0; i < n; ++i) {
+        was_rehashing = hashmap_rehashing(M);
+        n_buckets = hashmap_n_buckets(M);
+        rc = hashmap_set(M, &i, &i);
+        test(rc == 1);
+        if (hashmap_n_buckets(M) != n_buckets) {
+            test(!was_rehashing);
+            ++resizes;
+        }
+    }
+    /* Shrinking a tiny table can't be spread over anything, so keep some entries. */
+    for (int i = 0; i < n - 100; ++i) {
+        was_rehashing = hashmap_rehashing(M);
+        n_buckets = hashmap_n_buckets(M);
+        rc = hashmap_remove(M, &i);
+        test(rc == 1);
+        if (hashmap_n_buckets(M) != n_buckets) {
+            test(!was_rehashing);
+            ++resizes;
+        }
+    }
+    test(resizes > 16);
+    test(hashmap_count(M) == 100);
+
+    hashmap_delete(M);
+    return 0;
+}
+
+int test_hashmap_cached_hash(void)
+{
+    int n = 5000;
+
+    for (uint8_t flags = 0; flags <= HASHMAP_INCREMENTAL; ++flags) {
+        M = hashmap_new(&counting_int_type, &int_type, flags);
+        test(M);
+
+        /* Growing and shrinking must reuse the hashes stored in the nodes. */
+        hash_calls = 0;
+        for (int i = 0; i < n; ++i) {
+            rc = hashmap_set(M, &i, &i);
+            test(rc == 1);
+        }
+        test(hash_calls == (size_t)n);
+
+        hash_calls = 0;
+        for (int i = 0; i < n; ++i) {
+            rc = hashmap_remove(M, &i);
+            test(rc == 1);
+        }
+        test(hash_calls == (size_t)n);
+        test(hashmap_n_buckets(M) < 64);
+
+        hashmap_delete(M);
+    }
+
+    return 0;
+}
+
 int test_hashmap_with_strings(void)
 {
-    M = hashmap_new(&str_type, &str_type);
+    M = hashmap_new(&str_type, &str_type, 0);
     test(M);
 
     str *k = str_from_cstr("name");
@@ -98,7 +306,11 @@ int main(void)
     test_suite_start();
     run_test(test_hashmap_new);
     run_test(test_hashmap_usage);
+    run_test(test_hashmap_resize);
     run_test(test_hashmap_teardown);
+    run_test(test_hashmap_incremental);
+    run_test(test_hashmap_incremental_small_load);
+    run_test(test_hashmap_cached_hash);
     run_test(test_hashmap_with_strings);
     test_suite_end();
 }
@@ -0,0 +1,69 @@
+#include <stdint.h>
+
+#include "pool.h"
+#include "test.h"
+
+#define NSLOTS 10000
+
+static pool P;
+static void *slots[NSLOTS];
+
+int test_pool_initialize(void)
+{
+    int rc = pool_initialize(&P, 3, NULL);
+    test(rc == 0);
+    test(P.slot_size == POOL_ALIGNMENT);
+    test(P.chunks == NULL);
+    pool_destroy(&P);
+
+    rc = pool_initialize(&P, 40, NULL);
+    test(rc == 0);
+    test(P.slot_size == 48);
+
+    return 0;
+}
+
+int test_pool_alloc_free(void)
+{
+    for (size_t i = 0; i < NSLOTS; ++i) {
+        slots[i] = pool_alloc(&P);
+        test(slots[i] != NULL);
+        test((uintptr_t)slots[i] % POOL_ALIGNMENT == 0);
+        for (size_t j = 0; j < P.slot_size; ++j) test(((char*)slots[i])[j] == 0);
+        memset(slots[i], 0xff, P.slot_size);
+    }
+
+    /* Released slots are reused before any new memory is requested, and come back zeroed. */
+    pool_chunk *chunks = P.chunks;
+    for (size_t i = 0; i < NSLOTS; i += 2) pool_free(&P, slots[i]);
+    for (size_t i = 0; i < NSLOTS; i += 2) {
+        slots[i] = pool_alloc(&P);
+        test(slots[i] != NULL);
+        test(((char*)slots[i])[0] == 0 && ((char*)slots[i])[P.slot_size - 1] == 0);
+    }
+    test(P.chunks == chunks);
+
+    return 0;
+}
+
+int test_pool_clear(void)
+{
+    pool_clear(&P);
+    test(P.chunks == NULL);
+    test(P.free_list == NULL);
+
+    void *s = pool_alloc(&P);
+    test(s != NULL);
+
+    pool_destroy(&P);
+    return 0;
+}
+
+int main(void)
+{
+    test_suite_start();
+    run_test(test_pool_initialize);
+    run_test(test_pool_alloc_free);
+    run_test(test_pool_clear);
+    test_suite_end();
+}
@@ -1,8 +1,10 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "log.h"
 #include "priority_queue.h"
+#include "str.h"
 #include "test_utils.h"
 #include "test.h"
 #include "type_interface.h"
@@ -49,11 +51,105 @@ int test_pqueue(void)
     return 0;
 }
 
+int test_pqueue_push_pop(void)
+{
+    int rc, out;
+    pqueue Q;
+    rc = pqueue_initialize(&Q, &int_type);
+    test(rc == 0);
+
+    /* Empty queue: push_pop hands back the input, replace_top does nothing. */
+    int x = 5;
+    rc = pqueue_push_pop(&Q, &x, &out);
+    test(rc == 1 && out == 5 && pqueue_empty(&Q));
+    rc = pqueue_replace_top(&Q, &x, &out);
+    test(rc == 0 && pqueue_empty(&Q));
+
+    for (int i = 0; i < NMEMB; ++i) {
+        x = (int)(((unsigned)i * 7919u) % NMEMB);
+        rc = pqueue_enqueue(&Q, &x);
+        test(rc == 1);
+    }
+    test(*(int*)pqueue_top(&Q) == NMEMB - 1);
+
+    /* Greater than everything: comes straight back out. */
+    x = NMEMB;
+    rc = pqueue_push_pop(&Q, &x, &out);
+    test(rc == 1 && out == NMEMB);
+    test(pqueue_count(&Q) == NMEMB);
+
+    /* Otherwise the top comes out and x stays. */
+    x = -1;
+    rc = pqueue_push_pop(&Q, &x, &out);
+    test(rc == 1 && out == NMEMB - 1);
+    rc = pqueue_replace_top(&Q, &x, &out);
+    test(rc == 1 && out == NMEMB - 2);
+    test(pqueue_count(&Q) == NMEMB);
+
+    int last = NMEMB;
+    while (!pqueue_empty(&Q)) {
+        rc = pqueue_dequeue(&Q, &out);
+        test(rc == 1);
+        test(out <= last);
+        last = out;
+    }
+    test(last == -1);
+
+    /* in and out may be the same object. */
+    for (x = 1; x <= 3; ++x) pqueue_enqueue(&Q, &x);
+    x = 0;
+    rc = pqueue_push_pop(&Q, &x, &x);
+    test(rc == 1 && x == 3);
+    x = 4;
+    rc = pqueue_push_pop(&Q, &x, &x);
+    test(rc == 1 && x == 4);
+    for (int i = 2; i >= 0; --i) {
+        rc = pqueue_dequeue(&Q, &out);
+        test(rc == 1 && out == i);
+    }
+    for (x = 1; x <= 3; ++x) pqueue_enqueue(&Q, &x);
+    x = 5;
+    rc = pqueue_replace_top(&Q, &x, &x);
+    test(rc == 1 && x == 3);
+    test(*(int*)pqueue_top(&Q) == 5);
+    pqueue_clear(&Q);
+
+    pqueue_destroy(&Q);
+    test(Q.temp == NULL);
+
+    /* The same with a type that owns memory: nothing may leak or be freed twice. */
+    pqueue *S = pqueue_new(&str_type);
+    test(S);
+    const char *words[] = { "apple", "banana", "cherry" };
+    for (int i = 0; i < 3; ++i) {
+        str *w = str_from_cstr(words[i]);
+        test(w);
+        rc = pqueue_enqueue(S, w);
+        test(rc == 1);
+        str_delete(w);
+    }
+    const char *long_word = "zucchini, in a string of more than thirty characters";
+    str *s = str_from_cstr(long_word);
+    test(s);
+    rc = pqueue_replace_top(S, s, s);
+    test(rc == 1 && strcmp(str_data(s), "cherry") == 0);
+    test(strcmp(str_data((str*)pqueue_top(S)), long_word) == 0);
+    rc = pqueue_push_pop(S, s, s);
+    test(rc == 1 && strcmp(str_data(s), long_word) == 0);
+    test(strcmp(str_data((str*)pqueue_top(S)), "cherry") == 0);
+    test(pqueue_count(S) == 3);
+    str_delete(s);
+    pqueue_delete(S);
+
+    return 0;
+}
+
 int main(void)
 {
     srand(1);
 
     test_suite_start();
     run_test(test_pqueue);
+    run_test(test_pqueue_push_pop);
     test_suite_end();
 }
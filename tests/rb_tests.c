@@ -41,6 +41,8 @@ int test_rb_copy(void)
     n->left = l;
     n->right = r;
     r->left = rl;
+    r->count = 2;
+    n->count = 4;
 
     /* copy and verify */
     bst *C = bst_copy(T);
@@ -146,6 +146,95 @@ int test_set_difference(void)
     return 0;
 }
 
+int test_set_operations_random(void)
+{
+    uint8_t flavors[] = { NONE, RB, AVL };
+    char in1[4 * NMEMB], in2[4 * NMEMB];
+
+    for (size_t f = 0; f < sizeof(flavors); ++f) {
+        /* The sizes cover empty sets and all shapes of small red-black trees. */
+        for (int n = 0; n < 40; ++n) {
+            bst *S1 = bst_new(flavors[f], &int_type, NULL);
+            bst *S2 = bst_new(flavors[f], &int_type, NULL);
+            int m = n < 20 ? n : 4 * NMEMB;
+            memset(in1, 0, sizeof(in1));
+            memset(in2, 0, sizeof(in2));
+
+            for (int i = 0; i < m; ++i) {
+                int v = rand() % (4 * NMEMB);
+                set_insert(S1, &v);
+                in1[v] = 1;
+                v = rand() % (4 * NMEMB);
+                set_insert(S2, &v);
+                in2[v] = 1;
+            }
+
+            set *U = set_union(S1, S2);
+            set *I = set_intersection(S1, S2);
+            set *D = set_difference(S1, S2);
+            test(U && I && D);
+            test(U->flavor == flavors[f]);
+            test(bst_invariant(U, NULL) == 0);
+            test(bst_invariant(I, NULL) == 0);
+            test(bst_invariant(D, NULL) == 0);
+
+            size_t nu = 0, ni = 0, nd = 0;
+            for (int v = 0; v < 4 * NMEMB; ++v) {
+                test(bst_has(U, &v) == (in1[v] || in2[v]));
+                test(bst_has(I, &v) == (in1[v] && in2[v]));
+                test(bst_has(D, &v) == (in1[v] && !in2[v]));
+                nu += in1[v] || in2[v];
+                ni += in1[v] && in2[v];
+                nd += in1[v] && !in2[v];
+            }
+            test(set_count(U) == nu && set_count(I) == ni && set_count(D) == nd);
+
+            /* The results are ordinary trees that can be modified. */
+            for (int v = 0; v < 4 * NMEMB; v += 3) {
+                test(set_remove(U, &v) == (in1[v] || in2[v]));
+            }
+            test(bst_invariant(U, NULL) == 0);
+
+            bst_delete(U);
+            bst_delete(I);
+            bst_delete(D);
+            bst_delete(S1);
+            bst_delete(S2);
+        }
+    }
+
+    return 0;
+}
+
+int test_set_operations_allocator(void)
+{
+    arena A;
+    set S1, S2;
+    rc = arena_initialize(&A, 0);
+    test(rc == 0);
+    rc = set_initialize_with(&S1, &int_type, arena_allocator(&A));
+    test(rc == 0);
+    rc = set_initialize_with(&S2, &int_type, arena_allocator(&A));
+    test(rc == 0);
+
+    for (int i = 0; i < NMEMB; ++i) {
+        set_insert(&S1, &i);
+        int v = i + NMEMB / 2;
+        set_insert(&S2, &v);
+    }
+
+    /* The result uses the allocator of the first operand. */
+    set *U = set_union(&S1, &S2);
+    test(U && set_count(U) == NMEMB + NMEMB / 2);
+    test(U->node_pool.alloc == arena_allocator(&A));
+
+    bst_delete(U);
+    bst_destroy(&S1);
+    bst_destroy(&S2);
+    arena_destroy(&A);
+    return 0;
+}
+
 int main(void)
 {
     test_suite_start();
@@ -161,6 +250,8 @@ int main(void)
     run_test(test_set_union);
     run_test(test_set_intersection);
     run_test(test_set_difference);
+    run_test(test_set_operations_random);
+    run_test(test_set_operations_allocator);
 
     test_suite_end();
 }
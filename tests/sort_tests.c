@@ -1,5 +1,8 @@
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "log.h"
 #include "sort.h"
@@ -40,6 +43,116 @@ int test_quicksort(void)
     return 0;
 }
 
+/* McIlroy's adversary ("A Killer Adversary for Quicksort", 1999): values are assigned lazily
+ * while the sort runs, always in the way that makes the current pivot candidate as bad as
+ * possible. Plain quicksort needs a quadratic number of comparisons on the resulting input. */
+static int killer_val[N_ELEMENTS];
+static int killer_gas, killer_nsolid, killer_candidate;
+static size_t n_comparisons;
+
+static int killer_compare(const void *a, const void *b)
+{
+    int x = *(int*)a, y = *(int*)b;
+    ++n_comparisons;
+    if (killer_val[x] == killer_gas && killer_val[y] == killer_gas) {
+        if (x == killer_candidate) killer_val[x] = killer_nsolid++;
+        else killer_val[y] = killer_nsolid++;
+    }
+    if (killer_val[x] == killer_gas) killer_candidate = x;
+    else if (killer_val[y] == killer_gas) killer_candidate = y;
+    return killer_val[x] - killer_val[y];
+}
+
+static int counting_compare(const void *a, const void *b)
+{
+    ++n_comparisons;
+    return int_compare(a, b);
+}
+
+int test_quicksort_worst_case(void)
+{
+    killer_gas = N_ELEMENTS;
+    killer_nsolid = 0;
+    killer_candidate = 0;
+    for (int i = 0; i < N_ELEMENTS; ++i) {
+        A[i] = i;
+        killer_val[i] = killer_gas;
+    }
+
+    n_comparisons = 0;
+    quicksort(A, N_ELEMENTS, sizeof(*A), killer_compare);
+
+    /* Well within O(n log n): 4 * n * log2(n), compared to n^2 / 2. */
+    test(n_comparisons < 4 * N_ELEMENTS * 10);
+    test(is_sorted(A, N_ELEMENTS, sizeof(*A), killer_compare));
+
+    make_sorted(A, N_ELEMENTS);
+    quicksort(A, N_ELEMENTS, sizeof(*A), int_compare);
+    test(is_sorted(A, N_ELEMENTS, sizeof(*A), int_compare));
+
+    make_equal(A, N_ELEMENTS, 7);
+    quicksort(A, N_ELEMENTS, sizeof(*A), int_compare);
+    test(is_sorted(A, N_ELEMENTS, sizeof(*A), int_compare));
+
+    return 0;
+}
+
+int test_pdqsort(void)
+{
+    for (int i = 0; i < N_RUNS; ++i) {
+        make_random(A, N_ELEMENTS, MAX_VALUE);
+        pdqsort(A, N_ELEMENTS, sizeof(*A), int_compare);
+        test(is_sorted(A, N_ELEMENTS, sizeof(*A), int_compare));
+    }
+
+    /* Sorted, reverse sorted and constant input are recognized and sorted in linear time. */
+    n_comparisons = 0;
+    pdqsort(A, N_ELEMENTS, sizeof(*A), counting_compare);
+    test(is_sorted(A, N_ELEMENTS, sizeof(*A), int_compare));
+    test(n_comparisons < N_ELEMENTS);
+
+    for (int i = 0; i < N_ELEMENTS; ++i) A[i] = N_ELEMENTS - i;
+    n_comparisons = 0;
+    pdqsort(A, N_ELEMENTS, sizeof(*A), counting_compare);
+    test(is_sorted(A, N_ELEMENTS, sizeof(*A), int_compare));
+    test(n_comparisons < N_ELEMENTS);
+
+    /* Few distinct values. */
+    for (int i = 0; i < N_ELEMENTS; ++i) A[i] = rand() % 3;
+    n_comparisons = 0;
+    pdqsort(A, N_ELEMENTS, sizeof(*A), counting_compare);
+    test(is_sorted(A, N_ELEMENTS, sizeof(*A), int_compare));
+    test(n_comparisons < 4 * N_ELEMENTS);
+
+    /* Organ pipe and sawtooth patterns, and small sizes. */
+    for (int i = 0; i < N_ELEMENTS; ++i) A[i] = i < N_ELEMENTS / 2 ? i : N_ELEMENTS - i;
+    pdqsort(A, N_ELEMENTS, sizeof(*A), int_compare);
+    test(is_sorted(A, N_ELEMENTS, sizeof(*A), int_compare));
+    for (int i = 0; i < N_ELEMENTS; ++i) A[i] = i % 37;
+    pdqsort(A, N_ELEMENTS, sizeof(*A), int_compare);
+    test(is_sorted(A, N_ELEMENTS, sizeof(*A), int_compare));
+    for (size_t n = 0; n < 200; ++n) {
+        make_random(A, n, MAX_VALUE);
+        pdqsort(A, n, sizeof(*A), int_compare);
+        test(n == 0 || is_sorted(A, n, sizeof(*A), int_compare));
+    }
+
+    /* The quicksort adversary. */
+    killer_gas = N_ELEMENTS;
+    killer_nsolid = 0;
+    killer_candidate = 0;
+    for (int i = 0; i < N_ELEMENTS; ++i) {
+        A[i] = i;
+        killer_val[i] = killer_gas;
+    }
+    n_comparisons = 0;
+    pdqsort(A, N_ELEMENTS, sizeof(*A), killer_compare);
+    test(n_comparisons < 4 * N_ELEMENTS * 10);
+    test(is_sorted(A, N_ELEMENTS, sizeof(*A), killer_compare));
+
+    return 0;
+}
+
 int test_mergesort(void)
 {
     for (int i = 0; i < N_RUNS; ++i) {
@@ -52,6 +165,45 @@ int test_mergesort(void)
     return 0;
 }
 
+int test_timsort(void)
+{
+    size_t n = 100000;
+    struct pair { int key; int index; } *P = malloc(n * sizeof(*P));
+    test(P);
+
+    /* Nearly sorted input takes close to n comparisons. */
+    for (size_t i = 0; i < n; ++i) {
+        P[i].key = (int)i;
+        P[i].index = (int)i;
+    }
+    for (int i = 0; i < 10; ++i) P[rand() % n].key = rand() % (int)n;
+    n_comparisons = 0;
+    timsort(P, n, sizeof(*P), counting_compare);
+    test(n_comparisons < 2 * n);
+    test(is_sorted(P, n, sizeof(*P), int_compare));
+
+    /* Reverse sorted input is one run. */
+    for (size_t i = 0; i < n; ++i) P[i].key = (int)(n - i);
+    n_comparisons = 0;
+    timsort(P, n, sizeof(*P), counting_compare);
+    test(n_comparisons < n);
+    test(is_sorted(P, n, sizeof(*P), int_compare));
+
+    /* Stability on random input with many duplicates. */
+    for (size_t i = 0; i < n; ++i) {
+        P[i].key = rand() % 100;
+        P[i].index = (int)i;
+    }
+    timsort(P, n, sizeof(*P), int_compare);
+    for (size_t i = 1; i < n; ++i) {
+        test(P[i - 1].key < P[i].key ||
+             (P[i - 1].key == P[i].key && P[i - 1].index < P[i].index));
+    }
+
+    free(P);
+    return 0;
+}
+
 int test_heapsort(void)
 {
     for (int i = 0; i < N_RUNS; ++i) {
@@ -64,13 +216,448 @@ int test_heapsort(void)
     return 0;
 }
 
+/* Elements of all specialized sizes and a large one that is sorted indirectly. */
+#define define_sized_test(T) \
+    static int T##_compare(const void *a, const void *b) \
+    { \
+        return int_compare(&((T*)a)->key, &((T*)b)->key); \
+    }
+
+typedef struct { char key; } s1;
+typedef struct { short key; } s2;
+typedef struct { int key; } s4;
+typedef struct { int key; int index; } s8;
+typedef struct { int key; int index; int64_t pad; } s16;
+typedef struct { int key; int index; char pad[200]; } s_large;
+
+static int s1_compare(const void *a, const void *b) { return *(char*)a - *(char*)b; }
+static int s2_compare(const void *a, const void *b) { return *(short*)a - *(short*)b; }
+define_sized_test(s4)
+define_sized_test(s8)
+define_sized_test(s16)
+define_sized_test(s_large)
+
+#define check_sorts(T, n) do { \
+    T *X = malloc((n) * sizeof(T)); \
+    test(X); \
+    sort_f sorts[] = { quicksort, pdqsort, mergesort, timsort, heapsort }; \
+    for (size_t s = 0; s < sizeof(sorts) / sizeof(*sorts); ++s) { \
+        for (size_t i = 0; i < (n); ++i) { \
+            memset(&X[i], 0, sizeof(T)); \
+            X[i].key = rand() % 100; \
+        } \
+        sorts[s](X, (n), sizeof(T), T##_compare); \
+        test(is_sorted(X, (n), sizeof(T), T##_compare)); \
+    } \
+    free(X); \
+} while (0)
+
+int test_element_sizes(void)
+{
+    check_sorts(s1, 1000);
+    check_sorts(s2, 1000);
+    check_sorts(s4, 1000);
+    check_sorts(s8, 1000);
+    check_sorts(s16, 1000);
+    check_sorts(s_large, 1000);
+
+    /* Indirect sorting keeps mergesort stable and moves the whole elements. */
+    s_large *L = malloc(1000 * sizeof(*L));
+    test(L);
+    for (int i = 0; i < 1000; ++i) {
+        L[i].key = rand() % 10;
+        L[i].index = i;
+        memset(L[i].pad, i % 128, sizeof(L[i].pad));
+    }
+    mergesort(L, 1000, sizeof(*L), s_large_compare);
+    for (int i = 0; i < 1000; ++i) {
+        test(L[i].pad[199] == L[i].index % 128);
+        if (i > 0) {
+            test(L[i - 1].key < L[i].key ||
+                 (L[i - 1].key == L[i].key && L[i - 1].index < L[i].index));
+        }
+    }
+    free(L);
+
+    return 0;
+}
+
+int test_parallel_sorts(void)
+{
+    size_t n = 4 * PARALLEL_SORT_CUTOFF + 123;
+    int *B = malloc(n * sizeof(*B));
+    int *C = malloc(n * sizeof(*C));
+    test(B && C);
+
+    /* Same result as the sequential versions, for any number of threads. */
+    for (unsigned n_threads = 0; n_threads <= 5; ++n_threads) {
+        make_random(B, n, 1000);
+        memcpy(C, B, n * sizeof(*B));
+        test(parallel_sort(B, n, sizeof(*B), int_compare, n_threads) == 0);
+        quicksort(C, n, sizeof(*C), int_compare);
+        test(memcmp(B, C, n * sizeof(*B)) == 0);
+
+        make_random(B, n, 1000);
+        memcpy(C, B, n * sizeof(*B));
+        test(parallel_stable_sort(B, n, sizeof(*B), int_compare, n_threads) == 0);
+        mergesort(C, n, sizeof(*C), int_compare);
+        test(memcmp(B, C, n * sizeof(*B)) == 0);
+    }
+
+    /* Stability: sort pairs by their first half only. */
+    struct pair { int key; int index; } *P = malloc(n * sizeof(*P));
+    test(P);
+    for (size_t i = 0; i < n; ++i) {
+        P[i].key = rand() % 100;
+        P[i].index = (int)i;
+    }
+    test(parallel_stable_sort(P, n, sizeof(*P), int_compare, 4) == 0);
+    for (size_t i = 1; i < n; ++i) {
+        test(P[i - 1].key < P[i].key ||
+             (P[i - 1].key == P[i].key && P[i - 1].index < P[i].index));
+    }
+
+    free(P);
+    free(B);
+    free(C);
+    return 0;
+}
+
+struct record {
+    uint64_t key;
+    int index;
+};
+
+static uint64_t record_key(const void *r)
+{
+    return ((struct record*)r)->key;
+}
+
+int test_radixsort(void)
+{
+    size_t n = 10000;
+    int *I = malloc(n * sizeof(*I));
+    uint64_t *U = malloc(n * sizeof(*U));
+    float *F = malloc(n * sizeof(*F));
+    struct record *R = malloc(n * sizeof(*R));
+    test(I && U && F && R);
+
+    for (size_t i = 0; i < n; ++i) I[i] = rand() - RAND_MAX / 2;
+    test(radixsort_int(I, n) == 0);
+    test(is_sorted(I, n, sizeof(*I), int_compare));
+
+    /* Small values: most passes are skipped. */
+    make_random(I, n, 100);
+    test(radixsort_int(I, n) == 0);
+    test(is_sorted(I, n, sizeof(*I), int_compare));
+
+    for (size_t i = 0; i < n; ++i) U[i] = ((uint64_t)rand() << 40) ^ (uint64_t)rand();
+    test(radixsort_u64(U, n) == 0);
+    for (size_t i = 1; i < n; ++i) test(U[i - 1] <= U[i]);
+
+    for (size_t i = 0; i < n; ++i) F[i] = (float)(rand() - RAND_MAX / 2) / 1000.0f;
+    F[0] = -0.0f;
+    F[1] = 0.0f;
+    test(radixsort_float(F, n) == 0);
+    for (size_t i = 1; i < n; ++i) test(F[i - 1] <= F[i]);
+
+    /* The MSD sort is stable. */
+    for (size_t i = 0; i < n; ++i) {
+        R[i].key = (uint64_t)(rand() % 1000) << (i % 2 ? 50 : 3);
+        R[i].index = (int)i;
+    }
+    test(radixsort_by_key(R, n, sizeof(*R), record_key) == 0);
+    for (size_t i = 1; i < n; ++i) {
+        test(R[i - 1].key < R[i].key ||
+             (R[i - 1].key == R[i].key && R[i - 1].index < R[i].index));
+    }
+
+    free(I);
+    free(U);
+    free(F);
+    free(R);
+    return 0;
+}
+
+static int u32_compare(const void *a, const void *b)
+{
+    uint32_t x = *(uint32_t*)a, y = *(uint32_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Whether the floats in A are a permutation of those in B, bit for bit: sort the bit patterns of
+ * both and compare them. Clobbers B. */
+static int is_permutation_f(const float *A, float *B, size_t n)
+{
+    if (n == 0) return 1;
+    uint32_t *C = malloc(n * sizeof(*C));
+    if (!C) return 0;
+    memcpy(C, A, n * sizeof(*C));
+    qsort(C, n, sizeof(*C), u32_compare);
+    qsort(B, n, sizeof(*C), u32_compare);
+    int rc = memcmp(C, B, n * sizeof(*C)) == 0;
+    free(C);
+    return rc;
+}
+
+int test_sortnet(void)
+{
+    size_t n = 10000;
+    int32_t *I = malloc(n * sizeof(*I));
+    int64_t *L = malloc(n * sizeof(*L));
+    float *F = malloc(n * sizeof(*F));
+    float *G = malloc(n * sizeof(*G));
+    test(I && L && F && G);
+
+    /* The networks on their own, for every size they handle. -0.0 and 0.0 compare equal but must
+     * both survive. */
+    for (size_t m = 0; m <= SORTNET_MAX; ++m) {
+        for (int run = 0; run < 10; ++run) {
+            for (size_t i = 0; i < m; ++i) {
+                I[i] = rand() % 20 - 10;
+                L[i] = ((int64_t)rand() << 32) - ((int64_t)rand() << 20);
+                F[i] = rand() % 4 == 0 ? (rand() % 2 ? -0.0f : 0.0f)
+                                       : (float)(rand() % 100) / 8.0f - 6.0f;
+            }
+            if (m > 0) I[0] = INT32_MAX;
+            if (m > 1) L[1] = INT64_MIN;
+            memcpy(G, F, m * sizeof(*G));
+            sortnet_i32(I, m);
+            sortnet_i64(L, m);
+            sortnet_float(F, m);
+            for (size_t i = 1; i < m; ++i) {
+                test(I[i - 1] <= I[i]);
+                test(L[i - 1] <= L[i]);
+                test(F[i - 1] <= F[i]);
+            }
+            test(is_permutation_f(F, G, m));
+        }
+    }
+
+    /* Longer arrays go to the quicksorts. */
+    for (size_t i = 0; i < 1000; ++i) I[i] = rand() % 1000;
+    sortnet_i32(I, 1000);
+    for (size_t i = 1; i < 1000; ++i) test(I[i - 1] <= I[i]);
+
+    /* The quicksorts that use them. */
+    for (size_t i = 0; i < n; ++i) {
+        I[i] = rand() - RAND_MAX / 2;
+        L[i] = (int64_t)rand() * rand() - RAND_MAX;
+        F[i] = (float)(rand() - RAND_MAX / 2) / 1000.0f;
+    }
+    quicksort_i32(I, n);
+    quicksort_i64(L, n);
+    memcpy(G, F, n * sizeof(*G));
+    quicksort_float(F, n);
+    for (size_t i = 1; i < n; ++i) {
+        test(I[i - 1] <= I[i]);
+        test(L[i - 1] <= L[i]);
+        test(F[i - 1] <= F[i]);
+    }
+    test(is_permutation_f(F, G, n));
+
+    /* Few distinct values, and NaNs go to the end. */
+    for (size_t i = 0; i < n; ++i) {
+        I[i] = rand() % 3;
+        F[i] = i % 100 == 0 ? NAN : (float)(rand() % 3);
+    }
+    quicksort_i32(I, n);
+    quicksort_float(F, n);
+    for (size_t i = 1; i < n; ++i) test(I[i - 1] <= I[i]);
+    for (size_t i = 1; i < n - n / 100; ++i) test(F[i - 1] <= F[i]);
+    for (size_t i = n - n / 100; i < n; ++i) test(isnan(F[i]));
+
+    free(I);
+    free(L);
+    free(F);
+    free(G);
+    return 0;
+}
+
+int test_selection(void)
+{
+    size_t n = 10000;
+    int *B = malloc(n * sizeof(*B));
+    int *S = malloc(n * sizeof(*S));
+    test(B && S);
+
+    for (size_t i = 0; i < n; ++i) S[i] = rand() % 1000;
+    memcpy(B, S, n * sizeof(*B));
+    quicksort(S, n, sizeof(*S), int_compare);
+
+    /* nth_element, including the adversarial input that forces heap selection. */
+    size_t indices[] = { 0, 1, n / 2, n - 2, n - 1 };
+    for (size_t t = 0; t < sizeof(indices) / sizeof(*indices); ++t) {
+        size_t k = indices[t];
+        for (size_t i = 0; i < n; ++i) B[i] = S[(i * 7919) % n];
+        nth_element(B, n, sizeof(*B), int_compare, k);
+        test(B[k] == S[k]);
+        for (size_t i = 0; i < k; ++i) test(B[i] <= B[k]);
+        for (size_t i = k + 1; i < n; ++i) test(B[i] >= B[k]);
+    }
+    killer_gas = N_ELEMENTS;
+    killer_nsolid = 0;
+    killer_candidate = 0;
+    for (int i = 0; i < N_ELEMENTS; ++i) {
+        A[i] = i;
+        killer_val[i] = killer_gas;
+    }
+    n_comparisons = 0;
+    nth_element(A, N_ELEMENTS, sizeof(*A), killer_compare, N_ELEMENTS / 2);
+    test(n_comparisons < 32 * N_ELEMENTS);
+
+    /* partial_sort */
+    for (size_t i = 0; i < n; ++i) B[i] = S[(i * 7919) % n];
+    partial_sort(B, n, sizeof(*B), int_compare, 100);
+    test(memcmp(B, S, 100 * sizeof(*B)) == 0);
+    partial_sort(B, 10, sizeof(*B), int_compare, 20);
+    test(is_sorted(B, 10, sizeof(*B), int_compare));
+
+    /* topk */
+    topk T;
+    test(topk_initialize(&T, 100, sizeof(int), int_compare) == 0);
+    int out[100];
+    test(topk_push(&T, &S[n - 1]) == 1);
+    test(topk_extract(&T, out) == 1 && out[0] == S[n - 1]);
+    for (size_t i = 0; i < n; ++i) {
+        int x = S[(i * 7919) % n];
+        test(topk_push(&T, &x) >= 0);
+    }
+    test(T.count == 100);
+    test(topk_extract(&T, out) == 100);
+    test(memcmp(out, S, 100 * sizeof(*out)) == 0);
+    test(topk_push(&T, &S[n - 1]) == 0);
+    topk_destroy(&T);
+    test(T.data == NULL);
+
+    free(B);
+    free(S);
+    return 0;
+}
+
+struct pair {
+    uint32_t key;
+    uint32_t index;
+};
+
+static int pair_compare(const void *a, const void *b)
+{
+    uint32_t x = ((struct pair*)a)->key, y = ((struct pair*)b)->key;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+struct pair_check {
+    struct pair last;
+    size_t count;
+    uint64_t index_sum;
+    int ordered;
+};
+
+static int pair_check(const void *record, void *data)
+{
+    const struct pair *p = record;
+    struct pair_check *C = data;
+    if (C->count > 0 && pair_compare(&C->last, p) > 0) C->ordered = 0;
+    C->last = *p;
+    C->index_sum += p->index;
+    ++C->count;
+    return 0;
+}
+
+/* Write n random pairs to a temporary file and rewind it. */
+static FILE *make_pair_file(size_t n)
+{
+    FILE *f = tmpfile();
+    if (!f) return NULL;
+    for (size_t i = 0; i < n; ++i) {
+        struct pair p = { .key = (uint32_t)rand() % 5000, .index = (uint32_t)i };
+        fwrite(&p, sizeof(p), 1, f);
+    }
+    fflush(f);
+    lseek(fileno(f), 0, SEEK_SET);
+    return f;
+}
+
+int test_external_sort(void)
+{
+    size_t n = 100000;
+    uint64_t index_sum = (uint64_t)n * (n - 1) / 2;
+
+    /* In memory, a single merge of two runs, and several merge passes of two runs at a time over
+     * 13 and 782 runs. */
+    size_t budgets[] = { 1024 * 1024, 512 * 1024, 64 * 1024, 1024 };
+    for (size_t b = 0; b < sizeof(budgets) / sizeof(*budgets); ++b) {
+        FILE *in = make_pair_file(n);
+        test(in);
+        struct pair_check C = { .ordered = 1 };
+        test(external_sort_to(fileno(in), sizeof(struct pair), pair_compare, budgets[b],
+                              pair_check, &C) == 0);
+        test(C.ordered && C.count == n && C.index_sum == index_sum);
+        fclose(in);
+    }
+
+    /* To a file descriptor. */
+    FILE *in = make_pair_file(n), *out = tmpfile();
+    test(in && out);
+    test(external_sort(fileno(in), fileno(out), sizeof(struct pair), pair_compare, 8192) == 0);
+    lseek(fileno(out), 0, SEEK_SET);
+    struct pair_check C = { .ordered = 1 };
+    struct pair p;
+    while (read(fileno(out), &p, sizeof(p)) == sizeof(p)) pair_check(&p, &C);
+    test(C.ordered && C.count == n && C.index_sum == index_sum);
+    fclose(in);
+    fclose(out);
+
+    /* Runs go to $TMPDIR. */
+    char *tmpdir = getenv("TMPDIR");
+    if (tmpdir) tmpdir = strdup(tmpdir);
+    setenv("TMPDIR", "/nonexistent", 1);
+    in = make_pair_file(n);
+    test(in);
+    test(external_sort_to(fileno(in), sizeof(struct pair), pair_compare, 8192,
+                          pair_check, &C) == -1);
+    fclose(in);
+    if (tmpdir) {
+        setenv("TMPDIR", tmpdir, 1);
+        free(tmpdir);
+    } else {
+        unsetenv("TMPDIR");
+    }
+
+    /* Empty input, a partial record at the end, and a budget too small. */
+    in = tmpfile();
+    test(in);
+    C = (struct pair_check){ .ordered = 1 };
+    test(external_sort_to(fileno(in), sizeof(struct pair), pair_compare, 1024,
+                          pair_check, &C) == 0);
+    test(C.count == 0);
+    test(write(fileno(in), "abc", 3) == 3);
+    lseek(fileno(in), 0, SEEK_SET);
+    test(external_sort_to(fileno(in), sizeof(struct pair), pair_compare, 1024,
+                          pair_check, &C) == -1);
+    test(external_sort_to(fileno(in), sizeof(struct pair), pair_compare, 16,
+                          pair_check, &C) == -1);
+    fclose(in);
+
+    return 0;
+}
+
 int main()
 {
     srand((unsigned)time(NULL));
     test_suite_start();
     run_test(test_is_sorted);
     run_test(test_quicksort);
+    run_test(test_quicksort_worst_case);
+    run_test(test_pdqsort);
     run_test(test_mergesort);
+    run_test(test_timsort);
     run_test(test_heapsort);
+    run_test(test_element_sizes);
+    run_test(test_parallel_sorts);
+    run_test(test_radixsort);
+    run_test(test_sortnet);
+    run_test(test_selection);
+    run_test(test_external_sort);
     test_suite_end();
 }
@@ -4,6 +4,7 @@
 #include "test.h"
 #include "str.h"
 #include "type_interface.h"
+#include "vector.h"
 
 static int rc;
 
@@ -204,6 +205,66 @@ int test_string_type_interface(void)
     return 0;
 }
 
+/* Paths with a long common prefix and random tails of random lengths, some of them empty, some
+ * of them prefixes of others. */
+static void make_path(char *buffer, size_t i)
+{
+    size_t n = sprintf(buffer, "/usr/share/doc/%s/", i % 3 ? "libdsa" : "libdsa-dev");
+    size_t tail = (size_t)rand() % 30;
+    for (size_t j = 0; j < tail; ++j) buffer[n++] = (char)('a' + rand() % 3);
+    buffer[n] = '\0';
+    if (i % 50 == 0) buffer[0] = '\0';
+}
+
+static int cstr_compare(const void *a, const void *b)
+{
+    return strcmp(*(char**)a, *(char**)b);
+}
+
+int test_string_sort(void)
+{
+    size_t n = 5000;
+    char buffer[64];
+
+    vector V;
+    rc = vector_initialize(&V, &str_type);
+    test(rc == 0);
+    char **C = malloc(n * sizeof(*C));
+    char **D = malloc(n * sizeof(*D));
+    test(C && D);
+
+    for (size_t i = 0; i < n; ++i) {
+        make_path(buffer, i);
+        str *s = str_from_cstr(buffer);
+        test(s);
+        rc = vector_push_back(&V, s);
+        test(rc == 1);
+        str_delete(s);
+        C[i] = D[i] = strdup(buffer);
+        test(C[i]);
+    }
+
+    rc = str_sort((str*)V.data, vector_count(&V));
+    test(rc == 0);
+    for (size_t i = 1; i < n; ++i) {
+        test(str_compare(vector_get(&V, i - 1), vector_get(&V, i)) <= 0);
+    }
+
+    rc = cstr_sort(C, n);
+    test(rc == 0);
+    qsort(D, n, sizeof(*D), cstr_compare);
+    for (size_t i = 0; i < n; ++i) {
+        test(strcmp(C[i], D[i]) == 0);
+        test(strcmp(C[i], str_data((str*)vector_get(&V, i))) == 0);
+    }
+
+    for (size_t i = 0; i < n; ++i) free(C[i]);
+    free(C);
+    free(D);
+    vector_destroy(&V);
+    return 0;
+}
+
 int main(void)
 {
     test_suite_start();
@@ -217,5 +278,6 @@ int main(void)
     run_test(test_string_allocation);
     run_test(test_string_hash);
     run_test(test_string_type_interface);
+    run_test(test_string_sort);
     test_suite_end();
 }
@@ -0,0 +1,143 @@
+#include <stdlib.h>
+
+#include "bst.h"
+#include "test.h"
+#include "typed.h"
+
+DSA_DEFINE_VECTOR(ivec, int)
+DSA_DEFINE_SORT(isort, int, DSA_LESS)
+DSA_DEFINE_HASHMAP(imap, int, int, dsa_hash_int, DSA_EQUAL)
+DSA_DEFINE_BST_LOOKUP(ibst, int, DSA_COMPARE)
+
+#define N 10000
+
+int test_typed_vector(void)
+{
+    ivec V;
+    int rc = ivec_initialize(&V);
+    test(rc == 0);
+    test(V.capacity == DSA_VECTOR_MIN_CAPACITY);
+
+    for (int i = 0; i < N; ++i) {
+        rc = ivec_push_back(&V, i);
+        test(rc == 1);
+    }
+    test(V.count == N);
+    test(*ivec_get(&V, N - 1) == N - 1);
+    test(ivec_get(&V, N) == NULL);
+
+    rc = ivec_insert(&V, 0, -1);
+    test(rc == 1);
+    test(V.data[0] == -1 && V.data[1] == 0);
+
+    rc = ivec_remove(&V, 0);
+    test(rc == 1);
+    test(V.data[0] == 0);
+
+    int out;
+    rc = ivec_pop_back(&V, &out);
+    test(rc == 1);
+    test(out == N - 1);
+
+    ivec_destroy(&V);
+    test(V.data == NULL);
+    return 0;
+}
+
+int test_typed_sort(void)
+{
+    int *A = malloc(N * sizeof(*A));
+    test(A != NULL);
+
+    for (size_t n = 0; n < N; n = 2 * n + 1) {
+        for (size_t i = 0; i < n; ++i) A[i] = rand() % 100;
+        isort(A, n);
+        for (size_t i = 1; i < n; ++i) test(A[i - 1] <= A[i]);
+    }
+
+    /* Sorted and reverse sorted input. */
+    for (int i = 0; i < N; ++i) A[i] = i;
+    isort(A, N);
+    for (int i = 0; i < N; ++i) test(A[i] == i);
+    for (int i = 0; i < N; ++i) A[i] = N - i;
+    isort(A, N);
+    for (int i = 0; i < N; ++i) test(A[i] == i + 1);
+
+    free(A);
+    return 0;
+}
+
+int test_typed_hashmap(void)
+{
+    imap M;
+    int rc = imap_initialize(&M);
+    test(rc == 0);
+
+    for (int i = 0; i < N; ++i) {
+        rc = imap_set(&M, i, -i);
+        test(rc == 1);
+    }
+    test(M.count == N);
+
+    rc = imap_set(&M, 1, 42);
+    test(rc == 0);
+    test(*imap_get(&M, 1) == 42);
+
+    for (int i = 0; i < N; i += 2) {
+        rc = imap_remove(&M, i);
+        test(rc == 1);
+    }
+    rc = imap_remove(&M, 0);
+    test(rc == 0);
+    test(M.count == N / 2);
+
+    for (int i = 3; i < N; ++i) {
+        int *v = imap_get(&M, i);
+        if (i % 2) {
+            test(v && *v == -i);
+        } else {
+            test(v == NULL);
+            test(!imap_has(&M, i));
+        }
+    }
+
+    imap_clear(&M);
+    test(M.count == 0);
+    test(!imap_has(&M, 1));
+
+    imap_destroy(&M);
+    return 0;
+}
+
+int test_typed_bst_lookup(void)
+{
+    bst T;
+    int rc = bst_initialize(&T, RB, &int_type, &int_type);
+    test(rc == 0);
+
+    for (int i = 0; i < 1000; i += 2) {
+        rc = bst_set(&T, &i, &i);
+        test(rc == 1);
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        test(ibst_has(&T, i) == !(i % 2));
+    }
+
+    int *v = ibst_get(&T, 500);
+    test(v && *v == 500);
+    test(ibst_get(&T, 501) == NULL);
+
+    bst_destroy(&T);
+    return 0;
+}
+
+int main(void)
+{
+    test_suite_start();
+    run_test(test_typed_vector);
+    run_test(test_typed_sort);
+    run_test(test_typed_hashmap);
+    run_test(test_typed_bst_lookup);
+    test_suite_end();
+}
@@ -127,6 +127,61 @@ int test_vector_of_strings(void)
     return 0;
 }
 
+static int n_moves;
+
+static void counting_int_move(void *dest, void *src)
+{
+    ++n_moves;
+    *(int*)dest = *(int*)src;
+}
+
+static t_intf counting_int_type = {
+    .size = sizeof(int),
+    .move = counting_int_move,
+    .compare = int_compare
+};
+
+int test_vector_relocation(void)
+{
+    int *vp;
+
+    /* Without the trait, elements are shifted one by one through the move callback. */
+    V = vector_new(&counting_int_type);
+    test(V != NULL);
+    for (int i = 0; i < 100; ++i) vector_push_back(V, &i);
+
+    n_moves = 0;
+    int k = -1;
+    vector_insert(V, 0, &k);
+    test(n_moves == 100);
+    vector_remove(V, 0);
+    test(n_moves == 200);
+
+    for (size_t i = 0; i < 100; ++i) {
+        vp = vector_get(V, i);
+        test(*vp == (int)i);
+    }
+    vector_delete(V);
+
+    /* With it, the callback is never called. */
+    counting_int_type.traits = T_TRIVIALLY_RELOCATABLE;
+    V = vector_new(&counting_int_type);
+    test(V != NULL);
+    for (int i = 0; i < 100; ++i) vector_push_back(V, &i);
+
+    n_moves = 0;
+    vector_insert(V, 50, &k);
+    vector_remove(V, 0);
+    test(n_moves == 0);
+    test(*(int*)vector_get(V, 49) == -1);
+    test(*(int*)vector_get(V, 50) == 50);
+    test(*(int*)vector_last(V) == 99);
+
+    vector_delete(V);
+    counting_int_type.traits = 0;
+    return 0;
+}
+
 int main(void)
 {
     test_suite_start();
@@ -134,5 +189,6 @@ int main(void)
     run_test(test_vector_usage);
     run_test(test_vector_teardown);
     run_test(test_vector_of_strings);
+    run_test(test_vector_relocation);
     test_suite_end();
 }